@@ -0,0 +1,31 @@
+# Command line driver running scenario files with the core library
+
+TEMPLATE = app
+TARGET = GenELCBatch
+CONFIG += console c++11
+CONFIG -= qt app_bundle
+DEFINES += HEADLESS
+
+INCLUDEPATH += $$PWD/..
+
+SOURCES += \
+    main.cpp \
+    Scenario.cpp
+
+HEADERS += \
+    Scenario.hpp
+
+DISTFILES += \
+    scenarios/propagate.txt \
+    scenarios/montecarlo.txt \
+    scenarios/od.txt \
+    scenarios/transfer.txt \
+    scenarios/parareal.txt \
+    scenarios/periodic.txt
+
+LIBS += -L$$OUT_PWD/../Core -lGenELCCore
+PRE_TARGETDEPS += $$OUT_PWD/../Core/libGenELCCore.a
+unix: LIBS += -lpthread
+
+# same switch as for the GUI build
+native_simd:!win32: QMAKE_CXXFLAGS_RELEASE += -O3 -march=native -fno-math-errno
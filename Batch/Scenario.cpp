@@ -0,0 +1,95 @@
+#include "Scenario.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <vector>
+
+static std::string Trim(const std::string& s)
+{
+    size_t first = s.find_first_not_of(" \t\r");
+    if (first == std::string::npos)
+    {
+        return "";
+    }
+    size_t last = s.find_last_not_of(" \t\r");
+    return s.substr(first, last-first+1);
+}
+
+int Scenario::Load(const std::string& filename)
+{
+    std::ifstream in(filename);
+    if (!in)
+    {
+        std::cerr << "cannot open scenario " << filename << std::endl;
+        return 1;
+    }
+    std::string line;
+    int number = 0;
+    while (std::getline(in, line))
+    {
+        number++;
+        line = Trim(line.substr(0, line.find('#')));
+        if (line.empty())
+        {
+            continue;
+        }
+        size_t eq = line.find('=');
+        if (eq == std::string::npos || eq == 0)
+        {
+            std::cerr << filename << ":" << number << ": expected key = value" << std::endl;
+            return 1;
+        }
+        values_[Trim(line.substr(0, eq))] = Trim(line.substr(eq+1));
+    }
+    return 0;
+}
+
+bool Scenario::Has(const std::string& key) const
+{
+    return values_.count(key) > 0;
+}
+
+std::string Scenario::GetString(const std::string& key, const std::string& fallback) const
+{
+    std::map<std::string, std::string>::const_iterator it = values_.find(key);
+    return it == values_.end() ? fallback : it->second;
+}
+
+double Scenario::GetDouble(const std::string& key, double fallback) const
+{
+    std::map<std::string, std::string>::const_iterator it = values_.find(key);
+    return it == values_.end() ? fallback : atof(it->second.c_str());
+}
+
+long Scenario::GetLong(const std::string& key, long fallback) const
+{
+    std::map<std::string, std::string>::const_iterator it = values_.find(key);
+    return it == values_.end() ? fallback : atol(it->second.c_str());
+}
+
+int Scenario::GetVector(const std::string& key, Eigen::VectorXd& v) const
+{
+    std::map<std::string, std::string>::const_iterator it = values_.find(key);
+    if (it == values_.end())
+    {
+        return 1;
+    }
+    std::string s = it->second;
+    std::replace(s.begin(), s.end(), ',', ' ');
+    std::istringstream in(s);
+    std::vector<double> values;
+    double value;
+    while (in >> value)
+    {
+        values.push_back(value);
+    }
+    if (!in.eof() || values.empty())
+    {
+        return 1;
+    }
+    v = Eigen::Map<Eigen::VectorXd>(values.data(), values.size());
+    return 0;
+}
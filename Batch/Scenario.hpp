@@ -0,0 +1,33 @@
+#ifndef SCENARIO_H
+#define SCENARIO_H
+
+#include <map>
+#include <string>
+#include "Eigen/Dense"
+
+/* Scenario file of the batch driver, one "key = value" per line.  Everything
+ * after a '#' is a comment, vectors are given as whitespace or comma separated
+ * numbers, e.g.
+ *
+ *   mode = propagate
+ *   solver = encke
+ *   state = 757.7 5222.607 4851.5 2.21321 4.67834 -5.37130
+ *   duration = 86400
+ */
+class Scenario
+{
+private:
+    std::map<std::string, std::string> values_;
+public:
+    // returns 1 if the file cannot be read or a line is not a key/value pair, 0 otherwise
+    int Load(const std::string& filename);
+
+    bool Has(const std::string& key) const;
+    std::string GetString(const std::string& key, const std::string& fallback) const;
+    double GetDouble(const std::string& key, double fallback) const;
+    long GetLong(const std::string& key, long fallback) const;
+    // returns 1 if the key is missing or not a list of numbers
+    int GetVector(const std::string& key, Eigen::VectorXd& v) const;
+};
+
+#endif // SCENARIO_H
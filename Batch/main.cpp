@@ -0,0 +1,729 @@
+/* Batch driver of the numerical core, runs one scenario file without the GUI:
+ *
+ *   GenELCBatch scenario.txt
+ *
+ * mode = propagate     single propagation of the SatelliteSolver dynamics,
+ *                      the state every output_step is written as CSV
+ * mode = montecarlo    dispersed initial states and drag coefficients
+ *                      propagated on a thread pool (MonteCarloCampaign)
+ * mode = parareal      one long propagation split into time slices that are
+ *                      propagated in parallel (PararealPropagator)
+ * mode = od            orbit determination runs of the EKF against range and
+ *                      range rate from the three tracking stations
+ * mode = transfer      minimum time transfers between circular orbits for a
+ *                      list of thrust levels (MinimumTimeTransfer, or
+ *                      LowThrustTransfer with method = direct)
+ * mode = periodic      a family of Lyapunov, halo or distant retrograde
+ *                      orbits of the Earth-Moon CR3BP (PeriodicOrbitFinder)
+ *
+ * See Batch/scenarios for the keys of each mode and their defaults.
+ */
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+
+#include "Eigen/Dense"
+#include "Scenario.hpp"
+#include "Nums/SatelliteSolver.hpp"
+#include "Nums/GroundTrackingSolver.hpp"
+#include "Nums/AdamsBashforthMoultonSolver.hpp"
+#include "Nums/GaussJacksonSolver.hpp"
+#include "Nums/RosenbrockSolver.hpp"
+#include "Nums/EnckeSolver.hpp"
+#include "Nums/TaylorSolver.hpp"
+#include "Nums/MonteCarloCampaign.hpp"
+#include "Nums/PararealPropagator.hpp"
+#include "Nums/ThreadPool.hpp"
+#include "Kalman/OrbitDeterminationEKF.hpp"
+#include "Orbital/MinimumTimeTransfer.hpp"
+#include "Orbital/LowThrustTransfer.hpp"
+#include "Orbital/PeriodicOrbitFinder.hpp"
+
+const double omega_E = 2*M_PI/86164;
+
+/* Propagator for the 9 component SatelliteSolver state [pos, vel, mu, J2, C_D]
+ * built from the scenario keys solver, step, order and tolerance.
+ */
+class Propagator
+{
+private:
+    SatelliteSolver system_;
+    std::unique_ptr<AbstractOdeSolver> wrapper_;
+    std::unique_ptr<EnckeSolver> encke_;
+    TaylorSolver* taylor_ = nullptr;
+    std::function<long()> evaluations_;
+    long rk4_steps_ = 0;
+    double step_ = 0;
+public:
+    // returns 1 for an unknown solver
+    int Setup(const Scenario& scenario, Eigen::VectorXd& x)
+    {
+        std::string solver = scenario.GetString("solver", "rk4");
+        double step = scenario.GetDouble("step", solver == "encke" ? 60 : 10);
+        if (solver == "encke")
+        {
+            encke_.reset(new EnckeSolver);
+            encke_->InitialConditions(x, step);
+            encke_->SetStepSize(step);
+            EnckeSolver* encke = encke_.get();
+            evaluations_ = [encke]() { return encke->rhs_evaluations(); };
+            return 0;
+        }
+
+        system_.InitialConditions(x, step);
+        system_.SetStepSize(step);
+        step_ = step;
+        if (solver == "rk4")
+        {
+            // the solver does not count its steps, four evaluations each
+            evaluations_ = [this]() { return 4*rk4_steps_; };
+        }
+        else if (solver == "abm")
+        {
+            AdamsBashforthMoultonSolver* abm =
+                    new AdamsBashforthMoultonSolver(system_, static_cast<int>(scenario.GetLong("order", 8)));
+            wrapper_.reset(abm);
+            evaluations_ = [abm]() { return abm->rhs_evaluations(); };
+        }
+        else if (solver == "gj")
+        {
+            GaussJacksonSolver* gj = new GaussJacksonSolver(system_);
+            wrapper_.reset(gj);
+            evaluations_ = [gj]() { return gj->rhs_evaluations(); };
+        }
+        else if (solver == "rosenbrock")
+        {
+            RosenbrockSolver* ros = new RosenbrockSolver(system_);
+            double tol = scenario.GetDouble("tolerance", 1e-9);
+            ros->SetTolerances(tol, tol);
+            wrapper_.reset(ros);
+            evaluations_ = [ros]() { return ros->rhs_evaluations(); };
+        }
+        else if (solver == "taylor")
+        {
+            taylor_ = new TaylorSolver(system_, 9);
+            double tol = scenario.GetDouble("tolerance", 1e-15);
+            taylor_->SetTolerances(tol, tol);
+            taylor_->setState(x);
+            wrapper_.reset(taylor_);
+            // one pass over the recorded right hand side per order and step
+            TaylorSolver* taylor = taylor_;
+            evaluations_ = [taylor]() { return taylor->steps()*taylor->order(); };
+        }
+        else
+        {
+            std::cerr << "unknown solver " << solver << std::endl;
+            return 1;
+        }
+        if (wrapper_)
+        {
+            wrapper_->SetStepSize(step);
+        }
+        return 0;
+    }
+
+    void UpdateState(double dt)
+    {
+        if (encke_)
+        {
+            encke_->UpdateState(dt);
+        }
+        else if (wrapper_)
+        {
+            wrapper_->UpdateState(dt);
+        }
+        else
+        {
+            system_.UpdateState(dt);
+            rk4_steps_ += static_cast<long>(std::ceil(dt/step_ - 1e-9));
+        }
+    }
+
+    void getState(Eigen::VectorXd& x)
+    {
+        if (encke_)
+        {
+            encke_->getState(x);
+        }
+        else if (taylor_)
+        {
+            taylor_->getState(x);
+        }
+        else
+        {
+            system_.getState(x);
+        }
+    }
+
+    // right hand side evaluations so far
+    long rhs_evaluations() const
+    {
+        return evaluations_();
+    }
+};
+
+// initial state from the scenario, the default orbit of SatelliteSolver if not given;
+// 6 components are completed with the default mu, J2 and C_D
+static int InitialState(const Scenario& scenario, Eigen::VectorXd& x)
+{
+    SatelliteSolver defaults;
+    defaults.InitialConditions();
+    defaults.getState(x);
+    if (!scenario.Has("state"))
+    {
+        return 0;
+    }
+    Eigen::VectorXd given;
+    if (scenario.GetVector("state", given) || (given.size() != 6 && given.size() != 9))
+    {
+        std::cerr << "state needs 6 or 9 components" << std::endl;
+        return 1;
+    }
+    x.head(given.size()) = given;
+    return 0;
+}
+
+static int Propagate(const Scenario& scenario)
+{
+    Eigen::VectorXd x;
+    if (InitialState(scenario, x))
+    {
+        return 1;
+    }
+    Propagator propagator;
+    if (propagator.Setup(scenario, x))
+    {
+        return 1;
+    }
+    double duration = scenario.GetDouble("duration", 86400);
+    double output_step = scenario.GetDouble("output_step", 60);
+
+    std::string filename = scenario.GetString("output", "propagate.csv");
+    std::ofstream out(filename);
+    if (!out)
+    {
+        std::cerr << "cannot open " << filename << std::endl;
+        return 1;
+    }
+    out.precision(15);
+    out << "t,x,y,z,u,v,w\n";
+
+    auto start = std::chrono::steady_clock::now();
+    double t = 0;
+    while (true)
+    {
+        propagator.getState(x);
+        out << t << "," << x(0) << "," << x(1) << "," << x(2) << ","
+            << x(3) << "," << x(4) << "," << x(5) << "\n";
+        if (t >= duration - 1e-9*output_step)
+        {
+            break;
+        }
+        double dt = std::min(output_step, duration - t);
+        propagator.UpdateState(dt);
+        t += dt;
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    std::cout.precision(12);
+    std::cout << "final state: " << x.head(6).transpose() << std::endl;
+    std::cout << "rhs evaluations: " << propagator.rhs_evaluations() << std::endl;
+    std::cout << "wall time [s]: " << seconds << std::endl;
+    return 0;
+}
+
+static int MonteCarlo(const Scenario& scenario)
+{
+    Eigen::VectorXd x0;
+    if (InitialState(scenario, x0))
+    {
+        return 1;
+    }
+    double duration = scenario.GetDouble("duration", 5900);
+    double sigma_position = scenario.GetDouble("sigma_position", 0.1);
+    double sigma_velocity = scenario.GetDouble("sigma_velocity", 1e-4);
+    double sigma_cd = scenario.GetDouble("sigma_cd", 0.2);
+
+    Eigen::VectorXd nominal = x0;
+    {
+        Propagator propagator;
+        if (propagator.Setup(scenario, nominal))
+        {
+            return 1;
+        }
+        propagator.UpdateState(duration);
+        propagator.getState(nominal);
+    }
+
+    MonteCarloCampaign::RunFunction run = [&](long, std::mt19937_64& rng, Eigen::VectorXd& result)
+    {
+        std::normal_distribution<double> normal(0, 1);
+        Eigen::VectorXd x = x0;
+        for (int i=0; i<3; i++)
+        {
+            x(i) += sigma_position*normal(rng);
+            x(3+i) += sigma_velocity*normal(rng);
+        }
+        x(8) += sigma_cd*normal(rng);
+
+        Propagator propagator;
+        propagator.Setup(scenario, x);
+        propagator.UpdateState(duration);
+        propagator.getState(x);
+        result = x.head(6);
+        return (x.head(3) - nominal.head(3)).norm();
+    };
+
+    ThreadPool pool(static_cast<int>(scenario.GetLong("threads", 0)));
+    MonteCarloCampaign campaign(pool);
+    campaign.SetSeed(scenario.GetLong("seed", 0));
+    campaign.SetOutputPrefix(scenario.GetString("output", "montecarlo"));
+
+    auto start = std::chrono::steady_clock::now();
+    if (campaign.Run(scenario.GetLong("runs", 1000), 6, run))
+    {
+        std::cerr << "cannot write the run files" << std::endl;
+        return 1;
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    std::cout.precision(8);
+    std::cout << "runs: " << campaign.runs() << " on " << pool.size() << " threads" << std::endl;
+    std::cout << "mean final state: " << campaign.mean().transpose() << std::endl;
+    std::cout << "position sigma: " << campaign.covariance().diagonal().head(3).cwiseSqrt().transpose() << std::endl;
+    std::cout << "miss distance mean/50%/99%: " << campaign.mean_miss() << " "
+              << campaign.MissPercentile(0.5) << " " << campaign.MissPercentile(0.99) << std::endl;
+    std::cout << "wall time [s]: " << seconds << std::endl;
+    return 0;
+}
+
+static int Parareal(const Scenario& scenario)
+{
+    Eigen::VectorXd x0;
+    if (InitialState(scenario, x0))
+    {
+        return 1;
+    }
+    double duration = scenario.GetDouble("duration", 30*86400.0);
+    {
+        // checks the solver keys once before the workers use them
+        Propagator propagator;
+        Eigen::VectorXd x = x0;
+        if (propagator.Setup(scenario, x))
+        {
+            return 1;
+        }
+    }
+
+    std::string coarse_model = scenario.GetString("coarse", "encke");
+    double coarse_step = scenario.GetDouble("coarse_step", 600);
+    PararealPropagator::Propagator coarse;
+    if (coarse_model == "kepler_j2")
+    {
+        // analytic, no drag; the along track sensitivity is too rough to
+        // converge in few iterations over many slices
+        coarse = [](double t0, double t1, Eigen::VectorXd& x)
+        {
+            Eigen::Vector3d r = x.head(3);
+            Eigen::Vector3d v = x.segment(3, 3);
+            Omt::j2_secular_transition(r, v, t1 - t0, x(6), x(7), 6378.1363);
+            x.head(3) = r;
+            x.segment(3, 3) = v;
+        };
+    }
+    else if (coarse_model == "encke")
+    {
+        coarse = [coarse_step](double t0, double t1, Eigen::VectorXd& x)
+        {
+            EnckeSolver encke;
+            encke.InitialConditions(x, coarse_step);
+            encke.SetStepSize(coarse_step);
+            encke.UpdateState(t1 - t0);
+            encke.getState(x);
+        };
+    }
+    else
+    {
+        std::cerr << "unknown coarse propagator " << coarse_model << std::endl;
+        return 1;
+    }
+    PararealPropagator::Propagator fine = [&scenario](double t0, double t1, Eigen::VectorXd& x)
+    {
+        Propagator propagator;
+        propagator.Setup(scenario, x);
+        propagator.UpdateState(t1 - t0);
+        propagator.getState(x);
+    };
+
+    ThreadPool pool(static_cast<int>(scenario.GetLong("threads", 0)));
+    PararealPropagator parareal(pool, coarse, fine);
+    parareal.SetSlices(static_cast<int>(scenario.GetLong("slices", pool.size())));
+    parareal.SetTolerance(scenario.GetDouble("defect_tolerance", 1e-6));
+    parareal.SetMaxIterations(static_cast<int>(scenario.GetLong("max_iterations", 0)));
+
+    auto start = std::chrono::steady_clock::now();
+    Eigen::VectorXd x = x0;
+    int not_converged = parareal.Propagate(0, duration, x);
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    std::string filename = scenario.GetString("output", "parareal.csv");
+    std::ofstream out(filename);
+    if (!out)
+    {
+        std::cerr << "cannot open " << filename << std::endl;
+        return 1;
+    }
+    out.precision(15);
+    out << "t,x,y,z,u,v,w\n";
+    for (unsigned int n=0; n<parareal.states().size(); n++)
+    {
+        const Eigen::VectorXd& s = parareal.states()[n];
+        out << parareal.times()[n] << "," << s(0) << "," << s(1) << "," << s(2) << ","
+            << s(3) << "," << s(4) << "," << s(5) << "\n";
+    }
+
+    std::cout.precision(12);
+    std::cout << "final state: " << x.head(6).transpose() << std::endl;
+    std::cout << "slices: " << parareal.times().size() - 1 << " on " << pool.size() << " threads" << std::endl;
+    std::cout << "iterations: " << parareal.iterations() << (not_converged ? " (not converged)" : "")
+              << ", defect " << parareal.defect() << std::endl;
+    std::cout << "fine propagations: " << parareal.fine_propagations() << std::endl;
+    std::cout << "wall time [s]: " << seconds << std::endl;
+
+    if (scenario.GetLong("sequential", 0))
+    {
+        start = std::chrono::steady_clock::now();
+        Eigen::VectorXd y = x0;
+        fine(0, duration, y);
+        seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        std::cout << "sequential position difference [km]: " << (x.head(3) - y.head(3)).norm() << std::endl;
+        std::cout << "sequential wall time [s]: " << seconds << std::endl;
+    }
+    return 0;
+}
+
+// range and range rate of the satellite from the three stations in the 18
+// component GroundTrackingSolver state, same model as OrbitDeterminationEKF::UpdateEKF
+static void StationMeasurements(const Eigen::VectorXd& x, OrbitDeterminationEKF::MeasurementVector& z)
+{
+    for (int s=0; s<3; s++)
+    {
+        double dx = x(0)-x(9+3*s);
+        double dy = x(1)-x(10+3*s);
+        double dz = x(2)-x(11+3*s);
+        double range = sqrt(dx*dx + dy*dy + dz*dz);
+        z(2*s) = range;
+        z(2*s+1) = (dx*(x(3)+x(10+3*s)*omega_E) + dy*(x(4)-x(9+3*s)*omega_E) + dz*x(5))/range;
+    }
+}
+
+static int OrbitDetermination(const Scenario& scenario)
+{
+    double duration = scenario.GetDouble("duration", 600);
+    double interval = scenario.GetDouble("measurement_interval", 10);
+    double filter_step = scenario.GetDouble("step", 1);
+    double sigma_range = scenario.GetDouble("sigma_range", 0.01);
+    double sigma_range_rate = scenario.GetDouble("sigma_range_rate", 1e-4);
+    double sigma_position = scenario.GetDouble("sigma_position", 1);
+    double sigma_velocity = scenario.GetDouble("sigma_velocity", 1e-3);
+    // prior uncertainty of the estimated parameters and station coordinates
+    double sigma_mu = scenario.GetDouble("sigma_mu", 1);
+    double sigma_j2 = scenario.GetDouble("sigma_j2", 1e-6);
+    double sigma_cd = scenario.GetDouble("sigma_cd", 0.1);
+    double sigma_station = scenario.GetDouble("sigma_station", 1e-3);
+    int steps = static_cast<int>(std::round(duration/interval));
+
+    // the truth is the same for all runs, only the noise and the initial error differ
+    std::vector<Eigen::VectorXd> truth(steps+1);
+    {
+        GroundTrackingSolver simulator;
+        simulator.SetAnalyticStations(true);
+        simulator.InitialConditions();
+        simulator.SetStepSize(scenario.GetDouble("truth_step", 0.1));
+        simulator.getState(truth[0]);
+        for (int k=1; k<=steps; k++)
+        {
+            simulator.UpdateState(interval);
+            simulator.getState(truth[k]);
+        }
+    }
+
+    OrbitDeterminationEKF::MeasurementCovariance R = OrbitDeterminationEKF::MeasurementCovariance::Zero();
+    for (int s=0; s<3; s++)
+    {
+        R(2*s, 2*s) = sigma_range*sigma_range;
+        R(2*s+1, 2*s+1) = sigma_range_rate*sigma_range_rate;
+    }
+
+    MonteCarloCampaign::RunFunction run = [&](long, std::mt19937_64& rng, Eigen::VectorXd& result)
+    {
+        std::normal_distribution<double> normal(0, 1);
+        OrbitDeterminationEKF::StateMatrix P =
+                sigma_station*sigma_station*OrbitDeterminationEKF::StateMatrix::Identity();
+        for (int i=0; i<3; i++)
+        {
+            P(i, i) = sigma_position*sigma_position;
+            P(3+i, 3+i) = sigma_velocity*sigma_velocity;
+        }
+        P(6, 6) = sigma_mu*sigma_mu;
+        P(7, 7) = sigma_j2*sigma_j2;
+        P(8, 8) = sigma_cd*sigma_cd;
+        // the filter starts from a dispersed orbit
+        OrbitDeterminationEKF::StateVector x0 = truth[0];
+        for (int i=0; i<3; i++)
+        {
+            x0(i) += sigma_position*normal(rng);
+            x0(3+i) += sigma_velocity*normal(rng);
+        }
+        OrbitDeterminationEKF ekf;
+        ekf.Init(x0, P, R, OrbitDeterminationEKF::StateMatrix::Zero());
+        ekf.simulator.SetStepSize(filter_step);
+
+        OrbitDeterminationEKF::MeasurementVector z;
+        for (int k=1; k<=steps; k++)
+        {
+            ekf.Predict(interval);
+            StationMeasurements(truth[k], z);
+            for (int s=0; s<3; s++)
+            {
+                z(2*s) += sigma_range*normal(rng);
+                z(2*s+1) += sigma_range_rate*normal(rng);
+            }
+            ekf.UpdateEKF(z);
+        }
+        result = ekf.x_.head(6) - truth[steps].head(6);
+        return result.head(3).norm();
+    };
+
+    ThreadPool pool(static_cast<int>(scenario.GetLong("threads", 0)));
+    MonteCarloCampaign campaign(pool);
+    campaign.SetSeed(scenario.GetLong("seed", 0));
+    campaign.SetOutputPrefix(scenario.GetString("output", "od"));
+
+    auto start = std::chrono::steady_clock::now();
+    if (campaign.Run(scenario.GetLong("runs", 100), 6, run))
+    {
+        std::cerr << "cannot write the run files" << std::endl;
+        return 1;
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    std::cout.precision(8);
+    std::cout << "runs: " << campaign.runs() << " on " << pool.size() << " threads" << std::endl;
+    std::cout << "mean final error: " << campaign.mean().transpose() << std::endl;
+    std::cout << "final position error mean/50%/99%: " << campaign.mean_miss() << " "
+              << campaign.MissPercentile(0.5) << " " << campaign.MissPercentile(0.99) << std::endl;
+    std::cout << "wall time [s]: " << seconds << std::endl;
+    return 0;
+}
+
+// solves one transfer with either method, muting the iterations it reports on std::cout
+template <class TransferSolver>
+static int SolveTransfer(TransferSolver& transfer, int nodes, double& seconds)
+{
+    transfer.SetNodes(nodes);
+    auto start = std::chrono::steady_clock::now();
+    int status = transfer.Solve();
+    seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return status;
+}
+
+static int Transfer(const Scenario& scenario)
+{
+    double mu = scenario.GetDouble("mu", 398600.4418);
+    double r0 = scenario.GetDouble("r0", 6678);
+    double rf = scenario.GetDouble("rf", 42164);
+    double mass_flow = scenario.GetDouble("mass_flow", 0);
+    std::string method = scenario.GetString("method", "indirect");
+    if (method != "indirect" && method != "direct")
+    {
+        std::cerr << "unknown method " << method << std::endl;
+        return 1;
+    }
+    Eigen::VectorXd accel;
+    if (scenario.GetVector("accel", accel))
+    {
+        std::cerr << "accel must list thrust accelerations in km/s^2" << std::endl;
+        return 1;
+    }
+
+    std::string filename = scenario.GetString("output", "transfer.csv");
+    std::ofstream out(filename);
+    if (!out)
+    {
+        std::cerr << "cannot open " << filename << std::endl;
+        return 1;
+    }
+    out.precision(15);
+    out << "accel,t,r,u,v,thrust_angle\n";
+
+    std::cout.precision(8);
+    std::cout << "accel [km/s^2], transfer time [s], revolutions, wall time [s]" << std::endl;
+    int nodes = scenario.GetLong("nodes", 0);
+    int failures = 0;
+    for (int k=0; k<accel.size(); k++)
+    {
+        double seconds;
+        int status;
+        double transfer_time, sweep_angle;
+        Eigen::MatrixXd trajectory;
+        if (method == "direct")
+        {
+            LowThrustTransfer transfer(mu, r0, rf, accel(k), mass_flow);
+            transfer.SetPerturbations(scenario.GetDouble("J2", 0), scenario.GetDouble("C_D", 0));
+            status = SolveTransfer(transfer, nodes, seconds);
+            transfer_time = transfer.transfer_time();
+            sweep_angle = transfer.sweep_angle();
+            trajectory = transfer.trajectory();
+        }
+        else
+        {
+            MinimumTimeTransfer transfer(mu, r0, rf, accel(k), mass_flow);
+            status = SolveTransfer(transfer, nodes, seconds);
+            transfer_time = transfer.transfer_time();
+            sweep_angle = transfer.sweep_angle();
+            trajectory = transfer.trajectory();
+        }
+        if (status)
+        {
+            std::cout << accel(k) << ", failed" << std::endl;
+            failures++;
+            continue;
+        }
+        std::cout << accel(k) << ", " << transfer_time << ", "
+                  << sweep_angle/(2*M_PI) << ", " << seconds << std::endl;
+        for (int i=0; i<trajectory.rows(); i++)
+        {
+            out << accel(k);
+            for (int j=0; j<trajectory.cols(); j++)
+            {
+                out << "," << trajectory(i, j);
+            }
+            out << "\n";
+        }
+    }
+    return failures > 0;
+}
+
+static void WriteOrbits(std::ostream& out, const char* name, const std::vector<PeriodicOrbitFinder::Orbit>& family)
+{
+    for (const PeriodicOrbitFinder::Orbit& orbit : family)
+    {
+        out << name << "," << orbit.state(0) << "," << orbit.state(2) << "," << orbit.state(4) << ","
+            << orbit.period << "," << orbit.jacobi << "," << orbit.stability << "," << orbit.vertical_stability << "\n";
+    }
+}
+
+static int PeriodicOrbits(const Scenario& scenario)
+{
+    PeriodicOrbitFinder finder(scenario.GetDouble("mass_ratio", 0.012150585609624));
+    finder.SetTolerance(scenario.GetDouble("tolerance", 1e-10));
+    std::string family_name = scenario.GetString("family", "lyapunov");
+    int point = static_cast<int>(scenario.GetLong("point", 1));
+    double amplitude = scenario.GetDouble("amplitude", 0.01);
+    double step = scenario.GetDouble("step", -0.001);
+    int count = static_cast<int>(scenario.GetLong("orbits", 200));
+
+    auto start = std::chrono::steady_clock::now();
+    std::vector<PeriodicOrbitFinder::Orbit> planar, halo;
+    int ended = 0;
+    if (family_name == "lyapunov" || family_name == "halo")
+    {
+        int lyapunov_count = family_name == "halo" ? static_cast<int>(scenario.GetLong("lyapunov_orbits", 100)) : count;
+        ended = finder.Continue(finder.LyapunovGuess(point, amplitude), PeriodicOrbitFinder::X0, step,
+                                lyapunov_count, planar);
+        if (family_name == "halo")
+        {
+            PeriodicOrbitFinder::Orbit first;
+            if (finder.HaloFromBifurcation(planar, scenario.GetDouble("z0", 0.001), first))
+            {
+                std::cerr << "no halo bifurcation along " << planar.size() << " Lyapunov orbits" << std::endl;
+                return 1;
+            }
+            ended = finder.Continue(first, PeriodicOrbitFinder::Z0, scenario.GetDouble("halo_step", 0.002),
+                                    count, halo);
+        }
+    }
+    else if (family_name == "dro")
+    {
+        ended = finder.Continue(finder.DroGuess(amplitude), PeriodicOrbitFinder::X0, step, count, planar);
+    }
+    else
+    {
+        std::cerr << "unknown family " << family_name << std::endl;
+        return 1;
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    std::string filename = scenario.GetString("output", "periodic.csv");
+    std::ofstream out(filename);
+    if (!out)
+    {
+        std::cerr << "cannot open " << filename << std::endl;
+        return 1;
+    }
+    out.precision(15);
+    out << "family,x0,z0,vy0,period,jacobi,stability,vertical_stability\n";
+    WriteOrbits(out, family_name == "dro" ? "dro" : "lyapunov", planar);
+    WriteOrbits(out, "halo", halo);
+
+    const std::vector<PeriodicOrbitFinder::Orbit>& family = family_name == "halo" ? halo : planar;
+    std::cout.precision(10);
+    std::cout << "orbits: " << planar.size() + halo.size();
+    if (!family.empty())
+    {
+        std::cout << ", " << family_name << " Jacobi constant " << family.front().jacobi
+                  << " to " << family.back().jacobi;
+    }
+    std::cout << (ended ? " (family ended)" : "") << std::endl;
+    std::cout << "integration steps: " << finder.steps() << std::endl;
+    std::cout << "wall time [s]: " << seconds << std::endl;
+    return 0;
+}
+
+int main(int argc, char *argv[])
+{
+    if (argc != 2)
+    {
+        std::cerr << "usage: " << argv[0] << " scenario" << std::endl;
+        return 2;
+    }
+    Scenario scenario;
+    if (scenario.Load(argv[1]))
+    {
+        return 1;
+    }
+
+    std::string mode = scenario.GetString("mode", "propagate");
+    if (mode == "propagate")
+    {
+        return Propagate(scenario);
+    }
+    else if (mode == "montecarlo")
+    {
+        return MonteCarlo(scenario);
+    }
+    else if (mode == "parareal")
+    {
+        return Parareal(scenario);
+    }
+    else if (mode == "od")
+    {
+        return OrbitDetermination(scenario);
+    }
+    else if (mode == "transfer")
+    {
+        return Transfer(scenario);
+    }
+    else if (mode == "periodic")
+    {
+        return PeriodicOrbits(scenario);
+    }
+    std::cerr << "unknown mode " << mode << std::endl;
+    return 1;
+}
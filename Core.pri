@@ -0,0 +1,106 @@
+# Numerical core shared by the GUI (MyOpenGL.pro) and the headless targets
+# (Headless.pro): ODE/BVP solvers, orbital mechanics and the Kalman filters.
+# None of it depends on Qt when HEADLESS is defined.
+
+INCLUDEPATH += $$PWD
+
+SOURCES += \
+    $$PWD/Kalman/FusionEKF.cpp \
+    $$PWD/Kalman/OrbitDeterminationFilter.cpp \
+    $$PWD/Nums/AbstractOdeSolver.cpp \
+    $$PWD/Nums/AdaptiveRungeKuttaSolver.cpp \
+    $$PWD/Nums/Restricted3BodySolver.cpp \
+    $$PWD/Nums/RungeKuttaSolver.cpp \
+    $$PWD/Nums/RungeKuttaTableau.cpp \
+    $$PWD/Nums/MultistepSolver.cpp \
+    $$PWD/Nums/AdamsBashforthMoultonSolver.cpp \
+    $$PWD/Nums/GaussJacksonSolver.cpp \
+    $$PWD/Nums/TaylorTape.cpp \
+    $$PWD/Nums/TaylorSolver.cpp \
+    $$PWD/Nums/RosenbrockSolver.cpp \
+    $$PWD/Nums/TwoBodySolver.cpp \
+    $$PWD/Nums/EarthRotationSolver.cpp \
+    $$PWD/Nums/GroundTrackingSolver.cpp \
+    $$PWD/Nums/SatelliteSolver.cpp \
+    $$PWD/Nums/EnckeSolver.cpp \
+    $$PWD/Nums/KSSolver.cpp \
+    $$PWD/Nums/KSTwoBodySolver.cpp \
+    $$PWD/Nums/KSRestricted3BodySolver.cpp \
+    $$PWD/Nums/SymplecticSolver.cpp \
+    $$PWD/Nums/SymplecticTwoBodySolver.cpp \
+    $$PWD/Nums/SymplecticRestricted3BodySolver.cpp \
+    $$PWD/Nums/SatelliteEnsemble.cpp \
+    $$PWD/Nums/ThreadPool.cpp \
+    $$PWD/Nums/MonteCarloCampaign.cpp \
+    $$PWD/Nums/PararealPropagator.cpp \
+    $$PWD/Nums/FiniteDifferenceGrid.cpp \
+    $$PWD/Nums/BoundaryValueProblem.cpp \
+    $$PWD/Nums/AlmostBlockDiagonalSolver.cpp \
+    $$PWD/Nums/MultipleShootingSolver.cpp \
+    $$PWD/Nums/PseudoArclengthContinuation.cpp \
+    $$PWD/Nums/DifferentialSystem.cpp \
+    $$PWD/Nums/DirectCollocation.cpp \
+    $$PWD/Orbital/Omt.cpp \
+    $$PWD/Orbital/MinimumTimeTransfer.cpp \
+    $$PWD/Orbital/LowThrustTransfer.cpp \
+    $$PWD/Orbital/PeriodicOrbitFinder.cpp \
+    $$PWD/Kalman/CarFilterTools.cpp \
+    $$PWD/Kalman/OrbitDeterminationEKF.cpp \
+    $$PWD/Kalman/UnscentedKalmanFilter.cpp
+
+HEADERS += \
+    $$PWD/Nums/Vector3D.hpp \
+    $$PWD/Nums/AbstractOdeSolver.hpp \
+    $$PWD/Nums/RungeKuttaSolver.hpp \
+    $$PWD/Nums/RungeKuttaStepper.hpp \
+    $$PWD/Nums/RungeKuttaTableau.hpp \
+    $$PWD/Nums/MultistepSolver.hpp \
+    $$PWD/Nums/AdamsBashforthMoultonSolver.hpp \
+    $$PWD/Nums/GaussJacksonSolver.hpp \
+    $$PWD/Nums/TaylorTape.hpp \
+    $$PWD/Nums/TaylorSolver.hpp \
+    $$PWD/Nums/RosenbrockSolver.hpp \
+    $$PWD/Nums/BoundaryValueProblem.hpp \
+    $$PWD/Nums/AlmostBlockDiagonalSolver.hpp \
+    $$PWD/Nums/MultipleShootingSolver.hpp \
+    $$PWD/Nums/PseudoArclengthContinuation.hpp \
+    $$PWD/Nums/Node.hpp \
+    $$PWD/Nums/DifferentialSystem.hpp \
+    $$PWD/Nums/Dual.hpp \
+    $$PWD/Nums/FiniteDifferenceGrid.hpp \
+    $$PWD/Nums/OptimalControlProblem.hpp \
+    $$PWD/Nums/DirectCollocation.hpp \
+    $$PWD/Orbital/Omt.hpp \
+    $$PWD/Orbital/MinimumTimeTransfer.hpp \
+    $$PWD/Orbital/LowThrustTransfer.hpp \
+    $$PWD/Orbital/PeriodicOrbitFinder.hpp \
+    $$PWD/Kalman/CarFilterTools.hpp \
+    $$PWD/Kalman/MeasurementPackage.hpp \
+    $$PWD/Kalman/GroundTruthPackage.hpp \
+    $$PWD/Kalman/FusionEKF.hpp \
+    $$PWD/Kalman/KalmanFilter.hpp \
+    $$PWD/Kalman/OrbitDeterminationEKF.hpp \
+    $$PWD/Kalman/UnscentedKalmanFilter.hpp \
+    $$PWD/Kalman/OrbitMeasurementPackage.hpp \
+    $$PWD/Kalman/OrbitDeterminationFilter.hpp \
+    $$PWD/Nums/AdaptiveRungeKuttaSolver.hpp \
+    $$PWD/Nums/EarthRotationSolver.hpp \
+    $$PWD/Nums/GroundTrackingSolver.hpp \
+    $$PWD/Nums/Restricted3BodySolver.hpp \
+    $$PWD/Nums/SatelliteSolver.hpp \
+    $$PWD/Nums/EnckeSolver.hpp \
+    $$PWD/Nums/KSSolver.hpp \
+    $$PWD/Nums/KSTwoBodySolver.hpp \
+    $$PWD/Nums/KSRestricted3BodySolver.hpp \
+    $$PWD/Nums/SymplecticSolver.hpp \
+    $$PWD/Nums/SymplecticTwoBodySolver.hpp \
+    $$PWD/Nums/SymplecticRestricted3BodySolver.hpp \
+    $$PWD/Nums/SatelliteEnsemble.hpp \
+    $$PWD/Nums/ThreadPool.hpp \
+    $$PWD/Nums/MonteCarloCampaign.hpp \
+    $$PWD/Nums/PararealPropagator.hpp \
+    $$PWD/Nums/TwoBodySolver.hpp
+
+# qmake CONFIG+=native_simd targets the vector units of the build machine (AVX2/AVX-512),
+# used by the vectorised loops of SatelliteEnsemble
+native_simd:!win32: QMAKE_CXXFLAGS_RELEASE += -O3 -march=native -fno-math-errno
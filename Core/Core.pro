@@ -0,0 +1,9 @@
+# Static library with the numerical core, built without Qt
+
+TEMPLATE = lib
+TARGET = GenELCCore
+CONFIG += staticlib c++11
+CONFIG -= qt
+DEFINES += HEADLESS
+
+include(../Core.pri)
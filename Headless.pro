@@ -0,0 +1,6 @@
+# Headless build of the numerical core and the batch driver, no Qt modules
+# are needed:  qmake Headless.pro && make
+
+TEMPLATE = subdirs
+SUBDIRS = Core Batch
+Batch.depends = Core
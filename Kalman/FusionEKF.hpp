@@ -6,12 +6,14 @@
 #include <vector>
 #include <string>
 #include <fstream>
-#include "KalmanFilter.hpp"
+#include "OrbitDeterminationEKF.hpp"
 #include "UnscentedKalmanFilter.hpp"
 #include "CarFilterTools.hpp"
 
 class FusionEKF {
 public:
+  EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+
   /**
   * Constructor.
   */
@@ -30,7 +32,7 @@ public:
   /**
   * Kalman Filter update and prediction math lives in here.
   */
-  KalmanFilter ekf_;
+  OrbitDeterminationEKF ekf_;
   UKF ukf_;
 protected:
   // check whether the tracking toolbox was initiallized or not (first measurement)
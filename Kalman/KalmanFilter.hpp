@@ -1,33 +1,51 @@
 #ifndef KALMAN_FILTER_H_
 #define KALMAN_FILTER_H_
 #include "Eigen/Dense"
-#include "CarFilterTools.hpp"
-#include "Nums/GroundTrackingSolver.hpp"
 
+/**
+ * Kalman filter with NX states and NZ measurements fixed at compile time, so
+ * that all matrices live inside the object and neither the prediction nor
+ * the update allocates.
+ *
+ * The covariance update is the Joseph form
+ *   P = (I - K H) P (I - K H)^T + K R K^T
+ * which holds for any gain K.  With S = H P H^T + R = L L^T it is carried out
+ * as two symmetric rank M updates of the lower triangle of P,
+ *   P = P - W W^T + E E^T,   W = P H^T L^-T,   E = (P H^T - K S) L^-T,
+ * where K = W L^-1 comes from triangular solves with the Cholesky factor
+ * instead of an inverse of S.  The first update is the optimal one, the
+ * second takes up the round off in K, and P stays symmetric (the upper
+ * triangle is mirrored) and positive definite.
+ */
+template <int NX, int NZ>
 class KalmanFilter {
 public:
+  typedef Eigen::Matrix<double, NX, 1> StateVector;
+  typedef Eigen::Matrix<double, NX, NX> StateMatrix;
+  typedef Eigen::Matrix<double, NZ, 1> MeasurementVector;
+  typedef Eigen::Matrix<double, NZ, NX> MeasurementMatrix;
+  typedef Eigen::Matrix<double, NZ, NZ> MeasurementCovariance;
+
+  EIGEN_MAKE_ALIGNED_OPERATOR_NEW
 
   // state vector
-  Eigen::VectorXd x_;
+  StateVector x_;
 
   // state covariance matrix
-  Eigen::MatrixXd P_;
+  StateMatrix P_;
 
   // state transistion matrix
-  Eigen::MatrixXd F_;
+  StateMatrix F_;
 
   // process covariance matrix
-  Eigen::MatrixXd Q_;
+  StateMatrix Q_;
 
   // measurement matrix
   // will contain the Jacobian for nonlinear measurement model
-  Eigen::MatrixXd H_[3];
+  MeasurementMatrix H_;
 
   // measurement covariance matrix
-  // size 2 array for 2 measurement models
-  Eigen::MatrixXd R_[3];
-
-  GroundTrackingSolver simulator;
+  MeasurementCovariance R_;
 
   /**
    * Constructor
@@ -37,56 +55,121 @@ public:
   /**
    * Destructor
    */
-  virtual ~KalmanFilter();
+  virtual ~KalmanFilter() {}
 
   /**
    * Init Initializes Kalman filter
    * @param x_in Initial state
    * @param P_in Initial state covariance
    * @param F_in Transition matrix
-   * @param H_in[] Array of Measurement matrices (or Jacobians for nonlinear)
-   * @param R_in[] Measurement covariance matrices
+   * @param H_in Measurement matrix (or Jacobian for nonlinear)
+   * @param R_in Measurement covariance matrix
    * @param Q_in Process covariance matrix
    */
-  void Init(Eigen::VectorXd x_in, Eigen::MatrixXd P_in, Eigen::MatrixXd &F_in,
-      Eigen::MatrixXd H_in[3], Eigen::MatrixXd R_in[3], Eigen::MatrixXd Q_in);
+  void Init(const StateVector& x_in, const StateMatrix& P_in, const StateMatrix& F_in,
+      const MeasurementMatrix& H_in, const MeasurementCovariance& R_in, const StateMatrix& Q_in);
 
   /**
    * Prediction Predicts the state and the state covariance
-   * using the process model
+   * using the linear process model x = F x
    */
-  void Predict(double dt);
+  void Predict();
+
+  /**
+   * Predicts the state covariance P = F P F^T + Q with the current F
+   */
+  void PredictCovariance();
 
   /**
    * Updates the state by using standard Kalman Filter equations
    * @param z The measurement at k+1
    */
-  void UpdateKF(const Eigen::VectorXd &z);
+  void UpdateKF(const MeasurementVector& z);
 
   /**
-   * Updates the state by using Extended Kalman Filter equations
-   * @param z The measurement at k+1
+   * Joseph form update for M measurements, also with M other than NZ
+   * @param y The innovation, measurement minus prediction
+   * @param H Measurement matrix (or Jacobian)
+   * @param R Measurement covariance matrix
+   * @return 1 if H P H^T + R is not positive definite (nothing is updated), 0 otherwise
    */
-  void UpdateEKF(const Eigen::VectorXd &z, int sensor);
-  void UpdateEKF(const Eigen::VectorXd &z);
-
-private:
-  // tool object used to compute the Jacobian
-  Tools tools;
-  // common operations for both KF and EKF updates
-  void Update(const Eigen::VectorXd &y, const Eigen::MatrixXd& H, const Eigen::MatrixXd& R);
-
-  // cache pi and 2pi constant values
-  constexpr static const float pi_ = 3.1415926535897932384626433832795f;
-  constexpr static const float _2pi_ = 2.0f * pi_;
-  // cache acceleration noise values for quicker computation
-  constexpr static const int noise_ax = 9;
-  constexpr static const int noise_ay = 9;
-  constexpr static const int NaxT4 = 4*noise_ax;
-  constexpr static const int NaxT2 = 2*noise_ax;
-  constexpr static const int NayT4 = 4*noise_ay;
-  constexpr static const int NayT2 = 2*noise_ay;
-  
+  template <int M>
+  int Update(const Eigen::Matrix<double, M, 1>& y, const Eigen::Matrix<double, M, NX>& H,
+      const Eigen::Matrix<double, M, M>& R);
 };
 
+template <int NX, int NZ>
+KalmanFilter<NX, NZ>::KalmanFilter()
+  : x_(StateVector::Zero()), P_(StateMatrix::Identity()), F_(StateMatrix::Identity()),
+    Q_(StateMatrix::Zero()), H_(MeasurementMatrix::Zero()), R_(MeasurementCovariance::Identity()) {
+}
+
+template <int NX, int NZ>
+void KalmanFilter<NX, NZ>::Init(const StateVector& x_in, const StateMatrix& P_in, const StateMatrix& F_in,
+    const MeasurementMatrix& H_in, const MeasurementCovariance& R_in, const StateMatrix& Q_in) {
+  x_ = x_in;
+  P_ = P_in;
+  F_ = F_in;
+  H_ = H_in;
+  R_ = R_in;
+  Q_ = Q_in;
+}
+
+template <int NX, int NZ>
+void KalmanFilter<NX, NZ>::Predict() {
+  StateVector x = x_;
+  x_.noalias() = F_ * x;
+  PredictCovariance();
+}
+
+template <int NX, int NZ>
+void KalmanFilter<NX, NZ>::PredictCovariance() {
+  StateMatrix FP;
+  FP.noalias() = F_ * P_;
+  P_.noalias() = FP * F_.transpose();
+  P_ += Q_;
+  P_ = P_.template selfadjointView<Eigen::Lower>();
+}
+
+template <int NX, int NZ>
+void KalmanFilter<NX, NZ>::UpdateKF(const MeasurementVector& z) {
+  MeasurementVector y = z;
+  y.noalias() -= H_ * x_;
+  Update<NZ>(y, H_, R_);
+}
+
+template <int NX, int NZ>
+template <int M>
+int KalmanFilter<NX, NZ>::Update(const Eigen::Matrix<double, M, 1>& y, const Eigen::Matrix<double, M, NX>& H,
+    const Eigen::Matrix<double, M, M>& R) {
+  // (P H^T)^T, P is symmetric
+  Eigen::Matrix<double, M, NX> HP;
+  HP.noalias() = H * P_;
+  Eigen::Matrix<double, M, M> S = R;
+  S.noalias() += HP * H.transpose();
+  Eigen::LLT<Eigen::Matrix<double, M, M> > llt(S);
+  if (llt.info() != Eigen::Success) {
+    return 1;
+  }
+
+  // W^T = L^-1 H P and K^T = L^-T W^T
+  Eigen::Matrix<double, M, NX> Wt = HP;
+  llt.matrixL().solveInPlace(Wt);
+  Eigen::Matrix<double, M, NX> Kt = Wt;
+  llt.matrixU().solveInPlace(Kt);
+
+  //new estimate
+  x_.noalias() += Kt.transpose() * y;
+
+  // E^T = L^-1 (H P - S K^T), zero up to the round off in K
+  Eigen::Matrix<double, M, NX> Et = HP;
+  Et.noalias() -= S * Kt;
+  llt.matrixL().solveInPlace(Et);
+
+  P_.template selfadjointView<Eigen::Lower>().rankUpdate(Wt.transpose(), -1);
+  P_.template selfadjointView<Eigen::Lower>().rankUpdate(Et.transpose(), 1);
+  P_ = P_.template selfadjointView<Eigen::Lower>();
+  return 0;
+}
+
 #endif /* KALMAN_FILTER_H_ */
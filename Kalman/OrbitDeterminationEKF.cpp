@@ -0,0 +1,92 @@
+#include "OrbitDeterminationEKF.hpp"
+#include "Nums/Dual.hpp"
+
+const double omega_E = 2*M_PI/86164;
+
+void OrbitDeterminationEKF::Init(const StateVector& x_in, const StateMatrix& P_in,
+                                 const MeasurementCovariance& R_in, const StateMatrix& Q_in) {
+  KalmanFilter<18, 6>::Init(x_in, P_in, StateMatrix::Identity(), MeasurementMatrix::Zero(), R_in, Q_in);
+  // stations are rotated in closed form, only the orbit and its 9x9 STM are integrated
+  simulator.SetAnalyticStations(true);
+  simulator.InitialConditions();
+  simulator.setState(x_);
+}
+
+void OrbitDeterminationEKF::Predict(double dt) {
+  /**
+    * predict the state
+  */
+  simulator.setState(x_);
+  simulator.UpdateState(dt);
+  simulator.getState(x_);
+
+  simulator.getTransitionMatrix(F_);
+  PredictCovariance();
+}
+
+// range and range rate of the satellite p = [pos, vel] seen from a station
+// s on the rotating Earth, whose velocity is omega_E x s
+template <class T>
+static void RangeAndRate(const T* p, const T* s, T& range, T& range_rate) {
+  T dx = p[0]-s[0];
+  T dy = p[1]-s[1];
+  T dz = p[2]-s[2];
+  range = sqrt(dx*dx+dy*dy+dz*dz);
+  range_rate = (dx*(p[3]+omega_E*s[1]) + dy*(p[4]-omega_E*s[0]) + dz*p[5])/range;
+}
+
+// range (and range rate) with the row of the Jacobian H over the orbit and
+// the station, from one forward mode pass seeded on [pos, vel, station]
+static void Measurement(const OrbitDeterminationEKF::StateVector& x, int sensor, Dual<9>* h) {
+  Dual<9> p[6];
+  Dual<9> s[3];
+  for (int i=0; i<6; i++) {
+    p[i] = Dual<9>(x(i), i);
+  }
+  for (int i=0; i<3; i++) {
+    s[i] = Dual<9>(x(9+3*sensor+i), 6+i);
+  }
+  RangeAndRate(p, s, h[0], h[1]);
+}
+
+// scatters the gradient of a measurement from Measurement into row of H
+template <class Derived>
+static void SetJacobianRow(const Dual<9>& h, int sensor, Eigen::MatrixBase<Derived>& H, int row) {
+  H.row(row).setZero();
+  H.template block<1, 6>(row, 0) = h.grad().head<6>().transpose();
+  H.template block<1, 3>(row, 9+3*sensor) = h.grad().tail<3>().transpose();
+}
+
+void OrbitDeterminationEKF::UpdateEKF(const MeasurementVector& z)
+{
+    MeasurementVector y = z;
+    for (unsigned int sensor=0; sensor<3; sensor++) {
+        Dual<9> m[2];
+        Measurement(x_, sensor, m);
+        for (unsigned int k=0; k<2; k++) {
+            y(2*sensor+k) -= m[k].value();
+            SetJacobianRow(m[k], sensor, H_, 2*sensor+k);
+        }
+    }
+    Update<6>(y, H_, R_);
+}
+
+void OrbitDeterminationEKF::UpdateEKF(double z, int sensor) {
+  /**
+    * update the state by using Extended Kalman Filter equations
+  */
+
+  // state to measurement function, the range rate is not used
+  Dual<9> m[2];
+  Measurement(x_, sensor, m);
+  Eigen::Matrix<double, 1, 1> y;
+  y << z - m[0].value();
+
+  //compute the Jacobian matrix
+  Eigen::Matrix<double, 1, 18> H;
+  SetJacobianRow(m[0], sensor, H, 0);
+  Eigen::Matrix<double, 1, 1> R;
+  R << R_(2*sensor, 2*sensor);
+
+  Update<1>(y, H, R);
+}
@@ -0,0 +1,50 @@
+#ifndef ORBIT_DETERMINATION_EKF_H_
+#define ORBIT_DETERMINATION_EKF_H_
+#include "Eigen/Dense"
+#include "KalmanFilter.hpp"
+#include "Nums/GroundTrackingSolver.hpp"
+
+/**
+ * Extended Kalman filter of the 18 component state [x, y, z, u, v, w, mu, J2,
+ * C_D, x_s1, y_s1, z_s1, x_s2, y_s2, z_s2, x_s3, y_s3, z_s3] from the range
+ * and range rate of the three tracking stations.  The state and its
+ * transition matrix are propagated by the GroundTrackingSolver, the
+ * measurement Jacobian comes from forward mode differentiation.
+ */
+class OrbitDeterminationEKF : public KalmanFilter<18, 6> {
+public:
+
+  GroundTrackingSolver simulator;
+
+  /**
+   * Init Initializes the filter and sets the orbit of the simulator
+   * from the initial state
+   * @param x_in Initial state [pos, vel, mu, J2, C_D, three stations]
+   * @param P_in Initial state covariance
+   * @param R_in Measurement covariance of [range, range rate] of the stations
+   * @param Q_in Process covariance matrix
+   */
+  void Init(const StateVector& x_in, const StateMatrix& P_in, const MeasurementCovariance& R_in,
+      const StateMatrix& Q_in);
+
+  /**
+   * Prediction Predicts the state and the state covariance
+   * by integrating the dynamics and the transition matrix over dt
+   */
+  void Predict(double dt);
+
+  /**
+   * Updates the state by using Extended Kalman Filter equations
+   * @param z Range and range rate of the three stations at k+1
+   */
+  void UpdateEKF(const MeasurementVector& z);
+
+  /**
+   * Updates the state with the range of one station only
+   * @param z The range at k+1
+   * @param sensor The station, 0..2
+   */
+  void UpdateEKF(double z, int sensor);
+};
+
+#endif /* ORBIT_DETERMINATION_EKF_H_ */
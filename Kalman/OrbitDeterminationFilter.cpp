@@ -6,66 +6,48 @@ OrbitDeterminationFilter::OrbitDeterminationFilter()
     is_initialized_ = false;
     previous_timestamp_ = 0;
 
-    // NUMSENSORS is 3 for this case corresponding to three tracking stations
-    // affecting the measurement matrix H
-    MatrixXd H_array[NUMSENSORS_];
-    MatrixXd R_array[NUMSENSORS_];
-
-    // initializing matrices
-    H_array[0] = MatrixXd(6, 18);
-    H_array[1] = MatrixXd(1, 18);
-    H_array[2] = MatrixXd(1, 18);
-
-    R_array[0] = MatrixXd(6, 6);
-    R_array[1] = MatrixXd(1, 1);
-    R_array[2] = MatrixXd(1, 1);
-
     // Radar measurement noise standard deviation range in km
     double var_ra_ = 0.001;
     double var_radr_ = 0.001;
 
 
-    // measurement covariance matrices
-    R_array[0] << var_ra_, 0, 0, 0, 0, 0,
+    // measurement covariance of [range, range rate] of the NUMSENSORS_ = 3
+    // tracking stations
+    OrbitDeterminationEKF::MeasurementCovariance R;
+    R << var_ra_, 0, 0, 0, 0, 0,
             0, var_radr_, 0, 0, 0, 0,
             0, 0, var_ra_, 0, 0, 0,
             0, 0, 0, var_radr_, 0, 0,
             0, 0, 0, 0, var_ra_, 0,
             0, 0, 0, 0, 0, var_radr_;
 
-    R_array[1] << var_radr_;
-    R_array[2] << var_radr_;
-
-    // measurement matrices, not used for UKF, comment for Unscented Kalman Filter
-//    H_array[0] << 1, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0;
-
-//    H_array[1] << 1, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0;
-
-//    H_array[2] << 1, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0;
-
     // initialize state [x, y, z, u, v, w, mu, J2, C_D, x_s1, y_s1, z_s1, x_s2, y_s2, z_s2, x_s3, y_s3, z_s3]
     // last 9 elements are the three station locations
-    Eigen::VectorXd x = Eigen::VectorXd::Zero(18);
+    // from the default orbit and stations of the simulator
+    OrbitDeterminationEKF::StateVector x;
+    {
+        GroundTrackingSolver defaults;
+        defaults.InitialConditions();
+        defaults.getState(x);
+    }
     //const double G = 6.67259e-20;
     //const double m1 = 5.974e24;
     //double initmu = G*m1; //3.986004415e5;
     //x << 757.7, 5222.607, 4851.5, 2.21321, 4.67834, -5.37130, initmu, 1.082626925638815e-3, 2, -5127.51, -3794.16, 0.0, 3860.91, 3238.49, 3898.094, 549.505, -1380.872, 6182.197;
 
 
-    // initialize P, F, and Q and the filters
+    // initialize P and Q and the filters
     double uns = 10;
-    MatrixXd P = uns*Eigen::MatrixXd::Identity(18, 18);
+    OrbitDeterminationEKF::StateMatrix P = uns*OrbitDeterminationEKF::StateMatrix::Identity();
     for (unsigned int i=0; i<6; i++)
     {
         P(i,i) = 10;
     }
 
-    MatrixXd F = Eigen::MatrixXd::Zero(18, 18);
-    MatrixXd Q = Eigen::MatrixXd(18, 18);
+    OrbitDeterminationEKF::StateMatrix Q = OrbitDeterminationEKF::StateMatrix::Zero();
 
     // initialize the extended Kalman filter
-    ekf_.Init(x, P, F,
-         H_array, R_array, Q);
+    ekf_.Init(x, P, R, Q);
 
     // initialize the unscented Kalman Filter
     //ukf_.Init(x, P, R_array);
@@ -142,7 +124,7 @@ void OrbitDeterminationFilter::ProcessMeasurement(vector<MeasurementPackage> &me
 
     //std::cout << "received measurement" << std::endl;
     // update based on three stations
-    Eigen::VectorXd z_list = Eigen::VectorXd(6);
+    OrbitDeterminationEKF::MeasurementVector z_list;
     z_list << measurement_pack_list[0].raw_measurements_, measurement_pack_list[1].raw_measurements_, measurement_pack_list[2].raw_measurements_;
 
     ekf_.UpdateEKF(z_list);
@@ -49,37 +49,22 @@ SOURCES += \
     Cst/Cst.cpp \
     Cst/Pfd.cpp \
     Cst/TransferFunction.cpp \
-    Kalman/FusionEKF.cpp \
-    Kalman/OrbitDeterminationFilter.cpp \
-    Nums/AbstractOdeSolver.cpp \
-    Nums/AdaptiveRungeKuttaSolver.cpp \
-    Nums/Restricted3BodySolver.cpp \
-    Nums/RungeKuttaSolver.cpp \
-    Nums/TwoBodySolver.cpp \
-    Nums/EarthRotationSolver.cpp \
-    Nums/GroundTrackingSolver.cpp \
-    Nums/SatelliteSolver.cpp \
-    Nums/FiniteDifferenceGrid.cpp \
-    Nums/BoundaryValueProblem.cpp \
-    Nums/DifferentialSystem.cpp \
     Objects/SimObject.cpp \
     Objects/Controllable.cpp \
     Window.cpp \
     MainViewWidget.cpp \
     Sims/Simulation.cpp \
     Sims/OrbitalSimulation.cpp \
-    Orbital/Omt.cpp \
     main.cpp \
     Objects/Terrain.cpp \
     Objects/Mesh.cpp \
     Objects/Part.cpp \
     Objects/Road.cpp \
     Objects/Satellite.cpp \
-    Kalman/CarFilterTools.cpp \
-    Kalman/KalmanFilter.cpp \
-    Kalman/UnscentedKalmanFilter.cpp \
     Common/Transform3D.cpp
 
+include(Core.pri)
+
 HEADERS  += \
     Common/Camera3D.hpp \
     Common/Control.hpp \
@@ -237,8 +222,6 @@ HEADERS  += \
     glm/vec3.hpp \
     glm/vec4.hpp \
     glm/vector_relational.hpp \
-    Nums/AbstractOdeSolver.hpp \
-    Nums/RungeKuttaSolver.hpp \
     Eigen/src/Cholesky/LDLT.h \
     Eigen/src/Cholesky/LLT.h \
     Eigen/src/Cholesky/LLT_MKL.h \
@@ -526,37 +509,18 @@ HEADERS  += \
     Eigen/SVD \
     Eigen/UmfPackSupport \
     json.hpp \
-    Nums/BoundaryValueProblem.hpp \
-    Nums/Node.hpp \
-    Nums/DifferentialSystem.hpp \
-    Nums/FiniteDifferenceGrid.hpp \
     SimulationInterface.hpp \
     Objects/SimObject.hpp \
     MainViewWidget.hpp \
     Window.hpp \
     Sims/Simulation.hpp \
     Sims/OrbitalSimulation.hpp \
-    Orbital/Omt.hpp \
     Objects/Terrain.hpp \
     Objects/Controllable.hpp \
     Objects/Mesh.hpp \
     Objects/Part.hpp \
     Objects/Road.hpp \
     Objects/Satellite.hpp \
-    Kalman/CarFilterTools.hpp \
-    Kalman/MeasurementPackage.hpp \
-    Kalman/GroundTruthPackage.hpp \
-    Kalman/FusionEKF.hpp \
-    Kalman/KalmanFilter.hpp \
-    Kalman/UnscentedKalmanFilter.hpp \
-    Kalman/OrbitMeasurementPackage.hpp \
-    Kalman/OrbitDeterminationFilter.hpp \
-    Nums/AdaptiveRungeKuttaSolver.hpp \
-    Nums/EarthRotationSolver.hpp \
-    Nums/GroundTrackingSolver.hpp \
-    Nums/Restricted3BodySolver.hpp \
-    Nums/SatelliteSolver.hpp \
-    Nums/TwoBodySolver.hpp \
     Common/Transform3D.hpp
 
 #FORMS    += \
@@ -626,14 +590,6 @@ RESOURCES += \
     resources.qrc
 
 
-win32:CONFIG(release, debug|release): LIBS += -L$$PWD/../../../../Applications/anaconda/lib/release/ -lpython3.5m
-else:win32:CONFIG(debug, debug|release): LIBS += -L$$PWD/../../../../Applications/anaconda/lib/debug/ -lpython3.5m
-else:unix: LIBS += -L$$PWD/../../../../Applications/anaconda/lib/ -lpython3.5m
-
-LIBS += -L$$PWD/../../../../Applications/anaconda/lib/ -lpython3.5m
-INCLUDEPATH += $$PWD/../../../../Applications/anaconda/include/python3.5m
-DEPENDPATH += $$PWD/../../../../Applications/anaconda/include/python3.5m
-
 #INCLUDEPATH += /usr/local/Cellar/boost/1.60.0_2/include/
 #LIBS += -L/usr/local/Cellar/boost/1.60.0_2/lib/ -lboost_filesystem -lboost_system
 
@@ -1,5 +1,7 @@
 #include "AbstractOdeSolver.hpp"
+#include <algorithm>
 #include <cmath>
+#include <limits>
 
 void AbstractOdeSolver::SetStepSize(double h)
 {
@@ -23,3 +25,195 @@ double AbstractOdeSolver::time()
 {
     return t_;
 }
+
+void AbstractOdeSolver::SetTime(double t)
+{
+    t_ = t;
+}
+
+int AbstractOdeSolver::AddEvent(const EventFunction& g, int direction, bool terminal)
+{
+    Event event;
+    event.g = g;
+    event.direction = direction;
+    event.terminal = terminal;
+    events_.push_back(event);
+    return static_cast<int>(events_.size())-1;
+}
+
+void AbstractOdeSolver::ClearEvents()
+{
+    events_.clear();
+}
+
+void AbstractOdeSolver::SetEventTolerance(double tol)
+{
+    event_tol_ = tol;
+}
+
+const std::vector<AbstractOdeSolver::EventOccurrence>& AbstractOdeSolver::event_log() const
+{
+    return event_log_;
+}
+
+void AbstractOdeSolver::ClearEventLog()
+{
+    event_log_.clear();
+}
+
+bool AbstractOdeSolver::terminated() const
+{
+    return terminated_;
+}
+
+bool AbstractOdeSolver::failed() const
+{
+    return failed_;
+}
+
+bool AbstractOdeSolver::has_events() const
+{
+    return !events_.empty();
+}
+
+bool AbstractOdeSolver::LocateEvents(double t0, double t1, const Interpolant& y, double& t_stop)
+{
+    const int n = static_cast<int>(events_.size());
+    event_g0_.resize(n);
+    y(t0, event_y_);
+    for (int i=0; i<n; i++)
+    {
+        event_g0_[i] = events_[i].g(t0, event_y_);
+    }
+    y(t1, event_y_);
+
+    std::vector<EventOccurrence> found;
+    for (int i=0; i<n; i++)
+    {
+        const Event& event = events_[i];
+        double g0 = event_g0_[i];
+        double g1 = event.g(t1, event_y_);
+        // a zero at t0 was reported with the previous step
+        int direction = 0;
+        if (g0 < 0 && g1 >= 0) direction = 1;
+        if (g0 > 0 && g1 <= 0) direction = -1;
+        if (direction == 0 || (event.direction != 0 && event.direction != direction))
+        {
+            continue;
+        }
+        EventOccurrence occurrence;
+        occurrence.event = i;
+        occurrence.direction = direction;
+        occurrence.t = t1;
+        if (g1 != 0)
+        {
+            std::vector<double> yt;
+            occurrence.t = FindRoot([&](double t) { y(t, yt); return event.g(t, yt); },
+                                    t0, t1, g0, g1, event_tol_);
+        }
+        found.push_back(occurrence);
+    }
+    if (found.empty())
+    {
+        return false;
+    }
+
+    std::stable_sort(found.begin(), found.end(),
+                     [](const EventOccurrence& a, const EventOccurrence& b) { return a.t < b.t; });
+    for (unsigned int k=0; k<found.size(); k++)
+    {
+        y(found[k].t, found[k].y);
+        event_log_.push_back(found[k]);
+        if (events_[found[k].event].terminal)
+        {
+            // later crossings in this step are not reached
+            t_stop = found[k].t;
+            terminated_ = true;
+            return true;
+        }
+    }
+    return false;
+}
+
+double AbstractOdeSolver::FindRoot(const std::function<double(double)>& f, double a, double b,
+                                   double fa, double fb, double tol)
+{
+    const double eps = std::numeric_limits<double>::epsilon();
+    const bool positive_side = fb > 0;
+    // b is the current estimate, a the previous one and [b, c] brackets the zero
+    double c = b;
+    double fc = fb;
+    double d = b - a;
+    double e = d;
+    for (int iter=0; iter<100; iter++)
+    {
+        if ((fb > 0 && fc > 0) || (fb < 0 && fc < 0))
+        {
+            c = a;
+            fc = fa;
+            d = b - a;
+            e = d;
+        }
+        if (std::abs(fc) < std::abs(fb))
+        {
+            a = b;
+            b = c;
+            c = a;
+            fa = fb;
+            fb = fc;
+            fc = fa;
+        }
+        double tol1 = 2*eps*std::abs(b) + 0.5*tol;
+        double xm = 0.5*(c - b);
+        if (std::abs(xm) <= tol1 || fb == 0)
+        {
+            break;
+        }
+        if (std::abs(e) >= tol1 && std::abs(fa) > std::abs(fb))
+        {
+            // inverse quadratic interpolation, secant if only two points are distinct
+            double s = fb/fa;
+            double p, q;
+            if (a == c)
+            {
+                p = 2*xm*s;
+                q = 1 - s;
+            }
+            else
+            {
+                double qa = fa/fc;
+                double r = fb/fc;
+                p = s*(2*xm*qa*(qa - r) - (b - a)*(r - 1));
+                q = (qa - 1)*(r - 1)*(s - 1);
+            }
+            if (p > 0) q = -q;
+            p = std::abs(p);
+            if (2*p < std::min(3*xm*q - std::abs(tol1*q), std::abs(e*q)))
+            {
+                e = d;
+                d = p/q;
+            }
+            else
+            {
+                d = xm;
+                e = d;
+            }
+        }
+        else
+        {
+            // bisection
+            d = xm;
+            e = d;
+        }
+        a = b;
+        fa = fb;
+        b += std::abs(d) > tol1 ? d : (xm > 0 ? tol1 : -tol1);
+        fb = f(b);
+    }
+    // stay on the far side of the crossing so it is not found again from here
+    if (fb == 0 || (fb > 0) == positive_side)
+    {
+        return b;
+    }
+    return c;
+}
@@ -1,10 +1,56 @@
 #ifndef ABSTRACTODESOLVERDEF
 #define ABSTRACTODESOLVERDEF
 
+#include <functional>
 #include <vector>
 
+/* Common interface of the ODE solvers.
+ *
+ * Events: g(t, y) functions of the time and the integrated state vector whose
+ * zero crossings are located after every step on the solver's continuous
+ * extension with Brent's method, so they come out to the event tolerance
+ * whatever the step size.  Crossings are found from the sign of g at the step
+ * ends, a pair of crossings inside one step is missed.  A terminal event ends
+ * UpdateState at the crossing, time() and the state are then those of the event.
+ *
+ * The continuous extension is the dense output of the adaptive Runge-Kutta
+ * and Taylor solvers and the cubic Hermite interpolant between the step ends
+ * of the fixed step, Rosenbrock, symplectic and multistep solvers (the Encke
+ * solver interpolates only the deviation from its Kepler reference, the KS
+ * solvers the regularised state in the fictitious time).
+ * EarthRotationSolver has no integrated state and never reports events.
+ *
+ * The solvers with step size control stop early as well when a step is still
+ * rejected at their smallest step size, e.g. after the state overflowed:
+ * terminated() and failed() are then set and time() and the state are those
+ * of the last accepted step.
+ */
 class AbstractOdeSolver
 {
+public:
+    typedef std::function<double(double t, const std::vector<double>& y)> EventFunction;
+    struct EventOccurrence
+    {
+        int event;
+        double t;
+        // +1 for a rising zero crossing of g, -1 for a falling one
+        int direction;
+        std::vector<double> y;
+    };
+
+private:
+    struct Event
+    {
+        EventFunction g;
+        int direction;
+        bool terminal;
+    };
+    std::vector<Event> events_;
+    std::vector<EventOccurrence> event_log_;
+    double event_tol_ = 1e-6;
+    std::vector<double> event_y_;
+    std::vector<double> event_g0_;
+
 protected:
     double mStepSize;
     double mInitialTime;
@@ -12,12 +58,40 @@ protected:
     double mInitialValue;
     double t_ = 0;
     std::vector<double> mInitialValueVector;
+
+    // set when the last UpdateState stopped at a terminal event
+    bool terminated_ = false;
+    // set together with terminated_ when it stopped at the minimum step size
+    bool failed_ = false;
+
+    typedef std::function<void(double t, std::vector<double>& y)> Interpolant;
+    bool has_events() const;
+    // looks for crossings on (t0, t1] of the solution given by the interpolant and
+    // logs them in time order, returns true with t_stop at the first terminal one
+    bool LocateEvents(double t0, double t1, const Interpolant& y, double& t_stop);
 public:
     void SetStepSize(double h);
     void SetTimeInterval(double t0, double t1);
     void SetInitialValue(double y0);
     void SetInitialValue(std::vector<double> y0);
     double time();
+    void SetTime(double t);
+
+    // direction +1 reports only rising crossings of g, -1 only falling ones and
+    // 0 both, returns the index of the event used in the log
+    int AddEvent(const EventFunction& g, int direction = 0, bool terminal = false);
+    void ClearEvents();
+    // tolerance on the event times
+    void SetEventTolerance(double tol);
+    const std::vector<EventOccurrence>& event_log() const;
+    void ClearEventLog();
+    bool terminated() const;
+    bool failed() const;
+
+    // zero of f in [a, b] for f(a), f(b) of opposite signs (Brent 1973); returns
+    // the end of the final bracket on the side of b, within tol of the zero
+    static double FindRoot(const std::function<double(double)>& f, double a, double b,
+                           double fa, double fb, double tol);
 
     // virtual methods
     virtual void InitialConditions() = 0;
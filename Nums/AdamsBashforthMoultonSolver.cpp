@@ -0,0 +1,191 @@
+#include "AdamsBashforthMoultonSolver.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+AdamsBashforthMoultonSolver::AdamsBashforthMoultonSolver(RungeKuttaSolver& system, int order)
+    : MultistepSolver(system)
+{
+    SetOrder(order);
+}
+
+void AdamsBashforthMoultonSolver::SetOrder(int order)
+{
+    assert(order >= 1 && order <= 12);
+    max_order_ = order;
+    order_ = order;
+
+    predictor_.resize(order);
+    corrector_.resize(order);
+    std::vector<std::vector<long double> > basis;
+    for (int k=1; k<=order; k++)
+    {
+        // predictor interpolates f at s = 0, -1, ..., -(k-1) (in steps from t_n)
+        std::vector<long double> nodes(k);
+        for (int j=0; j<k; j++)
+        {
+            nodes[j] = -j;
+        }
+        LagrangeBasis(nodes, basis);
+        std::vector<double>& beta = predictor_[k-1];
+        beta.resize(k);
+        for (int j=0; j<k; j++)
+        {
+            beta[j] = static_cast<double>(PolynomialIntegral(basis[j], 0.0L, 1.0L));
+        }
+
+        // corrector interpolates f at s = 1, 0, ..., -(k-1)
+        nodes.resize(k+1);
+        for (int j=0; j<=k; j++)
+        {
+            nodes[j] = 1-j;
+        }
+        LagrangeBasis(nodes, basis);
+        std::vector<double>& beta_star = corrector_[k-1];
+        beta_star.resize(k+1);
+        for (int j=0; j<=k; j++)
+        {
+            beta_star[j] = static_cast<double>(PolynomialIntegral(basis[j], 0.0L, 1.0L));
+        }
+    }
+    Restart();
+}
+
+void AdamsBashforthMoultonSolver::SetVariableOrder(bool variable)
+{
+    variable_order_ = variable;
+    order_ = max_order_;
+    steps_at_order_ = 0;
+}
+
+int AdamsBashforthMoultonSolver::order() const
+{
+    return order_;
+}
+
+int AdamsBashforthMoultonSolver::max_order() const
+{
+    return max_order_;
+}
+
+const std::vector<double>& AdamsBashforthMoultonSolver::predictor_coefficients() const
+{
+    return predictor_[order_-1];
+}
+
+const std::vector<double>& AdamsBashforthMoultonSolver::corrector_coefficients() const
+{
+    return corrector_[order_-1];
+}
+
+void AdamsBashforthMoultonSolver::Start()
+{
+    f_.assign(max_order_, std::vector<double>(state_dim_, 0.0));
+    y_pred_.assign(state_dim_, 0.0);
+    f_pred_.assign(state_dim_, 0.0);
+    y_lower_.assign(state_dim_, 0.0);
+    y_higher_.assign(state_dim_, 0.0);
+    order_ = max_order_;
+    steps_at_order_ = 0;
+
+    // k-1 RK4 steps, with substeps to keep their error below the one of the method
+    start_states_.push_back(y_);
+    EvaluateRhs(t_int_, y_, f_[max_order_-1]);
+    for (int j=max_order_-2; j>=0; j--)
+    {
+        StartingStep(t_int_, mStepSize, y_, 4);
+        t_int_ += mStepSize;
+        start_states_.push_back(y_);
+        EvaluateRhs(t_int_, y_, f_[j]);
+    }
+}
+
+void AdamsBashforthMoultonSolver::Predict(int order, std::vector<double>& y) const
+{
+    const double h = mStepSize;
+    const std::vector<double>& beta = predictor_[order-1];
+    for (int i=0; i<state_dim_; i++)
+    {
+        double sum = 0;
+        for (int j=0; j<order; j++)
+        {
+            sum += beta[j]*f_[j][i];
+        }
+        y[i] = y_[i] + h*sum;
+    }
+}
+
+double AdamsBashforthMoultonSolver::Distance(const std::vector<double>& y) const
+{
+    double distance = 0;
+    for (int i=0; i<state_dim_; i++)
+    {
+        distance = std::max(distance, std::abs(y[i] - y_[i])/(1 + std::abs(y_[i])));
+    }
+    return distance;
+}
+
+void AdamsBashforthMoultonSolver::SelectOrder()
+{
+    double error = Distance(y_pred_);
+    if (order_ > 1 && Distance(y_lower_) <= error)
+    {
+        order_--;
+        steps_at_order_ = 0;
+    }
+    else if (order_ < max_order_ && Distance(y_higher_) < 0.5*error)
+    {
+        order_++;
+        steps_at_order_ = 0;
+    }
+}
+
+void AdamsBashforthMoultonSolver::Step()
+{
+    const double h = mStepSize;
+    const int n = state_dim_;
+    // the order stays for k+1 steps before it is reconsidered
+    const bool select = variable_order_ && ++steps_at_order_ > order_;
+
+    // predict
+    Predict(order_, y_pred_);
+    if (select)
+    {
+        if (order_ > 1)
+        {
+            Predict(order_-1, y_lower_);
+        }
+        if (order_ < max_order_)
+        {
+            Predict(order_+1, y_higher_);
+        }
+    }
+    EvaluateRhs(t_int_+h, y_pred_, f_pred_);
+
+    // correct
+    const std::vector<double>& beta_star = corrector_[order_-1];
+    for (int i=0; i<n; i++)
+    {
+        double sum = beta_star[0]*f_pred_[i];
+        for (int j=0; j<order_; j++)
+        {
+            sum += beta_star[j+1]*f_[j][i];
+        }
+        y_[i] += h*sum;
+    }
+    t_int_ += h;
+    if (select)
+    {
+        SelectOrder();
+    }
+
+    // the oldest derivative is dropped, its storage takes the new one
+    std::rotate(f_.begin(), f_.end()-1, f_.end());
+    EvaluateRhs(t_int_, y_, f_[0]);
+}
+
+const std::vector<double>& AdamsBashforthMoultonSolver::derivative() const
+{
+    return f_[0];
+}
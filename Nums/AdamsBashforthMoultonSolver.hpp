@@ -0,0 +1,70 @@
+#ifndef ADAMSBASHFORTHMOULTONSOLVER_H
+#define ADAMSBASHFORTHMOULTONSOLVER_H
+
+#include <vector>
+
+#include "MultistepSolver.hpp"
+
+/* Adams-Bashforth-Moulton predictor-corrector in PECE mode: an Adams-Bashforth
+ * predictor of order k and an Adams-Moulton corrector of order k+1 over the
+ * same k past derivatives, two right hand side evaluations per step.  The
+ * coefficients are computed by integrating the Lagrange interpolants in
+ * extended precision.
+ *
+ * The order varies between 1 and the maximum set with SetOrder (up to 12) on
+ * the fixed step grid.  The derivatives of the maximum order are kept, so the
+ * Adams-Bashforth values of orders k-1 and k+1 come at the cost of a sum each,
+ * and their distances to the corrected value estimate the local errors of the
+ * three orders.  After k+1 steps at order k the order is lowered when order
+ * k-1 is estimated no worse, as happens when the step is too long for the
+ * higher differences to converge, and raised when order k+1 halves the
+ * error.  All orders cost the same two evaluations, the order follows the
+ * highest one whose differences still converge at the given step, so a
+ * maximum order that would be unstable at that step does no harm.
+ */
+class AdamsBashforthMoultonSolver : public MultistepSolver
+{
+private:
+    int max_order_;
+    int order_;
+    bool variable_order_ = true;
+    int steps_at_order_ = 0;
+    // predictor weights of f_n, f_n-1, ..., corrector weights of f_n+1, f_n, ...
+    // for each order, index order-1
+    std::vector<std::vector<double> > predictor_;
+    std::vector<std::vector<double> > corrector_;
+    // past derivatives, f_[0] is the most recent one
+    std::vector<std::vector<double> > f_;
+    std::vector<double> y_pred_;
+    std::vector<double> f_pred_;
+    // Adams-Bashforth values of the neighbouring orders for the order selection
+    std::vector<double> y_lower_;
+    std::vector<double> y_higher_;
+
+    // Adams-Bashforth value of the given order from y_ into y
+    void Predict(int order, std::vector<double>& y) const;
+    // scaled distance of y to the corrected value y_
+    double Distance(const std::vector<double>& y) const;
+    // moves the order by one after the step from the predictor distances
+    void SelectOrder();
+protected:
+    void Start();
+    void Step();
+    const std::vector<double>& derivative() const;
+public:
+    explicit AdamsBashforthMoultonSolver(RungeKuttaSolver& system, int order = 8);
+
+    // maximum order of the predictor, also the current order; restarts the method
+    void SetOrder(int order);
+    // the order stays at the maximum while this is off
+    void SetVariableOrder(bool variable);
+    // order of the last step
+    int order() const;
+    int max_order() const;
+
+    // coefficients of the current order
+    const std::vector<double>& predictor_coefficients() const;
+    const std::vector<double>& corrector_coefficients() const;
+};
+
+#endif // ADAMSBASHFORTHMOULTONSOLVER_H
@@ -1,123 +1,256 @@
 #include "AdaptiveRungeKuttaSolver.hpp"
 
 #include "AbstractOdeSolver.hpp"
+#include <algorithm>
+#include <cassert>
 #include <iostream>
 #include <cmath>
+#include <limits>
 
+// step size controller parameters (Hairer, Norsett, Wanner, Solving ODEs I, II.4)
+const double SAFETY = 0.9;
+const double MIN_FACTOR = 0.2;
+const double MAX_FACTOR = 10.0;
+const double ALPHA = 0.17;
+const double BETA = 0.04;
 
 void AdaptiveRungeKuttaSolver::SetStateDimension(int state_dim)
 {
     state_dim_ = state_dim;
-    state.reserve(state_dim);
+    state.resize(state_dim);
+    stepper_.Resize(state_dim);
+    y_.assign(state_dim, 0.0);
+    y_new_.assign(state_dim, 0.0);
+    err_.assign(state_dim, 0.0);
+    reported_.assign(state_dim, 0.0);
+    for (int i=0; i<5; i++)
+    {
+        rcont_[i].assign(state_dim, 0.0);
+    }
+    if (atol_.size() != static_cast<unsigned long>(state_dim))
+    {
+        SetTolerances(1e-9, 1e-9);
+    }
+    started_ = false;
 }
 
-void AdaptiveRungeKuttaSolver::UpdateState(double dt)
+void AdaptiveRungeKuttaSolver::SetTolerances(double atol, double rtol)
 {
-    double total_d = 0;
-    while (total_d <= dt)
-    {
-        RKIteration(t_, state);
-        total_d += mStepSize;
-    }
-    t_ = t_ + total_d;
+    atol_.assign(state_dim_, atol);
+    rtol_.assign(state_dim_, rtol);
+}
+
+void AdaptiveRungeKuttaSolver::SetTolerances(const std::vector<double>& atol, const std::vector<double>& rtol)
+{
+    assert(atol.size() == static_cast<unsigned long>(state_dim_)
+           && rtol.size() == static_cast<unsigned long>(state_dim_));
+    atol_ = atol;
+    rtol_ = rtol;
 }
 
-void AdaptiveRungeKuttaSolver::RKIteration(double ti, std::vector<double>& yi)
+void AdaptiveRungeKuttaSolver::SetMaxStepSize(double h_max)
 {
-    std::vector<double> k1(state_dim_);
-    std::vector<double> k2(state_dim_);
-    std::vector<double> k3(state_dim_);
-    std::vector<double> k4(state_dim_);
-    std::vector<double> k5(state_dim_);
-    std::vector<double> f1(state_dim_);
-    std::vector<double> f2(state_dim_);
-    std::vector<double> f3(state_dim_);
-    std::vector<double> f4(state_dim_);
-    std::vector<double> f5(state_dim_);
-    std::vector<double> f6(state_dim_);
-    std::vector<double> int2(state_dim_);
-    std::vector<double> int3(state_dim_);
-    std::vector<double> int4(state_dim_);
-    std::vector<double> int5(state_dim_);
-    std::vector<double> int6(state_dim_);
-    std::vector<double> e(state_dim_);
-    double tol = 0.5;
-
-    for (int it=0; it < 10; it++)
+    h_max_ = h_max;
+}
+
+long AdaptiveRungeKuttaSolver::rhs_evaluations() const
+{
+    return rhs_evaluations_;
+}
+
+long AdaptiveRungeKuttaSolver::rejected_steps() const
+{
+    return rejected_steps_;
+}
+
+void AdaptiveRungeKuttaSolver::EvaluateRhs(double t, const std::vector<double>& y, std::vector<double>& f)
+{
+    rhs_evaluations_++;
+    RightHandSide(t, y, f);
+}
+
+void AdaptiveRungeKuttaSolver::Restart()
+{
+    y_ = state;
+    t_int_ = t_;
+    t_prev_ = t_;
+    h_last_ = 0;
+    EvaluateRhs(t_int_, y_, stepper_.k(0));
+    h_ = mStepSize;
+    err_prev_ = 1e-4;
+    rejected_ = false;
+    reported_ = state;
+    t_reported_ = t_;
+    t_checked_ = t_;
+    started_ = true;
+}
+
+void AdaptiveRungeKuttaSolver::UpdateState(double dt)
+{
+    // somebody changed the state or the time since the last update
+    if (!started_ || t_ != t_reported_ || state != reported_)
     {
-        RightHandSide(ti, yi, f1);
-        for (int j=0; j < state_dim_; j++)
-        {
-            k1[j] = mStepSize*f1[j];
-            int2[j] = yi[j] + 0.25 * k1[j];
-        }
-        RightHandSide(ti+0.25*mStepSize, int2, f2);
-        for (int j=0; j < state_dim_; j++)
-        {
-            k2[j] = mStepSize*f2[j];
-            int3[j] = yi[j] + (3/32)*k1[j] + (9/32) * k2[j];
-        }
-        RightHandSide(ti+(3.0/8.0)*mStepSize, int3, f3);
-        for (int j=0; j < state_dim_; j++)
-        {
-            k3[j] = mStepSize*f3[j];
-            int4[j] = yi[j]+(1932.0/2197.0)*k1[j] + (-7200.0/2197.0)*k2[j] + (7296.0/2197.0)*k3[j];
-        }
-        RightHandSide(ti+(12.0/13.0)*mStepSize, int4, f4);
-        for (int j=0; j < state_dim_; j++)
-        {
-            k4[j] = mStepSize*f4[j];
-            int5[j] = yi[j]+(439.0/216.0)*k1[j] - 8*k2[j] + (3680.0/513.0)*k3[j] + (-845.0/4104.0)*k4[j];
-        }
-        RightHandSide(ti+mStepSize, int5, f5);
-        for (int j=0; j < state_dim_; j++)
+        Restart();
+    }
+    terminated_ = false;
+    failed_ = false;
+    double t_target = t_ + dt;
+    if (has_events())
+    {
+        auto dense = [this](double t, std::vector<double>& y)
         {
-            k5[j] = mStepSize*f5[j];
-            int6[j] = yi[j]+(-8.0/27.0)*k1[j] + 2*k2[j] + (-3544.0/2565.0)*k3[j] + (1859.0/4104.0)*k4[j] + (-11.0/40.0)*k5[j];
-        }
-        RightHandSide(ti+0.5*mStepSize, int6, f6);
-        for (int j=0; j < state_dim_; j++)
+            y.resize(state_dim_);
+            DenseOutput(t, y);
+        };
+        while (true)
         {
-            e[j] = fabs((16.0/135.0-25.0/216.0)*f1[j] + 0*f2[j] + (6656.0/12825.0-1408.0/2565.0)*f3[j]
-                    + (28561.0/56430.0-2197.0/4104.0)*f4[j] + (-9.0/50.0+1.0/5.0)*f5[j] + (2.0/55.0)*f6[j]);
-            if (e[j] <= e[0])
+            // the accepted step may reach beyond the last reported time
+            double t_end = std::min(t_int_, t_target);
+            double t_stop;
+            if (t_end > t_checked_ && LocateEvents(t_checked_, t_end, dense, t_stop))
             {
-                e[0] = e[j];
+                DenseOutput(t_stop, state);
+                t_ = t_stop;
+                t_checked_ = t_stop;
+                reported_ = state;
+                t_reported_ = t_;
+                return;
             }
-        }
-        double beta = 0.8;
-        if (e[0] > tol)
-        {
-            mStepSize = mStepSize*beta*pow(tol/e[0],0.2);
-        }
-        else
-        {
-            it = 10;
+            t_checked_ = std::max(t_checked_, t_end);
+            if (t_int_ >= t_target) break;
+            if (!RKIteration() && failed_) break;
         }
     }
-    for (int j=0; j < state_dim_; j++)
+    while (t_int_ < t_target && !failed_)
     {
-        yi[j] = yi[j] + mStepSize*((16.0/135.0)*f1[j] + (6656.0/12825.0)*f3[j] + (28561.0/56430.0)*f4[j]
-            + (-9.0/50.0)*f5[j] + (2.0/55.0)*f6[j]);
+        RKIteration();
     }
-
+    if (failed_)
+    {
+        // stays at the last accepted step
+        state = y_;
+        t_ = t_int_;
+        terminated_ = true;
+    }
+    else
+    {
+        DenseOutput(t_target, state);
+        t_ = t_target;
+    }
+    reported_ = state;
+    t_reported_ = t_;
 }
 
+// weighted RMS norm of the local error estimate
+double AdaptiveRungeKuttaSolver::ErrorNorm() const
+{
+    double sum = 0;
+    for (int j=0; j < state_dim_; j++)
+    {
+        double scale = atol_[j] + rtol_[j]*std::max(std::abs(y_[j]), std::abs(y_new_[j]));
+        double ratio = err_[j]/scale;
+        sum += ratio*ratio;
+    }
+    return sqrt(sum/state_dim_);
+}
 
-void AdaptiveRungeKuttaSolver::SolveEquation(std::vector<double> yi)
+bool AdaptiveRungeKuttaSolver::RKIteration()
 {
-    double numPoints = (mFinalTime - mInitialTime)/mStepSize;
-    double ti = mInitialTime;
-    for (int i=0; i<state_dim_; i++ )
+    double h = h_;
+    if (h_max_ > 0)
     {
-        yi[i] = mInitialValueVector[i];
+        h = std::min(h, h_max_);
     }
-    for (int i=0; i < numPoints; i++)
+    double h_min = 16*std::numeric_limits<double>::epsilon()*std::max(1.0, std::abs(t_int_));
+    h = std::max(h, h_min);
+
+    // stage 0 is f(t_int_, y_) from the previous step (first same as last)
+    stepper_.Advance([this](double t, const std::vector<double>& y, std::vector<double>& f)
+                     { EvaluateRhs(t, y, f); }, t_int_, h, y_, y_new_);
+    stepper_.ErrorEstimate(h, err_);
+    double err = ErrorNorm();
+
+    // a NaN error is rejected as well
+    if (!(err <= 1))
     {
-        RKIteration(ti, yi);
-        ti = ti+mStepSize;
+        if (h <= h_min)
+        {
+            failed_ = true;
+            return false;
+        }
+        // reject and retry with a smaller step
+        h_ = h*std::max(MIN_FACTOR, SAFETY*pow(err, -0.2));
+        rejected_ = true;
+        rejected_steps_++;
+        return false;
     }
 
+    ComputeDenseOutput(h);
+    t_prev_ = t_int_;
+    t_int_ = t_int_ + h;
+    h_last_ = h;
+    y_.swap(y_new_);
+    std::swap(stepper_.k(0), stepper_.k(DormandPrince54Tableau::kStages-1));
+
+    // PI controller, no step size increase right after a rejection
+    double factor = MAX_FACTOR;
+    if (err > 0)
+    {
+        factor = SAFETY*pow(err, -ALPHA)*pow(err_prev_, BETA);
+        factor = std::min(MAX_FACTOR, std::max(MIN_FACTOR, factor));
+    }
+    if (rejected_)
+    {
+        factor = std::min(1.0, factor);
+    }
+    h_ = h*factor;
+    err_prev_ = std::max(err, 1e-4);
+    rejected_ = false;
+    return true;
 }
 
+// coefficients of the continuous extension, has to be called before y_ and the stages are updated
+void AdaptiveRungeKuttaSolver::ComputeDenseOutput(double h)
+{
+    const std::vector<double>& k1 = stepper_.k(0);
+    const std::vector<double>& k7 = stepper_.k(6);
+    for (int j=0; j < state_dim_; j++)
+    {
+        double ydiff = y_new_[j] - y_[j];
+        double bspl = h*k1[j] - ydiff;
+        rcont_[0][j] = y_[j];
+        rcont_[1][j] = ydiff;
+        rcont_[2][j] = bspl;
+        rcont_[3][j] = ydiff - h*k7[j] - bspl;
+        double sum = 0;
+        for (int m=0; m < DormandPrince54Tableau::kStages; m++)
+        {
+            sum += DormandPrince54Tableau::d[m]*stepper_.k(m)[j];
+        }
+        rcont_[4][j] = h*sum;
+    }
+}
 
+void AdaptiveRungeKuttaSolver::DenseOutput(double t, std::vector<double>& y) const
+{
+    if (h_last_ == 0)
+    {
+        y = y_;
+        return;
+    }
+    double theta = (t - t_prev_)/h_last_;
+    double theta1 = 1 - theta;
+    for (int j=0; j < state_dim_; j++)
+    {
+        y[j] = rcont_[0][j] + theta*(rcont_[1][j] + theta1*(rcont_[2][j]
+                + theta*(rcont_[3][j] + theta1*rcont_[4][j])));
+    }
+}
+
+void AdaptiveRungeKuttaSolver::SolveEquation(std::vector<double>)
+{
+    state = mInitialValueVector;
+    t_ = mInitialTime;
+    started_ = false;
+    UpdateState(mFinalTime - mInitialTime);
+}
@@ -2,24 +2,84 @@
 #define ADAPTIVERUNGEKUTTASOLVER_H
 
 #include "AbstractOdeSolver.hpp"
-#include <QVector3D>
+#include "RungeKuttaStepper.hpp"
+#include "Vector3D.hpp"
 
+/* Dormand-Prince 5(4) integrator with local error control.
+ * Each step is accepted or rejected based on the embedded error estimate
+ * measured against per component absolute/relative tolerances, and the next
+ * step size comes from a PI controller.  The integrator keeps its own state,
+ * which may run ahead of the reported state; UpdateState(dt) evaluates the
+ * continuous extension at exactly t + dt instead of shortening the last step.
+ * A step that is still rejected at the minimum step size 16 eps |t|, e.g.
+ * because the error estimate is NaN, stops the integration with failed().
+ */
 class AdaptiveRungeKuttaSolver : public AbstractOdeSolver
-{ 
+{
 private:
-    int state_dim_;
+    int state_dim_ = 0;
+    DynamicRungeKutta<DormandPrince54Tableau> stepper_;
+
+    // integrator state y_ at time t_int_, stepper_.k(0) holds f(t_int_, y_)
+    std::vector<double> y_;
+    std::vector<double> y_new_;
+    std::vector<double> err_;
+    double t_int_;
+    // continuous extension of the last accepted step [t_prev_, t_prev_ + h_last_]
+    std::vector<double> rcont_[5];
+    double t_prev_;
+    double h_last_;
+    // state and time handed out by the last UpdateState, used to detect external changes
+    std::vector<double> reported_;
+    double t_reported_;
+    bool started_ = false;
+    // events have been located up to this time
+    double t_checked_;
+
+    // step size control
+    std::vector<double> atol_;
+    std::vector<double> rtol_;
+    double h_;
+    double h_max_ = 0;
+    double err_prev_ = 1e-4;
+    bool rejected_ = false;
+
+    long rhs_evaluations_ = 0;
+    long rejected_steps_ = 0;
+
+    double ErrorNorm() const;
+    void ComputeDenseOutput(double h);
+    void EvaluateRhs(double t, const std::vector<double>& y, std::vector<double>& f);
 protected:
     std::vector<double> state;
-    std::vector<QVector3D> results;
+    std::vector<Vector3D> results;
 public:
     // implementations of virtual methods from inherited class
     void UpdateState(double dt);
     void SolveEquation(std::vector<double> yi);
 
-    // single RK iteration
-    void RKIteration(double ti, std::vector<double> &yi);
+    // single attempted step of the current trial size, returns false if it was
+    // rejected and sets failed_ if that happened at the minimum step size
+    bool RKIteration();
     void SetStateDimension(int state_dim);
 
+    // error tolerances, either common to all components or per component;
+    // the vectors need one entry per component of the state dimension
+    void SetTolerances(double atol, double rtol);
+    void SetTolerances(const std::vector<double>& atol, const std::vector<double>& rtol);
+    // upper bound on the step size, 0 means unbounded
+    void SetMaxStepSize(double h_max);
+
+    // restarts the integrator from the current state, needed if the state or
+    // right hand side changed discontinuously (otherwise detected automatically)
+    void Restart();
+
+    // solution at time t inside the last accepted step
+    void DenseOutput(double t, std::vector<double>& y) const;
+
+    long rhs_evaluations() const;
+    long rejected_steps() const;
+
     // virtual methods
     virtual void InitialConditions() = 0;
     virtual void RightHandSide(double t, const std::vector<double> &  y, std::vector<double> &  f) = 0;
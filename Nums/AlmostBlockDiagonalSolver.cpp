@@ -0,0 +1,122 @@
+#include "AlmostBlockDiagonalSolver.hpp"
+
+#include <cassert>
+
+void AlmostBlockDiagonalSolver::Resize(int num_nodes, int dim)
+{
+    assert(num_nodes >= 2);
+    num_nodes_ = num_nodes;
+    dim_ = dim;
+    left_ = Eigen::MatrixXd::Zero(dim, dim*(num_nodes-1));
+    right_ = Eigen::MatrixXd::Zero(dim, dim*(num_nodes-1));
+    bc_left_ = Eigen::MatrixXd::Zero(dim, dim);
+    bc_right_ = Eigen::MatrixXd::Zero(dim, dim);
+    qr_.assign(num_nodes-2, Eigen::HouseholderQR<Eigen::MatrixXd>(2*dim, dim));
+    end_lu_ = Eigen::FullPivLU<Eigen::MatrixXd>(2*dim, 2*dim);
+
+    stack_.resize(2*dim, dim);
+    coupling_.resize(2*dim, 2*dim);
+    end_.resize(2*dim, 2*dim);
+    rhs_.resize(2*dim);
+    end_rhs_.resize(2*dim);
+    end_x_.resize(2*dim);
+    work_.resize(2*dim);
+}
+
+Eigen::Block<Eigen::MatrixXd> AlmostBlockDiagonalSolver::left(int i)
+{
+    return left_.block(0, dim_*i, dim_, dim_);
+}
+
+Eigen::Block<Eigen::MatrixXd> AlmostBlockDiagonalSolver::right(int i)
+{
+    return right_.block(0, dim_*i, dim_, dim_);
+}
+
+Eigen::MatrixXd& AlmostBlockDiagonalSolver::bc_left()
+{
+    return bc_left_;
+}
+
+Eigen::MatrixXd& AlmostBlockDiagonalSolver::bc_right()
+{
+    return bc_right_;
+}
+
+int AlmostBlockDiagonalSolver::Factorize()
+{
+    const int d = dim_;
+    // top rows of coupling_ hold the condensed relation G x_0 + H x_i = g
+    coupling_.topLeftCorner(d, d) = left(0);
+    coupling_.topRightCorner(d, d) = right(0);
+    for (int i=1; i<num_nodes_-1; i++)
+    {
+        Eigen::HouseholderQR<Eigen::MatrixXd>& qr = qr_[i-1];
+        stack_.topRows(d) = coupling_.topRightCorner(d, d);
+        stack_.bottomRows(d) = left(i);
+        qr.compute(stack_);
+        double scale = stack_.cwiseAbs().maxCoeff();
+        if (qr.matrixQR().diagonal().cwiseAbs().minCoeff() <= 1e-14*scale)
+        {
+            return 1;
+        }
+
+        // Q^T [G 0; 0 R_i] = [E_i F_i; G' H'], the first block row gives x_i
+        // in the back substitution, the second the relation for the next step
+        coupling_.topRightCorner(d, d).setZero();
+        coupling_.bottomLeftCorner(d, d).setZero();
+        coupling_.bottomRightCorner(d, d) = right(i);
+        qr.householderQ().transpose().applyThisOnTheLeft(coupling_, work_);
+        left(i) = coupling_.topLeftCorner(d, d);
+        right(i) = coupling_.topRightCorner(d, d);
+        coupling_.topRows(d) = coupling_.bottomRows(d);
+    }
+
+    end_.topRows(d) = coupling_.topRows(d);
+    end_.bottomLeftCorner(d, d) = bc_left_;
+    end_.bottomRightCorner(d, d) = bc_right_;
+    end_lu_.compute(end_);
+    return end_lu_.isInvertible() ? 0 : 1;
+}
+
+void AlmostBlockDiagonalSolver::Solve(const Eigen::VectorXd& q, Eigen::VectorXd& x)
+{
+    const int d = dim_;
+    const int n = num_nodes_;
+    Eigen::Matrix<double, 1, 1> work;
+    // condensed right hand side, the c_i of the eliminated nodes are kept in x
+    rhs_.head(d) = q.segment(0, d);
+    end_rhs_.tail(d) = q.segment(d*(n-1), d);
+    x.resize(d*n);
+    for (int i=1; i<n-1; i++)
+    {
+        rhs_.tail(d) = q.segment(d*i, d);
+        qr_[i-1].householderQ().transpose().applyThisOnTheLeft(rhs_, work);
+        x.segment(d*i, d) = rhs_.head(d);
+        rhs_.head(d) = rhs_.tail(d);
+    }
+
+    end_rhs_.head(d) = rhs_.head(d);
+    end_x_ = end_lu_.solve(end_rhs_);
+    x.segment(0, d) = end_x_.head(d);
+    x.segment(d*(n-1), d) = end_x_.tail(d);
+
+    // U_i x_i = c_i - E_i x_0 - F_i x_{i+1}
+    for (int i=n-2; i>0; i--)
+    {
+        Eigen::VectorBlock<Eigen::VectorXd> xi = x.segment(d*i, d);
+        xi.noalias() -= left(i)*x.segment(0, d);
+        xi.noalias() -= right(i)*x.segment(d*(i+1), d);
+        qr_[i-1].matrixQR().topLeftCorner(d, d).triangularView<Eigen::Upper>().solveInPlace(xi);
+    }
+}
+
+int AlmostBlockDiagonalSolver::num_nodes() const
+{
+    return num_nodes_;
+}
+
+int AlmostBlockDiagonalSolver::dim() const
+{
+    return dim_;
+}
@@ -0,0 +1,64 @@
+#ifndef ALMOSTBLOCKDIAGONALSOLVER_H
+#define ALMOSTBLOCKDIAGONALSOLVER_H
+
+#include <vector>
+#include "Eigen/Dense"
+
+/* Linear solver for the Newton systems of two point boundary value problems
+ * on n nodes with d x d blocks,
+ *   S_i x_i + R_i x_{i+1} = q_i,   i = 0..n-2
+ *   Ba x_0 + Bb x_{n-1} = beta
+ * The interior unknowns x_1..x_{n-2} are eliminated one after the other with
+ * a Householder QR of the 2d x d column [R_{i-1}; S_i] (structured QR
+ * condensation as in Wright 1992), which keeps the elimination stable for
+ * dichotomic problems and leaves a dense 2d x 2d system for x_0 and x_{n-1}
+ * that also takes boundary conditions coupling both ends.  Work is O(n d^3)
+ * and storage O(n d^2); after Resize no memory is allocated.
+ *
+ * The right hand side uses the row layout of BoundaryValueProblem: q_i in
+ * segment i and beta in segment n-1.
+ */
+class AlmostBlockDiagonalSolver
+{
+private:
+    int num_nodes_ = 0;
+    int dim_ = 0;
+
+    // S_i and R_i side by side, Factorize replaces them by the coefficients
+    // E_i, F_i of x_0 and x_{i+1} in the elimination of x_i
+    Eigen::MatrixXd left_;
+    Eigen::MatrixXd right_;
+    Eigen::MatrixXd bc_left_;
+    Eigen::MatrixXd bc_right_;
+
+    std::vector<Eigen::HouseholderQR<Eigen::MatrixXd> > qr_;
+    Eigen::FullPivLU<Eigen::MatrixXd> end_lu_;
+
+    // workspace
+    Eigen::MatrixXd stack_;
+    Eigen::MatrixXd coupling_;
+    Eigen::MatrixXd end_;
+    Eigen::VectorXd rhs_;
+    Eigen::VectorXd end_rhs_;
+    Eigen::VectorXd end_x_;
+    Eigen::RowVectorXd work_;
+public:
+    void Resize(int num_nodes, int dim);
+
+    // blocks of interval i (0..n-2) and of the boundary conditions, to be set
+    // before every Factorize
+    Eigen::Block<Eigen::MatrixXd> left(int i);
+    Eigen::Block<Eigen::MatrixXd> right(int i);
+    Eigen::MatrixXd& bc_left();
+    Eigen::MatrixXd& bc_right();
+
+    // returns 1 if the system is singular and 0 otherwise
+    int Factorize();
+    // solution for right hand side q with the last factorization, q and x may be the same vector
+    void Solve(const Eigen::VectorXd& q, Eigen::VectorXd& x);
+
+    int num_nodes() const;
+    int dim() const;
+};
+
+#endif // ALMOSTBLOCKDIAGONALSOLVER_H
@@ -1,8 +1,8 @@
-#include <iostream>
-#include <fstream>
+#include <algorithm>
 #include <cassert>
-#include <Eigen/Sparse>
-#include <Eigen/SparseLU>
+#include <cmath>
+#include <fstream>
+#include <iostream>
 
 #include "BoundaryValueProblem.hpp"
 
@@ -13,6 +13,7 @@ BoundaryValueProblem::BoundaryValueProblem(DifferentialSystem *p_ode, int num_no
     dim_ = dim;
     num_nodes_ = num_nodes;
     sol_vec_ = Eigen::VectorXd::Zero(num_nodes_*dim_);
+    abd_.Resize(num_nodes_, dim_);
     filename_ = "ode_output.dat";
 }
 
@@ -21,75 +22,453 @@ double BoundaryValueProblem::Step(int i)
     return grid_.nodes_[i].coordinate;
 }
 
-void BoundaryValueProblem::Solve()
+void BoundaryValueProblem::SetNewtonTolerance(double tol)
 {
-    for (int iter=0; iter<MAX_ITER; iter++)
+    newton_tol_ = tol;
+}
+
+void BoundaryValueProblem::SetInitialGuess(const Eigen::VectorXd& sol)
+{
+    assert(sol.size() == sol_vec_.size());
+    sol_vec_ = sol;
+}
+
+void BoundaryValueProblem::SetScheme(Scheme scheme)
+{
+    scheme_ = scheme;
+    switch (scheme)
     {
-        std::cout << "Iteration: " << iter << std::endl;
-        Eigen::VectorXd u = Eigen::VectorXd(sol_vec_.segment(0,dim_));
-        Eigen::VectorXd v = Eigen::VectorXd(sol_vec_.tail(dim_));
+    case TRAPEZOIDAL:
+    case HERMITE_SIMPSON:
+        stages_ = 0;
+        break;
+    case LOBATTO_IIIA_3:
+        stages_ = 1;
+        lobatto_c_.resize(3);
+        lobatto_c_ << 0, 0.5, 1;
+        lobatto_a_.resize(3, 3);
+        lobatto_a_ << 0, 0, 0,
+                5.0/24, 1.0/3, -1.0/24,
+                1.0/6, 2.0/3, 1.0/6;
+        break;
+    case LOBATTO_IIIA_4:
+    {
+        double r = sqrt(5.0);
+        stages_ = 2;
+        lobatto_c_.resize(4);
+        lobatto_c_ << 0, (5-r)/10, (5+r)/10, 1;
+        lobatto_a_.resize(4, 4);
+        lobatto_a_ << 0, 0, 0, 0,
+                (11+r)/120, (25-r)/120, (25-13*r)/120, (r-1)/120,
+                (11-r)/120, (25+13*r)/120, (25+r)/120, (-1-r)/120,
+                1.0/12, 5.0/12, 5.0/12, 1.0/12;
+        break;
+    }
+    }
+}
 
-        Eigen::MatrixXd Ba = p_ode_->p_BcsGrad1Func(u,v);
-        Eigen::MatrixXd Bb = p_ode_->p_BcsGrad2Func(u,v);
-        Eigen::VectorXd beta = -p_ode_->p_BcsFunc(u,v);
+void BoundaryValueProblem::SetMeshRefinement(double tol, int max_nodes, int max_refinements)
+{
+    mesh_tol_ = tol;
+    max_nodes_ = max_nodes;
+    max_refinements_ = max_refinements;
+}
 
-        Eigen::SparseMatrix<double, Eigen::ColMajor> LeftMatrix(num_nodes_*dim_, num_nodes_*dim_);
-        Eigen::VectorXd Q = Eigen::VectorXd::Zero(num_nodes_*dim_);
-        for (int i=0; i<num_nodes_-1; i++)
-        {
-            double t = grid_.nodes_[i].coordinate;
-            double tp = grid_.nodes_[i+1].coordinate;
-            double h = tp-t;
-            Eigen::VectorXd u = Eigen::VectorXd(sol_vec_.segment(dim_*i,dim_));
-            Eigen::VectorXd up = Eigen::VectorXd(sol_vec_.segment(dim_*(i+1),dim_));
+void BoundaryValueProblem::SetVerbose(bool verbose)
+{
+    verbose_ = verbose;
+}
 
-            Eigen::MatrixXd A = p_ode_->p_RhsGradYFunc(t, u);
-            Eigen::MatrixXd Ap = p_ode_->p_RhsGradYFunc(tp, up);
+Eigen::VectorXd BoundaryValueProblem::mesh() const
+{
+    return grid_.coordinates();
+}
 
-            Eigen::MatrixXd I = Eigen::MatrixXd::Identity(dim_,dim_);
-            Eigen::MatrixXd S = -(1.0/h)*I - 0.5*A;
-            Eigen::MatrixXd R = (1.0/h)*I - 0.5*Ap;
+double BoundaryValueProblem::mesh_error() const
+{
+    return mesh_error_;
+}
 
-            for (int j=0; j<dim_; j++)
+int BoundaryValueProblem::Solve()
+{
+    mesh_error_ = -1;
+    if (Newton())
+    {
+        return 1;
+    }
+    if (mesh_tol_ <= 0)
+    {
+        return 0;
+    }
+    for (int k=0; ; k++)
+    {
+        if (k == max_refinements_)
+        {
+            // the solution on the last mesh has not been estimated yet
+            mesh_error_ = MeshError();
+            break;
+        }
+        // estimates the error of the current solution
+        if (!Remesh())
+        {
+            break;
+        }
+        if (Newton())
+        {
+            return 1;
+        }
+    }
+    return mesh_error_ > mesh_tol_ ? 2 : 0;
+}
+
+// Damped Newton with the natural monotonicity test (Deuflhard): the step is
+// halved until the simplified correction at the trial point, solved with the
+// same factorization, is smaller than the Newton correction by a quarter of
+// the step fraction, and taken anyway after MAX_HALVINGS.  Unlike a test on
+// the residual norm this does not depend on the scaling of the equations.
+int BoundaryValueProblem::Newton()
+{
+    Eigen::VectorXd Q(num_nodes_*dim_);
+    Eigen::VectorXd Q_trial(num_nodes_*dim_);
+    Eigen::VectorXd w, w_trial, sol, stages, d_stages;
+    if (stages_ > 0)
+    {
+        InitStages();
+    }
+    for (int iter=0; iter<MAX_ITER; iter++)
+    {
+        if (verbose_)
+        {
+            std::cout << "Iteration: " << iter << std::endl;
+        }
+        Assemble(Q, true);
+        if (abd_.Factorize())
+        {
+            if (verbose_)
+            {
+                std::cout << "Singular Newton matrix" << std::endl;
+            }
+            return 1;
+        }
+        abd_.Solve(Q, w);
+        sol = sol_vec_;
+        stages = stage_vec_;
+        Correct(w);
+        if (w.norm() < newton_tol_) return 0;
+
+        d_stages = stage_vec_-stages;
+        double norm = w.norm();
+        double step = 1;
+        for (int k=0; k<MAX_HALVINGS; k++)
+        {
+            Assemble(Q_trial, false);
+            abd_.Solve(Q_trial, w_trial);
+            if (w_trial.norm() <= (1-0.25*step)*norm)
             {
-                for (int k=0; k<dim_; k++)
-                {
-                    LeftMatrix.coeffRef(dim_*i+j, dim_*i+k) += S(j,k);
-                    LeftMatrix.coeffRef(dim_*i+j, dim_*(i+1)+k) += R(j,k);
-                }
+                break;
             }
+            step *= 0.5;
+            sol_vec_ = sol + step*w;
+            stage_vec_ = stages + step*d_stages;
+        }
+        if (verbose_ && step < 1)
+        {
+            std::cout << "Damped step " << step << std::endl;
+        }
+    }
+    return 1;
+}
 
-            Q.segment(dim_*i,dim_) = 0.5*(p_ode_->p_RhsFunc(tp,up)+p_ode_->p_RhsFunc(t,u))-(up-u)/h;
+void BoundaryValueProblem::Assemble(Eigen::VectorXd& Q, bool jacobian)
+{
+    Eigen::MatrixXd I = Eigen::MatrixXd::Identity(dim_,dim_);
+    Eigen::VectorXd u = Eigen::VectorXd(sol_vec_.segment(0,dim_));
+    Eigen::VectorXd v = Eigen::VectorXd(sol_vec_.tail(dim_));
+
+    if (jacobian)
+    {
+        abd_.bc_left() = p_ode_->p_BcsGrad1Func(u,v);
+        abd_.bc_right() = p_ode_->p_BcsGrad2Func(u,v);
+    }
+    Q.segment(dim_*(num_nodes_-1),dim_) = -p_ode_->p_BcsFunc(u,v);
 
+    // right hand side and its gradient at the left end of each interval are
+    // those of the right end of the previous one
+    double tp = grid_.nodes_[0].coordinate;
+    Eigen::VectorXd up = u;
+    Eigen::VectorXd fp = p_ode_->p_RhsFunc(tp, up);
+    Eigen::MatrixXd Ap;
+    if (jacobian || stages_ > 0)
+    {
+        Ap = p_ode_->p_RhsGradYFunc(tp, up);
+    }
+    Eigen::VectorXd f;
+    Eigen::MatrixXd A;
+    for (int i=0; i<num_nodes_-1; i++)
+    {
+        double t = tp;
+        tp = grid_.nodes_[i+1].coordinate;
+        double h = tp-t;
+        u.swap(up);
+        up = sol_vec_.segment(dim_*(i+1),dim_);
+        f.swap(fp);
+        A.swap(Ap);
+        fp = p_ode_->p_RhsFunc(tp, up);
+        if (jacobian || stages_ > 0)
+        {
+            Ap = p_ode_->p_RhsGradYFunc(tp, up);
         }
 
-        for (int j=0; j<dim_; j++)
+        switch (scheme_)
         {
-            for (int k=0; k<dim_; k++)
+        case TRAPEZOIDAL:
+            if (jacobian)
             {
-                LeftMatrix.coeffRef(dim_*(num_nodes_-1)+j, dim_+k) += Ba(j,k);
-                LeftMatrix.coeffRef(dim_*(num_nodes_-1)+j, dim_*(num_nodes_-1)+k) += Bb(j,k);
-
+                abd_.left(i) = -(1.0/h)*I - 0.5*A;
+                abd_.right(i) = (1.0/h)*I - 0.5*Ap;
+            }
+            Q.segment(dim_*i,dim_) = 0.5*(fp+f)-(up-u)/h;
+            break;
+        case HERMITE_SIMPSON:
+        {
+            // Simpson's rule with the midpoint of the Hermite interpolant
+            Eigen::VectorXd um = 0.5*(u+up) + 0.125*h*(f-fp);
+            Eigen::VectorXd fm = p_ode_->p_RhsFunc(t+0.5*h, um);
+            if (jacobian)
+            {
+                Eigen::MatrixXd Am = p_ode_->p_RhsGradYFunc(t+0.5*h, um);
+                abd_.left(i) = -(1.0/h)*I - (A + Am*(2*I + 0.5*h*A))/6;
+                abd_.right(i) = (1.0/h)*I - (Ap + Am*(2*I - 0.5*h*Ap))/6;
             }
+            Q.segment(dim_*i,dim_) = (f+4*fm+fp)/6-(up-u)/h;
+            break;
+        }
+        default:
+            Condense(i, t, h, u, up, f, fp, A, Ap, Q, jacobian);
+            break;
+        }
+    }
+}
+
+void BoundaryValueProblem::Correct(const Eigen::VectorXd& w)
+{
+    const int md = stages_*dim_;
+    for (int i=0; i<num_nodes_-1 && md>0; i++)
+    {
+        Eigen::VectorBlock<Eigen::VectorXd> z = stage_vec_.segment(md*i, md);
+        z += stage_rhs_.segment(md*i, md);
+        z.noalias() += stage_left_.block(0, dim_*i, md, dim_)*w.segment(dim_*i, dim_);
+        z.noalias() += stage_right_.block(0, dim_*i, md, dim_)*w.segment(dim_*(i+1), dim_);
+    }
+    sol_vec_ += w;
+}
+
+void BoundaryValueProblem::InitStages()
+{
+    const int md = stages_*dim_;
+    stage_vec_.resize(md*(num_nodes_-1));
+    stage_left_.resize(md, dim_*(num_nodes_-1));
+    stage_right_.resize(md, dim_*(num_nodes_-1));
+    stage_rhs_.resize(md*(num_nodes_-1));
+    stage_matrix_.resize(md, md);
+
+    double t1 = grid_.nodes_[0].coordinate;
+    Eigen::VectorXd f1 = p_ode_->p_RhsFunc(t1, sol_vec_.segment(0,dim_));
+    Eigen::VectorXd f0;
+    for (int i=0; i<num_nodes_-1; i++)
+    {
+        double t0 = t1;
+        t1 = grid_.nodes_[i+1].coordinate;
+        double h = t1-t0;
+        f0.swap(f1);
+        f1 = p_ode_->p_RhsFunc(t1, sol_vec_.segment(dim_*(i+1),dim_));
+        for (int j=0; j<stages_; j++)
+        {
+            double s = lobatto_c_(j+1);
+            double s2 = s*s;
+            stage_vec_.segment(md*i+dim_*j, dim_) = ((2*s-3)*s2+1)*sol_vec_.segment(dim_*i,dim_)
+                    + ((s-2)*s+1)*s*h*f0
+                    + (3-2*s)*s2*sol_vec_.segment(dim_*(i+1),dim_)
+                    + (s-1)*s2*h*f1;
+        }
+    }
+}
+
+// The interior stage equations Z_j - y0 - h sum_k a_jk f(Y_k) = 0 are
+// linearised and solved for the stage corrections in terms of those of the
+// nodes, which leaves the last row y1 - y0 - h sum_k b_k f(Y_k) = 0 (divided
+// by h as in the trapezoidal scheme) coupling only y0 and y1.  Without the
+// jacobian the coefficients of the node corrections are kept from the last
+// assembly.
+void BoundaryValueProblem::Condense(int i, double t, double h,
+                                    const Eigen::VectorXd& y0, const Eigen::VectorXd& y1,
+                                    const Eigen::VectorXd& f0, const Eigen::VectorXd& f1,
+                                    const Eigen::MatrixXd& A0, const Eigen::MatrixXd& A1,
+                                    Eigen::VectorXd& Q, bool jacobian)
+{
+    const int d = dim_;
+    const int m = stages_;
+    const int md = m*d;
+    const int last = m+1;
+    Eigen::MatrixXd I = Eigen::MatrixXd::Identity(d,d);
+    Eigen::VectorXd F(md);
+    Eigen::MatrixXd C(d, md);
+    Eigen::VectorXd Fb = lobatto_a_(last,0)*f0 + lobatto_a_(last,last)*f1;
+    Eigen::Block<Eigen::MatrixXd> X0 = stage_left_.block(0, d*i, md, d);
+    Eigen::Block<Eigen::MatrixXd> X1 = stage_right_.block(0, d*i, md, d);
+    Eigen::VectorBlock<Eigen::VectorXd> z = stage_rhs_.segment(md*i, md);
+    for (int k=0; k<m; k++)
+    {
+        double tk = t + lobatto_c_(k+1)*h;
+        Eigen::VectorXd Zk = stage_vec_.segment(md*i+d*k, d);
+        F.segment(d*k, d) = p_ode_->p_RhsFunc(tk, Zk);
+        Eigen::MatrixXd Ak = p_ode_->p_RhsGradYFunc(tk, Zk);
+        for (int j=0; j<m; j++)
+        {
+            stage_matrix_.block(d*j, d*k, d, d) = -h*lobatto_a_(j+1,k+1)*Ak;
+        }
+        stage_matrix_.block(d*k, d*k, d, d) += I;
+        C.block(0, d*k, d, d) = lobatto_a_(last,k+1)*Ak;
+        Fb += lobatto_a_(last,k+1)*F.segment(d*k, d);
+    }
+    for (int j=0; j<m; j++)
+    {
+        Eigen::VectorXd phi = stage_vec_.segment(md*i+d*j, d) - y0 - h*(lobatto_a_(j+1,0)*f0 + lobatto_a_(j+1,last)*f1);
+        for (int k=0; k<m; k++)
+        {
+            phi -= h*lobatto_a_(j+1,k+1)*F.segment(d*k, d);
+        }
+        z.segment(d*j, d) = -phi;
+        if (jacobian)
+        {
+            X0.middleRows(d*j, d) = I + h*lobatto_a_(j+1,0)*A0;
+            X1.middleRows(d*j, d) = h*lobatto_a_(j+1,last)*A1;
+        }
+    }
+    stage_lu_.compute(stage_matrix_);
+    z = stage_lu_.solve(Eigen::VectorXd(z));
+    Q.segment(d*i, d) = Fb - (y1-y0)/h + C*z;
+
+    if (jacobian)
+    {
+        X0 = stage_lu_.solve(Eigen::MatrixXd(X0));
+        X1 = stage_lu_.solve(Eigen::MatrixXd(X1));
+        abd_.left(i) = -(1.0/h)*I - lobatto_a_(last,0)*A0 - C*X0;
+        abd_.right(i) = (1.0/h)*I - lobatto_a_(last,last)*A1 - C*X1;
+    }
+}
+
+// Error estimate of each interval from the residual of the cubic Hermite
+// interpolant of the nodal values and slopes at the midpoint.  For the
+// trapezoidal scheme the residual is O(h^2), so h times its size, relative
+// to the solution, behaves like C_i h^3.  The fourth order schemes collocate
+// the interpolant at the midpoint, so for the higher order schemes the
+// residual is taken at the quarter points instead.  It is O(h^3) there and
+// the estimate C_i h^4, which overstates the error of the sixth order scheme.
+void BoundaryValueProblem::IntervalErrors(const std::vector<Eigen::VectorXd>& slopes, std::vector<double>& err) const
+{
+    const std::vector<double> points = scheme_ == TRAPEZOIDAL ? std::vector<double>{0.5} : std::vector<double>{0.25, 0.75};
+    err.resize(num_nodes_-1);
+    for (int i=0; i<num_nodes_-1; i++)
+    {
+        double t = grid_.nodes_[i].coordinate;
+        double h = grid_.nodes_[i+1].coordinate-t;
+        Eigen::VectorXd y0 = sol_vec_.segment(dim_*i,dim_);
+        Eigen::VectorXd y1 = sol_vec_.segment(dim_*(i+1),dim_);
+        err[i] = 0;
+        for (double s : points)
+        {
+            double s2 = s*s;
+            Eigen::VectorXd ym = ((2*s-3)*s2+1)*y0 + ((s-2)*s+1)*s*h*slopes[i]
+                    + (3-2*s)*s2*y1 + (s-1)*s2*h*slopes[i+1];
+            Eigen::VectorXd dym = 6*(1-s)*s*(y1-y0)/h + ((3*s-4)*s+1)*slopes[i] + (3*s-2)*s*slopes[i+1];
+            Eigen::VectorXd r = dym - p_ode_->p_RhsFunc(t+s*h, ym);
+            err[i] = std::max(err[i], h*r.lpNorm<Eigen::Infinity>()/(1+ym.lpNorm<Eigen::Infinity>()));
         }
+    }
+}
+
+double BoundaryValueProblem::MeshError() const
+{
+    std::vector<Eigen::VectorXd> slopes(num_nodes_);
+    for (int i=0; i<num_nodes_; i++)
+    {
+        slopes[i] = p_ode_->p_RhsFunc(grid_.nodes_[i].coordinate, sol_vec_.segment(dim_*i,dim_));
+    }
+    std::vector<double> err;
+    IntervalErrors(slopes, err);
+    return *std::max_element(err.begin(), err.end());
+}
 
-        LeftMatrix.makeCompressed();
-        Q.segment(dim_*(num_nodes_-1),dim_) = beta;
+bool BoundaryValueProblem::Remesh()
+{
+    std::vector<Eigen::VectorXd> slopes(num_nodes_);
+    for (int i=0; i<num_nodes_; i++)
+    {
+        slopes[i] = p_ode_->p_RhsFunc(grid_.nodes_[i].coordinate, sol_vec_.segment(dim_*i,dim_));
+    }
+    std::vector<double> err;
+    IntervalErrors(slopes, err);
 
-        Eigen::SparseLU<Eigen::SparseMatrix<double, Eigen::ColMajor>> solver;
+    // with err_i = (phi_i h_i)^p the monitor function phi is equidistributed on
+    // the new mesh and the number of nodes chosen for err_i = tol/2 everywhere
+    const double p = scheme_ == TRAPEZOIDAL ? 3 : 4;
+    double max_err = 0;
+    double total = 0;
+    std::vector<double> density(num_nodes_-1);
+    for (int i=0; i<num_nodes_-1; i++)
+    {
+        double h = grid_.nodes_[i+1].coordinate-grid_.nodes_[i].coordinate;
+        max_err = std::max(max_err, err[i]);
+        density[i] = pow(err[i], 1/p)/h;
+        total += pow(err[i], 1/p);
+    }
+    int needed = static_cast<int>(std::ceil(total/pow(0.5*mesh_tol_, 1/p))) + 1;
+    needed = std::min(std::max(needed, MIN_NODES), max_nodes_);
+    mesh_error_ = max_err;
+    if (verbose_)
+    {
+        std::cout << "Mesh: " << num_nodes_ << " nodes, max error " << max_err << std::endl;
+    }
 
-        // Compute the ordering permutation vector from the structural pattern of A
-        solver.analyzePattern(LeftMatrix);
-        // Compute the numerical factorization
-        solver.factorize(LeftMatrix);
-        //Use the factors to solve the linear system
-        Eigen::VectorXd w = solver.solve(Q);
+    if (max_err <= mesh_tol_ ? 2*needed > num_nodes_ : num_nodes_ >= max_nodes_)
+    {
+        // accurate enough and not worth coarsening, or no more nodes allowed
+        return false;
+    }
 
-        sol_vec_ = sol_vec_+w;
+    // a floor on the density keeps smooth stretches from becoming too coarse
+    double floor = 0.05*total/(grid_.nodes_.back().coordinate-grid_.nodes_.front().coordinate);
+    for (double& d : density)
+    {
+        d = total > 0 ? d + floor : 1;
+    }
+    FiniteDifferenceGrid old_grid = grid_;
+    grid_.Equidistribute(density, needed);
 
-        if (w.norm() < ERR_TOL) return;
+    // cubic Hermite interpolation of the solution onto the new mesh
+    Eigen::VectorXd sol(needed*dim_);
+    int j = 0;
+    for (int i=0; i<needed; i++)
+    {
+        double t = grid_.nodes_[i].coordinate;
+        while (j < num_nodes_-2 && old_grid.nodes_[j+1].coordinate < t)
+        {
+            j++;
+        }
+        double t0 = old_grid.nodes_[j].coordinate;
+        double h = old_grid.nodes_[j+1].coordinate-t0;
+        double s = (t-t0)/h;
+        double s2 = s*s;
+        sol.segment(dim_*i,dim_) = ((2*s-3)*s2+1)*sol_vec_.segment(dim_*j,dim_)
+                + ((s-2)*s+1)*s*h*slopes[j]
+                + (3-2*s)*s2*sol_vec_.segment(dim_*(j+1),dim_)
+                + (s-1)*s2*h*slopes[j+1];
     }
-    return;
+    sol_vec_.swap(sol);
+    num_nodes_ = needed;
+    abd_.Resize(num_nodes_, dim_);
+    return true;
 }
 
 void BoundaryValueProblem::WriteSolutionFile()
@@ -2,12 +2,29 @@
 #define BOUNDARYVALUEPROBLEM
 
 #include "Eigen/Dense"
+#include "AlmostBlockDiagonalSolver.hpp"
 #include "DifferentialSystem.hpp"
 #include "FiniteDifferenceGrid.hpp"
 #include "Node.hpp"
 
+/* Two point boundary value problems of a DifferentialSystem on a finite
+ * difference mesh, Newton's method with the AlmostBlockDiagonalSolver.  The
+ * discretisation is one of
+ *   TRAPEZOIDAL      second order, the default
+ *   HERMITE_SIMPSON  fourth order, the midpoint stage expressed by the cubic
+ *                    Hermite interpolant of the nodes (compressed form)
+ *   LOBATTO_IIIA_3   fourth order, the same collocation with the midpoint
+ *                    stage as a Newton unknown (separated form)
+ *   LOBATTO_IIIA_4   sixth order, two interior stages
+ * The interior stages of the Lobatto schemes are condensed interval by
+ * interval, so the Newton matrix keeps its block structure over the nodes.
+ */
 class BoundaryValueProblem
 {
+    friend class PseudoArclengthContinuation;
+public:
+    enum Scheme { TRAPEZOIDAL, HERMITE_SIMPSON, LOBATTO_IIIA_3, LOBATTO_IIIA_4 };
+
 private:
     int num_nodes_;  // number of grid nodes
     int dim_;  // dimension of the system
@@ -16,9 +33,57 @@ private:
     DifferentialSystem* p_ode_;  // pointer to a system to solve
     Eigen::VectorXd sol_vec_; // pointer to the solution vector
     std::string filename_;  // allow the user to specify the output file or use a default name
+    AlmostBlockDiagonalSolver abd_;  // factorization of the Newton matrix
+
+    double newton_tol_ = ERR_TOL;  // bound on the norm of the last Newton correction
+
+    Scheme scheme_ = TRAPEZOIDAL;
+    // Lobatto IIIA coefficients and the interior stages of each interval
+    int stages_ = 0;
+    Eigen::MatrixXd lobatto_a_;
+    Eigen::VectorXd lobatto_c_;
+    Eigen::VectorXd stage_vec_;
+    // condensation of interval i, the stage correction is
+    // stage_left_ dy_i + stage_right_ dy_{i+1} + stage_rhs_
+    Eigen::MatrixXd stage_left_;
+    Eigen::MatrixXd stage_right_;
+    Eigen::VectorXd stage_rhs_;
+    Eigen::MatrixXd stage_matrix_;
+    Eigen::PartialPivLU<Eigen::MatrixXd> stage_lu_;
+
+    // mesh refinement, off while mesh_tol_ is 0
+    double mesh_tol_ = 0;
+    int max_nodes_ = 0;
+    int max_refinements_ = 0;
+    double mesh_error_ = -1;
 
-    static constexpr double ERR_TOL = 1e-1;
+    bool verbose_ = false;
+
+    static constexpr double ERR_TOL = 1e-8;
     static const int MAX_ITER = 50;
+    static const int MAX_HALVINGS = 10;
+    static const int MIN_NODES = 5;
+
+    // Newton iteration on the current mesh, returns 1 if it failed
+    int Newton();
+    // Newton right hand side Q (minus the residual) at sol_vec_, with the
+    // jacobian also the blocks of abd_
+    void Assemble(Eigen::VectorXd& Q, bool jacobian);
+    // applies the node correction w, and the stage corrections of the last assembly
+    void Correct(const Eigen::VectorXd& w);
+    // stages from the cubic Hermite interpolant of the nodes
+    void InitStages();
+    // blocks and right hand side of interval i for the Lobatto schemes
+    void Condense(int i, double t, double h,
+                  const Eigen::VectorXd& y0, const Eigen::VectorXd& y1,
+                  const Eigen::VectorXd& f0, const Eigen::VectorXd& f1,
+                  const Eigen::MatrixXd& A0, const Eigen::MatrixXd& A1,
+                  Eigen::VectorXd& Q, bool jacobian);
+    void IntervalErrors(const std::vector<Eigen::VectorXd>& slopes, std::vector<double>& err) const;
+    // largest interval error estimate of the current solution
+    double MeshError() const;
+    // new mesh with the solution interpolated onto it, false if the current one is kept
+    bool Remesh();
 
 public:
     BoundaryValueProblem(DifferentialSystem *p_ode, int num_nodes, int dim);
@@ -27,13 +92,32 @@ public:
     {
         filename_ = name;
     }
-    void Solve();
+    void SetNewtonTolerance(double tol);
+    void SetScheme(Scheme scheme);
+    // node values one after the other, zero by default
+    void SetInitialGuess(const Eigen::VectorXd& sol);
+    // after each Newton solve the nodes are redistributed and their number
+    // adapted until the estimated error of every interval is below tol
+    void SetMeshRefinement(double tol, int max_nodes, int max_refinements = 10);
+
+    // Newton iterations and mesh sizes on std::cout, off by default
+    void SetVerbose(bool verbose);
+
+    // returns 1 if Newton failed, 2 if the mesh refinement ran out of nodes or
+    // refinements before the error estimate met its tolerance (the solution
+    // on the last mesh is kept, see mesh_error()) and 0 otherwise
+    int Solve();
     double Step(int i);
     void WriteSolutionFile();
     Eigen::VectorXd sol_vec() const
     {
         return sol_vec_;
     }
+    // node coordinates belonging to sol_vec()
+    Eigen::VectorXd mesh() const;
+    // largest interval error estimate of the last solution with mesh
+    // refinement, -1 without it
+    double mesh_error() const;
 };
 
 #endif
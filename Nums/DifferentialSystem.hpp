@@ -6,6 +6,7 @@
 class DifferentialSystem
 {
    friend class BoundaryValueProblem;
+   friend class MultipleShootingSolver;
 private:
    // Eigen::MatrixXd coeffs_;     // Coefficient matrix of the ODE system
    Eigen::VectorXd (*p_RhsFunc)(double t, const Eigen::VectorXd& y);  // Function on RHS of ODE
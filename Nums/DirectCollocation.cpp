@@ -0,0 +1,839 @@
+#include "DirectCollocation.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+typedef Eigen::Triplet<double> Triplet;
+
+DirectCollocation::DirectCollocation(OptimalControlProblem* p_problem, int num_nodes)
+    : grid_(num_nodes, 0, 1)
+{
+    assert(num_nodes >= 2);
+    p_problem_ = p_problem;
+    num_nodes_ = num_nodes;
+    n_ = p_problem->num_states();
+    m_ = p_problem->num_controls();
+    num_path_ = p_problem->num_path();
+    tau_ = grid_.coordinates();
+    x_scale_ = Eigen::VectorXd::Ones(n_);
+    u_scale_ = Eigen::VectorXd::Ones(m_);
+    Transcribe();
+    SetScale();
+    sol_ = Eigen::VectorXd::Zero(num_vars_);
+    sol_(time_index()) = tf_;
+}
+
+int DirectCollocation::x_index(int j) const
+{
+    return j*(n_+m_);
+}
+
+int DirectCollocation::u_index(int j) const
+{
+    return j*(n_+m_) + n_;
+}
+
+int DirectCollocation::midpoint_index(int i) const
+{
+    return num_nodes_*(n_+m_) + i*m_;
+}
+
+int DirectCollocation::time_index() const
+{
+    return num_vars_ - 1;
+}
+
+void DirectCollocation::Transcribe()
+{
+    const int N = num_nodes_;
+    const int nb = p_problem_->num_boundary();
+    num_vars_ = N*(n_+m_) + (N-1)*m_ + 1;
+    const int num_bounds = tf_max_ < HUGE_VAL ? 2 : 1;
+    num_eq_ = (N-1)*n_ + nb + (free_time_ ? 0 : 1);
+    num_ineq_ = (2*N-1)*num_path_ + (free_time_ ? num_bounds : 0);
+    elements_.clear();
+
+    for (int i=0; i<N-1; i++)
+    {
+        Element e = {INTERVAL_ELEMENT, i, std::vector<int>(), i*n_, n_, (N+i)*num_path_, num_path_};
+        for (int k=0; k<n_+m_; k++) e.vars.push_back(x_index(i) + k);
+        for (int k=0; k<m_; k++) e.vars.push_back(midpoint_index(i) + k);
+        for (int k=0; k<n_+m_; k++) e.vars.push_back(x_index(i+1) + k);
+        e.vars.push_back(time_index());
+        elements_.push_back(e);
+    }
+    if (num_path_ > 0)
+    {
+        for (int j=0; j<N; j++)
+        {
+            Element e = {NODE_ELEMENT, j, std::vector<int>(), 0, 0, j*num_path_, num_path_};
+            for (int k=0; k<n_+m_; k++) e.vars.push_back(x_index(j) + k);
+            elements_.push_back(e);
+        }
+    }
+
+    Element bc = {BOUNDARY_ELEMENT, 0, std::vector<int>(), (N-1)*n_, nb, 0, 0};
+    for (int k=0; k<n_; k++) bc.vars.push_back(x_index(0) + k);
+    for (int k=0; k<n_; k++) bc.vars.push_back(x_index(N-1) + k);
+    bc.vars.push_back(time_index());
+    elements_.push_back(bc);
+
+    // fixed final time or its bounds
+    if (free_time_)
+    {
+        Element e = {TIME_ELEMENT, 0, std::vector<int>(1, time_index()), 0, 0, (2*N-1)*num_path_, num_bounds};
+        elements_.push_back(e);
+    }
+    else
+    {
+        Element e = {TIME_ELEMENT, 0, std::vector<int>(1, time_index()), (N-1)*n_ + nb, 1, 0, 0};
+        elements_.push_back(e);
+    }
+
+    Element cost = {COST_ELEMENT, 0, std::vector<int>(), 0, 0, 0, 0};
+    for (int k=0; k<n_; k++) cost.vars.push_back(x_index(N-1) + k);
+    cost.vars.push_back(time_index());
+    elements_.push_back(cost);
+}
+
+void DirectCollocation::SetScale()
+{
+    scale_.resize(num_vars_);
+    for (int j=0; j<num_nodes_; j++)
+    {
+        scale_.segment(x_index(j), n_) = x_scale_;
+        scale_.segment(u_index(j), m_) = u_scale_;
+        if (j < num_nodes_-1)
+        {
+            scale_.segment(midpoint_index(j), m_) = u_scale_;
+        }
+    }
+    scale_(time_index()) = t_scale_;
+}
+
+void DirectCollocation::SetScaling(const Eigen::VectorXd& x_scale, const Eigen::VectorXd& u_scale, double t_scale)
+{
+    assert(x_scale.size() == n_ && u_scale.size() == m_);
+    x_scale_ = x_scale;
+    u_scale_ = u_scale;
+    t_scale_ = t_scale;
+    SetScale();
+}
+
+void DirectCollocation::SetFinalTime(double tf, bool free)
+{
+    tf_ = tf;
+    sol_(time_index()) = tf;
+    if (free != free_time_)
+    {
+        free_time_ = free;
+        Transcribe();
+    }
+}
+
+void DirectCollocation::SetTimeBounds(double tf_min, double tf_max)
+{
+    tf_min_ = tf_min;
+    tf_max_ = tf_max;
+    Transcribe();
+}
+
+void DirectCollocation::SetTolerance(double tol)
+{
+    tol_ = tol;
+}
+
+void DirectCollocation::SetInitialGuess(const Eigen::MatrixXd& states, const Eigen::MatrixXd& controls)
+{
+    assert(states.rows() == num_nodes_ && states.cols() == n_);
+    assert(controls.rows() == num_nodes_ && controls.cols() == m_);
+    for (int j=0; j<num_nodes_; j++)
+    {
+        sol_.segment(x_index(j), n_) = states.row(j).transpose();
+        sol_.segment(u_index(j), m_) = controls.row(j).transpose();
+        if (j < num_nodes_-1)
+        {
+            sol_.segment(midpoint_index(j), m_) = 0.5*(controls.row(j) + controls.row(j+1)).transpose();
+        }
+    }
+}
+
+void DirectCollocation::EvaluateElement(const Element& e, const Eigen::VectorXd& zl,
+                                        Eigen::VectorXd& out, Eigen::MatrixXd* jac)
+{
+    const int nl = e.vars.size();
+    const int n = n_;
+    const int m = m_;
+    Eigen::VectorXd sl(nl);
+    for (int k=0; k<nl; k++)
+    {
+        sl(k) = scale_(e.vars[k]);
+    }
+    Eigen::VectorXd p = sl.cwiseProduct(zl);
+    out.resize(e.type == COST_ELEMENT ? 1 : e.num_c + e.num_g);
+    if (jac)
+    {
+        jac->setZero(out.size(), nl);
+    }
+
+    switch (e.type)
+    {
+    case INTERVAL_ELEMENT:
+    {
+        // local unknowns x_i, u_i, u_m, x_{i+1}, u_{i+1}, tf
+        const int a = 0, b = n, c = n+m, d = n+2*m, ue = 2*n+2*m, t = 2*n+3*m;
+        Eigen::VectorXd x0 = p.segment(a, n), u0 = p.segment(b, m), um = p.segment(c, m);
+        Eigen::VectorXd x1 = p.segment(d, n), u1 = p.segment(ue, m);
+        double dtau = tau_(e.index+1) - tau_(e.index);
+        double h = p(t)*dtau;
+        Eigen::VectorXd f0, f1, fm, gm;
+        p_problem_->Dynamics(x0, u0, f0);
+        p_problem_->Dynamics(x1, u1, f1);
+        Eigen::VectorXd xm = 0.5*(x0 + x1) + h/8*(f0 - f1);
+        p_problem_->Dynamics(xm, um, fm);
+        Eigen::VectorXd slope = f0 + 4*fm + f1;
+        out.head(n) = (x1 - x0 - h/6*slope).cwiseQuotient(x_scale_);
+        if (num_path_ > 0)
+        {
+            p_problem_->Path(xm, um, gm);
+            out.tail(num_path_) = gm;
+        }
+        if (!jac)
+        {
+            break;
+        }
+
+        Eigen::MatrixXd A0, B0, A1, B1, Am, Bm;
+        p_problem_->DynamicsJacobian(x0, u0, A0, B0);
+        p_problem_->DynamicsJacobian(x1, u1, A1, B1);
+        p_problem_->DynamicsJacobian(xm, um, Am, Bm);
+        Eigen::MatrixXd I = Eigen::MatrixXd::Identity(n, n);
+        Eigen::MatrixXd dxm = Eigen::MatrixXd::Zero(n, nl);
+        dxm.block(0, a, n, n) = 0.5*I + h/8*A0;
+        dxm.block(0, b, n, m) = h/8*B0;
+        dxm.block(0, d, n, n) = 0.5*I - h/8*A1;
+        dxm.block(0, ue, n, m) = -h/8*B1;
+        dxm.col(t) = dtau/8*(f0 - f1);
+        Eigen::MatrixXd dfm = Am*dxm;
+        dfm.block(0, c, n, m) += Bm;
+
+        Eigen::Block<Eigen::MatrixXd> J = jac->topRows(n);
+        J = -2*h/3*dfm;
+        J.block(0, a, n, n) -= I + h/6*A0;
+        J.block(0, b, n, m) -= h/6*B0;
+        J.block(0, d, n, n) += I - h/6*A1;
+        J.block(0, ue, n, m) -= h/6*B1;
+        J.col(t) -= dtau/6*slope;
+        J = x_scale_.cwiseInverse().asDiagonal()*J;
+        if (num_path_ > 0)
+        {
+            Eigen::MatrixXd Gx, Gu;
+            p_problem_->PathJacobian(xm, um, Gx, Gu);
+            jac->bottomRows(num_path_) = Gx*dxm;
+            jac->block(n, c, num_path_, m) += Gu;
+        }
+        break;
+    }
+    case NODE_ELEMENT:
+    {
+        Eigen::VectorXd g;
+        p_problem_->Path(p.head(n), p.tail(m), g);
+        out = g;
+        if (jac)
+        {
+            Eigen::MatrixXd Gx, Gu;
+            p_problem_->PathJacobian(p.head(n), p.tail(m), Gx, Gu);
+            jac->leftCols(n) = Gx;
+            jac->rightCols(m) = Gu;
+        }
+        break;
+    }
+    case BOUNDARY_ELEMENT:
+    {
+        Eigen::VectorXd psi;
+        p_problem_->Boundary(p.head(n), p.segment(n, n), p(2*n), psi);
+        out = psi;
+        if (jac)
+        {
+            Eigen::MatrixXd P0, Pf;
+            Eigen::VectorXd Pt;
+            p_problem_->BoundaryJacobian(p.head(n), p.segment(n, n), p(2*n), P0, Pf, Pt);
+            jac->leftCols(n) = P0;
+            jac->middleCols(n, n) = Pf;
+            jac->col(2*n) = Pt;
+        }
+        break;
+    }
+    case TIME_ELEMENT:
+        if (e.num_c > 0)
+        {
+            out(0) = (p(0) - tf_)/t_scale_;
+        }
+        else
+        {
+            out(0) = (tf_min_ - p(0))/t_scale_;
+            if (e.num_g > 1)
+            {
+                out(1) = (p(0) - tf_max_)/t_scale_;
+            }
+        }
+        if (jac)
+        {
+            (*jac)(0, 0) = e.num_c > 0 ? 1 : -1;
+            if (e.num_g > 1)
+            {
+                (*jac)(1, 0) = 1;
+            }
+            *jac /= t_scale_;
+        }
+        break;
+    case COST_ELEMENT:
+        out(0) = p_problem_->Cost(p.head(n), p(n));
+        if (jac)
+        {
+            Eigen::VectorXd phi_x;
+            double phi_t;
+            p_problem_->CostGradient(p.head(n), p(n), phi_x, phi_t);
+            jac->block(0, 0, 1, n) = phi_x.transpose();
+            (*jac)(0, n) = phi_t;
+        }
+        break;
+    }
+
+    if (jac)
+    {
+        *jac = (*jac)*sl.asDiagonal();
+    }
+}
+
+void DirectCollocation::Evaluate(const Eigen::VectorXd& z, double& f, Eigen::VectorXd& c, Eigen::VectorXd& g)
+{
+    f = 0;
+    c.resize(num_eq_);
+    g.resize(num_ineq_);
+    Eigen::VectorXd zl, out;
+    for (size_t k=0; k<elements_.size(); k++)
+    {
+        const Element& e = elements_[k];
+        zl.resize(e.vars.size());
+        for (size_t l=0; l<e.vars.size(); l++)
+        {
+            zl(l) = z(e.vars[l]);
+        }
+        EvaluateElement(e, zl, out, 0);
+        if (e.type == COST_ELEMENT)
+        {
+            f += out(0);
+            continue;
+        }
+        c.segment(e.c_row, e.num_c) = out.head(e.num_c);
+        g.segment(e.g_row, e.num_g) = out.tail(e.num_g);
+    }
+}
+
+void DirectCollocation::EvaluateJacobians(const Eigen::VectorXd& z, Eigen::VectorXd& grad,
+                                          Eigen::SparseMatrix<double>& Jc, Eigen::SparseMatrix<double>& Jg)
+{
+    std::vector<Triplet> tc, tg;
+    grad = Eigen::VectorXd::Zero(num_vars_);
+    Eigen::VectorXd zl, out;
+    Eigen::MatrixXd jac;
+    for (size_t k=0; k<elements_.size(); k++)
+    {
+        const Element& e = elements_[k];
+        const int nl = e.vars.size();
+        zl.resize(nl);
+        for (int l=0; l<nl; l++)
+        {
+            zl(l) = z(e.vars[l]);
+        }
+        EvaluateElement(e, zl, out, &jac);
+        for (int l=0; l<nl; l++)
+        {
+            if (e.type == COST_ELEMENT)
+            {
+                grad(e.vars[l]) += jac(0, l);
+                continue;
+            }
+            for (int r=0; r<e.num_c; r++)
+            {
+                tc.push_back(Triplet(e.c_row + r, e.vars[l], jac(r, l)));
+            }
+            for (int r=0; r<e.num_g; r++)
+            {
+                tg.push_back(Triplet(e.g_row + r, e.vars[l], jac(e.num_c + r, l)));
+            }
+        }
+    }
+    Jc.resize(num_eq_, num_vars_);
+    Jc.setFromTriplets(tc.begin(), tc.end());
+    Jg.resize(num_ineq_, num_vars_);
+    Jg.setFromTriplets(tg.begin(), tg.end());
+}
+
+void DirectCollocation::Hessian(const Eigen::VectorXd& z, const Eigen::VectorXd& y, const Eigen::VectorXd& w,
+                                std::vector<Triplet>& triplets)
+{
+    Eigen::VectorXd zl, out, weights, grad0;
+    Eigen::MatrixXd jac, H;
+    for (size_t k=0; k<elements_.size(); k++)
+    {
+        const Element& e = elements_[k];
+        const int nl = e.vars.size();
+        if (e.type == TIME_ELEMENT)
+        {
+            continue;
+        }
+        if (e.type == COST_ELEMENT)
+        {
+            weights = Eigen::VectorXd::Ones(1);
+        }
+        else
+        {
+            weights.resize(e.num_c + e.num_g);
+            weights << y.segment(e.c_row, e.num_c), w.segment(e.g_row, e.num_g);
+        }
+        zl.resize(nl);
+        for (int l=0; l<nl; l++)
+        {
+            zl(l) = z(e.vars[l]);
+        }
+        EvaluateElement(e, zl, out, &jac);
+        grad0 = jac.transpose()*weights;
+        H.resize(nl, nl);
+        for (int l=0; l<nl; l++)
+        {
+            double save = zl(l);
+            double delta = 1e-7*std::max(1.0, std::abs(save));
+            zl(l) += delta;
+            EvaluateElement(e, zl, out, &jac);
+            H.col(l) = (jac.transpose()*weights - grad0)/delta;
+            zl(l) = save;
+        }
+        for (int l=0; l<nl; l++)
+        {
+            for (int r=0; r<nl; r++)
+            {
+                triplets.push_back(Triplet(e.vars[r], e.vars[l], 0.5*(H(r, l) + H(l, r))));
+            }
+        }
+    }
+}
+
+int DirectCollocation::FactorizeKkt(const Eigen::SparseMatrix<double>& W,
+                                    const Eigen::SparseMatrix<double>& Jc, double delta)
+{
+    const int nz = num_vars_;
+    const int nc = num_eq_;
+    std::vector<Triplet> triplets;
+    triplets.reserve(W.nonZeros() + 2*Jc.nonZeros() + nz + nc);
+    for (int k=0; k<W.outerSize(); k++)
+    {
+        for (Eigen::SparseMatrix<double>::InnerIterator it(W, k); it; ++it)
+        {
+            triplets.push_back(Triplet(it.row(), it.col(), it.value()));
+        }
+    }
+    for (int k=0; k<Jc.outerSize(); k++)
+    {
+        for (Eigen::SparseMatrix<double>::InnerIterator it(Jc, k); it; ++it)
+        {
+            triplets.push_back(Triplet(nz + it.row(), it.col(), it.value()));
+            triplets.push_back(Triplet(it.col(), nz + it.row(), it.value()));
+        }
+    }
+    for (int k=0; k<nz; k++)
+    {
+        triplets.push_back(Triplet(k, k, delta));
+    }
+    for (int k=0; k<nc; k++)
+    {
+        triplets.push_back(Triplet(nz+k, nz+k, -DELTA_C));
+    }
+    kkt_.resize(nz+nc, nz+nc);
+    kkt_.setFromTriplets(triplets.begin(), triplets.end());
+    if (kkt_.nonZeros() != kkt_nonzeros_)
+    {
+        kkt_ldlt_.analyzePattern(kkt_);
+        kkt_nonzeros_ = kkt_.nonZeros();
+    }
+    kkt_ldlt_.factorize(kkt_);
+    if (kkt_ldlt_.info() != Eigen::Success)
+    {
+        return 1;
+    }
+    // inertia (nz, nc, 0)
+    const Eigen::VectorXd& D = kkt_ldlt_.vectorD();
+    return (D.array() > 0).count() == nz && (D.array() < 0).count() == nc ? 0 : 1;
+}
+
+bool DirectCollocation::FilterAcceptable(double theta, double phi) const
+{
+    for (size_t k=0; k<filter_.size(); k++)
+    {
+        if (theta >= filter_[k].first && phi >= filter_[k].second)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+// largest step in (0, 1] keeping v + alpha dv >= (1 - tau) v
+static double FractionToBoundary(const Eigen::VectorXd& v, const Eigen::VectorXd& dv, double tau)
+{
+    double alpha = 1;
+    for (int k=0; k<v.size(); k++)
+    {
+        if (dv(k) < 0)
+        {
+            alpha = std::min(alpha, -tau*v(k)/dv(k));
+        }
+    }
+    return alpha;
+}
+
+void DirectCollocation::LeastSquaresMultipliers(const Eigen::VectorXd& grad, const Eigen::SparseMatrix<double>& Jc,
+                                                const Eigen::SparseMatrix<double>& Jg, const Eigen::VectorXd& w,
+                                                Eigen::VectorXd& y)
+{
+    const int nz = num_vars_;
+    const int nc = num_eq_;
+    y = Eigen::VectorXd::Zero(nc);
+    Eigen::SparseMatrix<double> W(nz, nz);
+    if (FactorizeKkt(W, Jc, 1) != 0)
+    {
+        return;
+    }
+    Eigen::VectorXd rhs(nz+nc);
+    rhs.head(nz) = -grad - Jg.transpose()*w;
+    rhs.tail(nc).setZero();
+    Eigen::VectorXd sol = kkt_ldlt_.solve(rhs);
+    if (sol.allFinite() && sol.tail(nc).lpNorm<Eigen::Infinity>() <= 1e3)
+    {
+        y = sol.tail(nc);
+    }
+}
+
+int DirectCollocation::Restore(Eigen::VectorXd& z, Eigen::VectorXd& s, double mu)
+{
+    const int nz = num_vars_;
+    const int ng = num_ineq_;
+    double f, ft;
+    Eigen::VectorXd c, g, grad, ct, gt, zt;
+    Eigen::SparseMatrix<double> Jc, Jg;
+    Eigen::SparseMatrix<double> I(nz, nz);
+    I.setIdentity();
+    Eigen::SimplicialLDLT<Eigen::SparseMatrix<double> > ldlt;
+    Evaluate(z, f, c, g);
+    const double theta_ref = c.lpNorm<1>() + (g + s).lpNorm<1>();
+    // the inequalities are restored to g <= -mu, where their slacks need not
+    // add to the violation
+    double theta = c.squaredNorm() + (g.array() + mu).cwiseMax(0).matrix().squaredNorm();
+    double lambda = RESTORATION_WEIGHT;
+    for (int k=0; k<MAX_RESTORATION; k++)
+    {
+        // Levenberg-Marquardt step for c = 0 and the violated inequalities
+        EvaluateJacobians(z, grad, Jc, Jg);
+        Eigen::VectorXd active(ng);
+        for (int l=0; l<ng; l++)
+        {
+            active(l) = g(l) + mu > 0 ? 1 : 0;
+        }
+        Eigen::SparseMatrix<double> JtJ = Jc.transpose()*Jc;
+        JtJ += Eigen::SparseMatrix<double>(Jg.transpose()*active.asDiagonal()*Jg);
+        Eigen::VectorXd rhs = -Jc.transpose()*c - Jg.transpose()*active.cwiseProduct((g.array() + mu).matrix());
+        bool accepted = false;
+        while (!accepted && lambda < 1e20)
+        {
+            ldlt.compute(JtJ + lambda*I);
+            if (ldlt.info() == Eigen::Success)
+            {
+                zt = z + ldlt.solve(rhs);
+                Evaluate(zt, ft, ct, gt);
+                double theta_t = ct.squaredNorm() + (gt.array() + mu).cwiseMax(0).matrix().squaredNorm();
+                if (std::isfinite(theta_t) && theta_t < theta)
+                {
+                    accepted = true;
+                    theta = theta_t;
+                    lambda = std::max(1e-8, lambda/3);
+                    continue;
+                }
+            }
+            lambda *= 10;
+        }
+        if (!accepted)
+        {
+            return 1;
+        }
+        z = zt;
+        f = ft;
+        c = ct;
+        g = gt;
+
+        // slacks of the satisfied inequalities are -g, the others small
+        Eigen::VectorXd st = (-g).cwiseMax(mu);
+        double theta_s = c.lpNorm<1>() + (g + st).lpNorm<1>();
+        if (theta_s <= 0.9*theta_ref && FilterAcceptable(theta_s, f - mu*st.array().log().sum()))
+        {
+            s = st;
+            return 0;
+        }
+    }
+    return 1;
+}
+
+int DirectCollocation::Solve()
+{
+    const int nz = num_vars_;
+    const int nc = num_eq_;
+    const int ng = num_ineq_;
+    Eigen::VectorXd z = sol_.cwiseQuotient(scale_);
+    double f;
+    Eigen::VectorXd c, g, grad;
+    Eigen::SparseMatrix<double> Jc, Jg, W(nz, nz);
+    Evaluate(z, f, c, g);
+    EvaluateJacobians(z, grad, Jc, Jg);
+    kkt_nonzeros_ = -1;
+
+    // barrier parameter, slacks and multipliers
+    double mu = 0.1;
+    Eigen::VectorXd s = (-g).cwiseMax(0.1);
+    Eigen::VectorXd w = mu*s.cwiseInverse();
+    Eigen::VectorXd y = Eigen::VectorXd::Zero(nc);
+    Eigen::VectorXd rhs(nz+nc), sol, dz, dy, dy_soc, ds, dw, sigma, rd, rg;
+    Eigen::VectorXd zt, st, ct, gt;
+    double ft;
+
+    LeastSquaresMultipliers(grad, Jc, Jg, w, y);
+
+    // filter line search of Waechter and Biegler
+    const double eta = 1e-4;
+    const double s_theta = 1.1;
+    const double s_phi = 2.3;
+    filter_.clear();
+    double theta = c.lpNorm<1>() + (g + s).lpNorm<1>();
+    const double theta_max = 1e4*std::max(1.0, theta);
+    const double theta_min = 1e-4*std::max(1.0, theta);
+    double delta_last = 0;
+
+    int status = 1;
+    for (iterations_=0; iterations_<MAX_ITER; iterations_++)
+    {
+        rd = grad + Jc.transpose()*y + Jg.transpose()*w;
+        rg = g + s;
+        double sd = std::max(100.0, (y.lpNorm<1>() + w.lpNorm<1>())/std::max(1, nc+ng))/100;
+        double dual = rd.lpNorm<Eigen::Infinity>()/sd;
+        double primal = std::max(c.lpNorm<Eigen::Infinity>(), ng > 0 ? rg.lpNorm<Eigen::Infinity>() : 0.0);
+        double err = std::max(std::max(dual, primal), ng > 0 ? s.cwiseProduct(w).lpNorm<Eigen::Infinity>()/sd : 0.0);
+        if (err <= tol_)
+        {
+            status = 0;
+            break;
+        }
+        // Fiacco-McCormick: decrease mu once the barrier problem is solved to 10 mu
+        while (mu > tol_/10)
+        {
+            double err_mu = std::max(std::max(dual, primal), ng > 0 ?
+                (s.cwiseProduct(w).array() - mu).matrix().lpNorm<Eigen::Infinity>()/sd : 0.0);
+            if (err_mu > 10*mu)
+            {
+                break;
+            }
+            mu = std::max(tol_/10, std::min(0.2*mu, std::pow(mu, 1.5)));
+            filter_.clear();
+        }
+
+        // inertia correction: raise delta until the step has positive curvature
+        std::vector<Triplet> triplets;
+        Hessian(z, y, w, triplets);
+        W.setFromTriplets(triplets.begin(), triplets.end());
+        sigma = w.cwiseQuotient(s);
+        W += Eigen::SparseMatrix<double>(Jg.transpose()*sigma.asDiagonal()*Jg);
+        rhs.head(nz) = -rd - Jg.transpose()*sigma.cwiseProduct(g + mu*w.cwiseInverse());
+        rhs.tail(nc) = -c;
+        double delta = 0;
+        while (true)
+        {
+            if (FactorizeKkt(W, Jc, delta) == 0)
+            {
+                sol = kkt_ldlt_.solve(rhs);
+                dz = sol.head(nz);
+                if (sol.allFinite())
+                {
+                    break;
+                }
+            }
+            delta = delta == 0 ? (delta_last == 0 ? 1e-4 : std::max(1e-20, delta_last/3)) : 8*delta;
+            if (delta > 1e40)
+            {
+                sol_ = z.cwiseProduct(scale_);
+                return 1;
+            }
+        }
+        if (delta > 0)
+        {
+            delta_last = delta;
+        }
+        dy = sol.tail(nc);
+        ds = -rg - Jg*dz;
+        dw = sigma.cwiseProduct(Jg*dz + g + mu*w.cwiseInverse());
+
+        double tau = std::max(0.99, 1 - mu);
+        double alpha_s = FractionToBoundary(s, ds, tau);
+        double alpha_w = FractionToBoundary(w, dw, tau);
+
+        theta = c.lpNorm<1>() + rg.lpNorm<1>();
+        double phi = f - mu*s.array().log().sum();
+        double dphi = grad.dot(dz) - mu*ds.cwiseQuotient(s).sum();
+        double alpha_min = GAMMA_THETA;
+        if (dphi < 0)
+        {
+            alpha_min = std::min(alpha_min, GAMMA_PHI*theta/(-dphi));
+            if (theta <= theta_min)
+            {
+                alpha_min = std::min(alpha_min, std::pow(theta, s_theta)/std::pow(-dphi, s_phi));
+            }
+        }
+        alpha_min *= 0.05;
+
+        double alpha = alpha_s;
+        // major step limit: no unknown moves by more than STEP_LIMIT (1 + |z_k|)
+        for (int k=0; k<nz; k++)
+        {
+            if (std::abs(dz(k)) > STEP_LIMIT*(1 + std::abs(z(k)))/alpha)
+            {
+                alpha = STEP_LIMIT*(1 + std::abs(z(k)))/std::abs(dz(k));
+            }
+        }
+        double alpha_y = alpha;
+        bool accepted = false;
+        bool corrected = false;
+        bool armijo = false;
+        for (int k=0; k<MAX_BACKTRACKS && alpha >= alpha_min && !accepted; k++, alpha *= 0.5)
+        {
+            bool switching = dphi < 0 && alpha*std::pow(-dphi, s_phi) > std::pow(theta, s_theta);
+            armijo = switching && theta <= theta_min;
+            // the trial point and, on the first rejection with a larger
+            // violation, the second order correction
+            for (int soc=0; soc<2 && !accepted; soc++)
+            {
+                if (soc == 0)
+                {
+                    zt = z + alpha*dz;
+                    st = s + alpha*ds;
+                    alpha_y = alpha;
+                }
+                else
+                {
+                    if (k > 0 || ct.lpNorm<1>() + (gt + st).lpNorm<1>() < theta)
+                    {
+                        break;
+                    }
+                    Eigen::VectorXd c_soc = alpha*c + ct;
+                    Eigen::VectorXd rg_soc = alpha*rg + gt + st;
+                    rhs.head(nz) = -rd - Jg.transpose()*sigma.cwiseProduct(rg_soc - s + mu*w.cwiseInverse());
+                    rhs.tail(nc) = -c_soc;
+                    sol = kkt_ldlt_.solve(rhs);
+                    Eigen::VectorXd ds_soc = -rg_soc - Jg*sol.head(nz);
+                    double alpha_soc = FractionToBoundary(s, ds_soc, tau);
+                    zt = z + alpha_soc*sol.head(nz);
+                    st = s + alpha_soc*ds_soc;
+                    dy_soc = sol.tail(nc);
+                    alpha_y = alpha_soc;
+                }
+                Evaluate(zt, ft, ct, gt);
+                double theta_t = ct.lpNorm<1>() + (gt + st).lpNorm<1>();
+                double phi_t = ft - mu*st.array().log().sum();
+                if (!std::isfinite(phi_t) || !std::isfinite(theta_t) || theta_t > theta_max
+                    || !FilterAcceptable(theta_t, phi_t))
+                {
+                    continue;
+                }
+                accepted = armijo ? phi_t <= phi + eta*alpha*dphi
+                                  : theta_t <= (1 - GAMMA_THETA)*theta || phi_t <= phi - GAMMA_PHI*theta;
+                corrected = accepted && soc == 1;
+            }
+            if (accepted)
+            {
+                break;
+            }
+        }
+        if (!armijo || !accepted)
+        {
+            filter_.push_back(std::make_pair((1 - GAMMA_THETA)*theta, phi - GAMMA_PHI*theta));
+        }
+        if (!accepted)
+        {
+            if (Restore(z, s, mu) != 0)
+            {
+                break;
+            }
+            Evaluate(z, f, c, g);
+            EvaluateJacobians(z, grad, Jc, Jg);
+            w = mu*s.cwiseInverse();
+            LeastSquaresMultipliers(grad, Jc, Jg, w, y);
+            continue;
+        }
+
+        z = zt;
+        s = st;
+        f = ft;
+        c = ct;
+        g = gt;
+        // the corrected step comes with its own multiplier step
+        y += alpha_y*(corrected ? dy_soc : dy);
+        w += alpha_w*dw;
+        // keep the multipliers near the central path
+        for (int k=0; k<ng; k++)
+        {
+            w(k) = std::max(std::min(w(k), 1e10*mu/s(k)), 1e-10*mu/s(k));
+        }
+        EvaluateJacobians(z, grad, Jc, Jg);
+    }
+
+    sol_ = z.cwiseProduct(scale_);
+    y_ = y;
+    return status;
+}
+
+double DirectCollocation::final_time() const
+{
+    return sol_(time_index());
+}
+
+Eigen::VectorXd DirectCollocation::mesh() const
+{
+    return final_time()*tau_;
+}
+
+Eigen::MatrixXd DirectCollocation::states() const
+{
+    Eigen::MatrixXd x(num_nodes_, n_);
+    for (int j=0; j<num_nodes_; j++)
+    {
+        x.row(j) = sol_.segment(x_index(j), n_).transpose();
+    }
+    return x;
+}
+
+Eigen::MatrixXd DirectCollocation::controls() const
+{
+    Eigen::MatrixXd u(num_nodes_, m_);
+    for (int j=0; j<num_nodes_; j++)
+    {
+        u.row(j) = sol_.segment(u_index(j), m_).transpose();
+    }
+    return u;
+}
+
+Eigen::VectorXd DirectCollocation::defect_multipliers() const
+{
+    return y_.size() == num_eq_ ? Eigen::VectorXd(y_.head((num_nodes_-1)*n_)) : Eigen::VectorXd();
+}
+
+int DirectCollocation::iterations() const
+{
+    return iterations_;
+}
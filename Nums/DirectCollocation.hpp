@@ -0,0 +1,165 @@
+#ifndef DIRECTCOLLOCATION_H
+#define DIRECTCOLLOCATION_H
+
+#include <cmath>
+#include <utility>
+#include <vector>
+#include "Eigen/Dense"
+#include "Eigen/Sparse"
+#include "Eigen/SparseCholesky"
+#include "FiniteDifferenceGrid.hpp"
+#include "OptimalControlProblem.hpp"
+
+/* Direct transcription of an OptimalControlProblem: states and controls on
+ * the nodes of a FiniteDifferenceGrid over the scaled time tau = t/tf in
+ * [0, 1], an extra control at every interval midpoint, and the dynamics
+ * imposed by the compressed Hermite-Simpson defects of BoundaryValueProblem
+ *   x_m  = (x_i + x_{i+1})/2 + h/8 (f_i - f_{i+1})
+ *   zeta = x_{i+1} - x_i - h/6 (f_i + 4 f(x_m, u_m) + f_{i+1}) = 0
+ * The path constraints hold at the nodes and the midpoints; the final time is
+ * an unknown unless fixed.
+ *
+ * The nonlinear program is solved with a primal-dual interior point method
+ * after IPOPT (Waechter and Biegler 2006): slacks for the inequalities, a log
+ * barrier with the Fiacco-McCormick update, the fraction to the boundary rule
+ * and a filter line search with second order corrections; when the line
+ * search fails, Levenberg-Marquardt steps on the constraint violation restore
+ * a point acceptable to the filter.  Every constraint depends only on the
+ * variables of one interval, of the boundary or of a node, so the Jacobians
+ * and the Hessian of the Lagrangian are assembled from small dense element
+ * blocks as triplets; the element Hessians are forward differences of the
+ * analytic element Jacobians.  The reduced KKT system
+ *   [H + Jg^T S^-1 W Jg + dw I    Jc^T ] [dz]
+ *   [Jc                          -dc I ] [dy]
+ * is factorized with a sparse LDL^T whose pivots give its inertia; dw is
+ * raised until the step is a descent direction of the barrier problem.  As
+ * the major step limit of SNOPT, no unknown moves by more than half its
+ * magnitude (plus one) in a step, which keeps poor guesses from jumping to
+ * another basin.
+ *
+ * The unknowns are scaled, x = x_scale z, so that they are of order one.
+ */
+class DirectCollocation
+{
+private:
+    enum ElementType { INTERVAL_ELEMENT, NODE_ELEMENT, BOUNDARY_ELEMENT, TIME_ELEMENT, COST_ELEMENT };
+
+    // constraints or cost depending on a few variables only; outputs are the
+    // equality rows [c_row, c_row+num_c) then the inequality rows [g_row, g_row+num_g)
+    struct Element
+    {
+        ElementType type;
+        int index;
+        std::vector<int> vars;
+        int c_row;
+        int num_c;
+        int g_row;
+        int num_g;
+    };
+
+    OptimalControlProblem* p_problem_;
+    FiniteDifferenceGrid grid_;
+    Eigen::VectorXd tau_;
+    int num_nodes_;
+    int n_;  // states
+    int m_;  // controls
+    int num_path_;
+    int num_vars_;
+    int num_eq_;
+    int num_ineq_;
+    std::vector<Element> elements_;
+
+    Eigen::VectorXd x_scale_;
+    Eigen::VectorXd u_scale_;
+    double t_scale_ = 1;
+    Eigen::VectorXd scale_;  // of every unknown
+
+    double tf_ = 1;
+    bool free_time_ = true;
+    double tf_min_ = 0;
+    double tf_max_ = HUGE_VAL;
+    double tol_ = 1e-8;
+
+    Eigen::VectorXd sol_;  // unknowns, unscaled
+    Eigen::VectorXd y_;  // multipliers of the equalities
+    int iterations_ = 0;
+
+    // the reduced KKT matrix and its factorization, analysed once per pattern
+    Eigen::SparseMatrix<double> kkt_;
+    Eigen::SimplicialLDLT<Eigen::SparseMatrix<double> > kkt_ldlt_;
+    int kkt_nonzeros_ = -1;
+
+    // (violation, barrier function) pairs of the filter line search
+    std::vector<std::pair<double, double> > filter_;
+
+    static constexpr double DELTA_C = 1e-8;
+    static constexpr double GAMMA_THETA = 1e-5;
+    static constexpr double GAMMA_PHI = 1e-5;
+    static constexpr double RESTORATION_WEIGHT = 1e-2;
+    static constexpr double STEP_LIMIT = 0.5;
+    static const int MAX_RESTORATION = 100;
+    static const int MAX_ITER = 500;
+    static const int MAX_BACKTRACKS = 40;
+
+    int x_index(int j) const;
+    int u_index(int j) const;
+    int midpoint_index(int i) const;
+    int time_index() const;
+
+    void Transcribe();
+    void SetScale();
+    // outputs of element e at its local unknowns zl and, if jac is given,
+    // their derivatives with respect to zl
+    void EvaluateElement(const Element& e, const Eigen::VectorXd& zl,
+                         Eigen::VectorXd& out, Eigen::MatrixXd* jac);
+    // cost f, equalities c and inequalities g (<= 0) at z
+    void Evaluate(const Eigen::VectorXd& z, double& f, Eigen::VectorXd& c, Eigen::VectorXd& g);
+    void EvaluateJacobians(const Eigen::VectorXd& z, Eigen::VectorXd& grad,
+                           Eigen::SparseMatrix<double>& Jc, Eigen::SparseMatrix<double>& Jg);
+    // triplets of the Hessian of f + y^T c + w^T g
+    void Hessian(const Eigen::VectorXd& z, const Eigen::VectorXd& y, const Eigen::VectorXd& w,
+                 std::vector<Eigen::Triplet<double> >& triplets);
+    // LDL^T of [W + delta I  Jc^T; Jc  -DELTA_C I], returns 1 unless it has
+    // num_vars_ positive and num_eq_ negative pivots
+    int FactorizeKkt(const Eigen::SparseMatrix<double>& W, const Eigen::SparseMatrix<double>& Jc, double delta);
+    // multipliers y minimising the dual residual for the given w, zero if
+    // they come out larger than 1e3
+    void LeastSquaresMultipliers(const Eigen::VectorXd& grad, const Eigen::SparseMatrix<double>& Jc,
+                                 const Eigen::SparseMatrix<double>& Jg, const Eigen::VectorXd& w,
+                                 Eigen::VectorXd& y);
+    // a point is acceptable to the filter if no entry has both a smaller
+    // violation theta and a smaller barrier function phi
+    bool FilterAcceptable(double theta, double phi) const;
+    // feasibility restoration after a failed line search: Levenberg-Marquardt
+    // steps on the constraints, with margin mu on the inequalities, until the
+    // violation is acceptable to the filter, returns 1 if it failed
+    int Restore(Eigen::VectorXd& z, Eigen::VectorXd& s, double mu);
+public:
+    DirectCollocation(OptimalControlProblem* p_problem, int num_nodes);
+
+    // typical magnitudes of the states, controls and final time, all 1 by default
+    void SetScaling(const Eigen::VectorXd& x_scale, const Eigen::VectorXd& u_scale, double t_scale);
+    // final time, the initial guess if it is free
+    void SetFinalTime(double tf, bool free = true);
+    // bounds of a free final time, [0, infinity) by default
+    void SetTimeBounds(double tf_min, double tf_max);
+    void SetTolerance(double tol);
+    // one row per node, the midpoint controls are the averages of the node ones
+    void SetInitialGuess(const Eigen::MatrixXd& states, const Eigen::MatrixXd& controls);
+
+    // returns 0 if the optimality conditions hold within the tolerance, 1 otherwise
+    int Solve();
+
+    double final_time() const;
+    // times of the nodes
+    Eigen::VectorXd mesh() const;
+    // one row per node
+    Eigen::MatrixXd states() const;
+    Eigen::MatrixXd controls() const;
+    // multipliers of the defects, interval after interval (scaled), the
+    // costates of the indirect formulation up to sign and scaling
+    Eigen::VectorXd defect_multipliers() const;
+    int iterations() const;
+};
+
+#endif // DIRECTCOLLOCATION_H
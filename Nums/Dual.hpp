@@ -0,0 +1,193 @@
+#ifndef DUAL_H
+#define DUAL_H
+
+#include <cmath>
+#include "Eigen/Dense"
+
+/* Forward mode automatic differentiation with N directions: a value and its
+ * gradient with respect to N seeded inputs.  A function written once as a
+ * template on its scalar type gives its value with T = double, and its value
+ * together with the exact N column Jacobian in one pass with T = Dual<N>:
+ *
+ *   Dual<9> s[9];
+ *   for (int i=0; i<9; i++) s[i] = Dual<9>(x[i], i);
+ *   Acceleration(s, a);   // a[k].grad() is row k of the Jacobian
+ *
+ * Seeding input i with row i of a matrix S instead, Dual<N>(x[i], S.row(i)),
+ * gives the rows of J*S in the same pass, as the variational equations need.
+ * The gradient has a compile time size, so duals live on the stack without
+ * allocating (in a std::vector they need Eigen::aligned_allocator as any
+ * fixed size Eigen type).  Comparisons look at the values only, branches of
+ * the template follow the double evaluation.
+ */
+template <int N>
+class Dual
+{
+private:
+    // the gradient is padded to an even length so that Eigen keeps it in
+    // aligned SSE packets
+    static const int P = N + N%2;
+    typedef Eigen::Matrix<double, P, 1> Storage;
+public:
+    typedef Eigen::Matrix<double, N, 1> Gradient;
+    EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+
+    Dual() : value_(0), grad_(Storage::Zero()) {}
+    // a constant
+    Dual(double value) : value_(value), grad_(Storage::Zero()) {}
+    // input number index (0..N-1)
+    Dual(double value, int index) : value_(value), grad_(Storage::Unit(index)) {}
+    // input with the derivatives grad along the N directions
+    template <class Derived>
+    Dual(double value, const Eigen::MatrixBase<Derived>& grad) : value_(value)
+    {
+        grad_.template head<N>() = grad;
+        if (P > N)
+        {
+            grad_(P-1) = 0;
+        }
+    }
+
+    double value() const { return value_; }
+    Eigen::VectorBlock<const Storage, N> grad() const { return grad_.template head<N>(); }
+    double grad(int index) const { return grad_(index); }
+
+    Dual& operator+=(const Dual& b)
+    {
+        value_ += b.value_;
+        grad_ += b.grad_;
+        return *this;
+    }
+    Dual& operator-=(const Dual& b)
+    {
+        value_ -= b.value_;
+        grad_ -= b.grad_;
+        return *this;
+    }
+    Dual& operator*=(const Dual& b)
+    {
+        grad_ = b.value_*grad_ + value_*b.grad_;
+        value_ *= b.value_;
+        return *this;
+    }
+    Dual& operator/=(const Dual& b)
+    {
+        value_ /= b.value_;
+        grad_ = (grad_ - value_*b.grad_)*(1/b.value_);
+        return *this;
+    }
+    Dual& operator+=(double b)
+    {
+        value_ += b;
+        return *this;
+    }
+    Dual& operator-=(double b)
+    {
+        value_ -= b;
+        return *this;
+    }
+    Dual& operator*=(double b)
+    {
+        value_ *= b;
+        grad_ *= b;
+        return *this;
+    }
+    Dual& operator/=(double b)
+    {
+        return *this *= 1/b;
+    }
+private:
+    double value_;
+    Storage grad_;
+
+    // preferred over the template constructor for a padded gradient
+    Dual(double value, const Storage& grad) : value_(value), grad_(grad) {}
+
+    template <int M> friend Dual<M> Chain(const Dual<M>& a, double f, double df);
+};
+
+// f(a) from the value f and the derivative df of f at a.value()
+template <int N> inline Dual<N> Chain(const Dual<N>& a, double f, double df)
+{
+    return Dual<N>(f, typename Dual<N>::Storage(df*a.grad_));
+}
+
+template <int N> inline Dual<N> operator-(const Dual<N>& a) { return Chain(a, -a.value(), -1); }
+
+template <int N> inline Dual<N> operator+(Dual<N> a, const Dual<N>& b) { return a += b; }
+template <int N> inline Dual<N> operator-(Dual<N> a, const Dual<N>& b) { return a -= b; }
+template <int N> inline Dual<N> operator*(Dual<N> a, const Dual<N>& b) { return a *= b; }
+template <int N> inline Dual<N> operator/(Dual<N> a, const Dual<N>& b) { return a /= b; }
+
+template <int N> inline Dual<N> operator+(Dual<N> a, double b) { return a += b; }
+template <int N> inline Dual<N> operator-(Dual<N> a, double b) { return a -= b; }
+template <int N> inline Dual<N> operator*(const Dual<N>& a, double b) { return Chain(a, a.value()*b, b); }
+template <int N> inline Dual<N> operator/(const Dual<N>& a, double b) { return Chain(a, a.value()/b, 1/b); }
+
+template <int N> inline Dual<N> operator+(double a, Dual<N> b) { return b += a; }
+template <int N> inline Dual<N> operator-(double a, const Dual<N>& b) { return Chain(b, a - b.value(), -1); }
+template <int N> inline Dual<N> operator*(double a, const Dual<N>& b) { return Chain(b, a*b.value(), a); }
+template <int N> inline Dual<N> operator/(double a, const Dual<N>& b)
+{
+    double v = a/b.value();
+    return Chain(b, v, -v/b.value());
+}
+
+template <int N> inline bool operator<(const Dual<N>& a, const Dual<N>& b) { return a.value() < b.value(); }
+template <int N> inline bool operator>(const Dual<N>& a, const Dual<N>& b) { return a.value() > b.value(); }
+template <int N> inline bool operator<(const Dual<N>& a, double b) { return a.value() < b; }
+template <int N> inline bool operator>(const Dual<N>& a, double b) { return a.value() > b; }
+
+template <int N> inline Dual<N> sqrt(const Dual<N>& a)
+{
+    double v = std::sqrt(a.value());
+    return Chain(a, v, 0.5/v);
+}
+
+template <int N> inline Dual<N> exp(const Dual<N>& a)
+{
+    double v = std::exp(a.value());
+    return Chain(a, v, v);
+}
+
+template <int N> inline Dual<N> log(const Dual<N>& a)
+{
+    return Chain(a, std::log(a.value()), 1/a.value());
+}
+
+template <int N> inline Dual<N> sin(const Dual<N>& a)
+{
+    return Chain(a, std::sin(a.value()), std::cos(a.value()));
+}
+
+template <int N> inline Dual<N> cos(const Dual<N>& a)
+{
+    return Chain(a, std::cos(a.value()), -std::sin(a.value()));
+}
+
+template <int N> inline Dual<N> pow(const Dual<N>& a, double p)
+{
+    double v = std::pow(a.value(), p);
+    return Chain(a, v, p*v/a.value());
+}
+
+template <int N> inline Dual<N> atan2(const Dual<N>& y, const Dual<N>& x)
+{
+    double r2 = x.value()*x.value() + y.value()*y.value();
+    Dual<N> c = Chain(y, std::atan2(y.value(), x.value()), x.value()/r2);
+    c -= Chain(x, 0, y.value()/r2);
+    return c;
+}
+
+// value of a double or a dual, for the parts of a template that need plain numbers
+inline double value_of(double a)
+{
+    return a;
+}
+
+template <int N> inline double value_of(const Dual<N>& a)
+{
+    return a.value();
+}
+
+#endif // DUAL_H
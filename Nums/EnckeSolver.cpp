@@ -0,0 +1,263 @@
+#include "EnckeSolver.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+#include "Orbital/Omt.hpp"
+
+// same model constants as SatelliteSolver
+const double G = 6.67259e-20;
+const double m1 = 5.974e24;
+const double R_e = 6378.1363;
+const double r_0 = 7.0e2+R_e;
+const double H = 88.667;
+const double A = 3e-6;
+const double rho_0 = 3.614e-4;
+const double omega_E = 2*M_PI/86164;
+
+EnckeSolver::EnckeSolver()
+{
+    delta_.fill(0.0);
+    SetStepSize(60);
+}
+
+double EnckeSolver::BattinF(double q)
+{
+    return q*(3 + 3*q + q*q)/(1 + pow(1 + q, 1.5));
+}
+
+void EnckeSolver::InitialConditions()
+{
+    Eigen::VectorXd Rx(9);
+    double initmu = G*m1;
+    Rx << 757.7, 5222.607, 4851.5, 2.21321, 4.67834, -5.37130, initmu, 1.082626925638815e-3, 2;
+    InitialConditions(Rx, 10);
+}
+
+void EnckeSolver::InitialConditions(Eigen::VectorXd& x, double dt)
+{
+    t_ = 0;
+    setState(x);
+    rectifications_ = 0;
+    std::vector<double> initial(x.data(), x.data()+x.size());
+    SetInitialValue(initial);
+    SetTimeInterval(0, dt);
+}
+
+void EnckeSolver::SetRectificationThreshold(double ratio)
+{
+    rectify_ratio_ = ratio;
+}
+
+void EnckeSolver::Reference(double t, Eigen::Vector3d& r, Eigen::Vector3d& v)
+{
+    if (!cached_ || t != t_cached_)
+    {
+        r_cached_ = r_epoch_;
+        v_cached_ = v_epoch_;
+        Omt::state_transition(r_cached_, v_cached_, t - t_epoch_, mu_);
+        t_cached_ = t;
+        cached_ = true;
+    }
+    r = r_cached_;
+    v = v_cached_;
+}
+
+void EnckeSolver::PerturbingAcceleration(double, const Eigen::Vector3d& pos, const Eigen::Vector3d& vel,
+                                         Eigen::Vector3d& a)
+{
+    double r2 = pos.squaredNorm();
+    double r = sqrt(r2);
+    double r5 = r2*r2*r;
+    double r7 = r5*r2;
+    double rho = rho_0*exp(-(r-r_0)/H);
+
+    double v_rel = sqrt((vel(0)+omega_E*vel(1))*(vel(0)+omega_E*vel(1))
+                        +(vel(1)-omega_E*vel(0))*(vel(1)-omega_E*vel(0))+vel(2)*vel(2));
+    double drag = 0.5*rho*C_D_*A*v_rel/970;
+    double j2 = mu_*J2_*R_e*R_e;
+
+    a(0) = -j2*pos(0)*(1.5/r5-7.5*pos(2)*pos(2)/r7) - drag*(vel(0) + omega_E*vel(1));
+    a(1) = -j2*pos(1)*(1.5/r5-7.5*pos(2)*pos(2)/r7) - drag*(vel(1) - omega_E*vel(0));
+    a(2) = -j2*pos(2)*(4.5/r5-7.5*pos(2)*pos(2)/r7) - drag*vel(2);
+}
+
+void EnckeSolver::Deviation(double t, const std::array<double, 6>& d, std::array<double, 6>& f)
+{
+    rhs_evaluations_++;
+    Eigen::Vector3d r_ref, v_ref;
+    Reference(t, r_ref, v_ref);
+    Eigen::Vector3d dr(d[0], d[1], d[2]);
+    Eigen::Vector3d r = r_ref + dr;
+    Eigen::Vector3d v = v_ref + Eigen::Vector3d(d[3], d[4], d[5]);
+
+    double q = dr.dot(dr - 2*r)/r.squaredNorm();
+    double rho = r_ref.norm();
+    double k = -mu_/(rho*rho*rho);
+    Eigen::Vector3d a;
+    PerturbingAcceleration(t, r, v, a);
+    a += k*(dr + BattinF(q)*r);
+
+    f[0] = d[3];
+    f[1] = d[4];
+    f[2] = d[5];
+    f[3] = a(0);
+    f[4] = a(1);
+    f[5] = a(2);
+}
+
+void EnckeSolver::Rectify()
+{
+    Eigen::Vector3d r_ref, v_ref;
+    Reference(t_, r_ref, v_ref);
+    r_epoch_ = r_ref + Eigen::Vector3d(delta_[0], delta_[1], delta_[2]);
+    v_epoch_ = v_ref + Eigen::Vector3d(delta_[3], delta_[4], delta_[5]);
+    t_epoch_ = t_;
+    delta_.fill(0.0);
+    cached_ = false;
+    rectifications_++;
+}
+
+bool EnckeSolver::Step(double h)
+{
+    const double t0 = t_;
+    if (has_events())
+    {
+        delta_prev_ = delta_;
+    }
+    stepper_.Step([this](double ti, const std::array<double, 6>& di, std::array<double, 6>& fi)
+                  { Deviation(ti, di, fi); }, t_, h, delta_);
+    t_ += h;
+
+    bool stop = false;
+    if (has_events())
+    {
+        f_prev_ = stepper_.k(0);
+        Deviation(t_, delta_, f_next_);
+        std::array<double, 6> d;
+        auto hermite = [&](double t)
+        {
+            double theta = (t - t0)/h;
+            double theta2 = theta*theta;
+            double h00 = (2*theta - 3)*theta2 + 1;
+            double h10 = ((theta - 2)*theta + 1)*theta*h;
+            double h01 = (3 - 2*theta)*theta2;
+            double h11 = (theta - 1)*theta2*h;
+            for (int j=0; j<6; j++)
+            {
+                d[j] = h00*delta_prev_[j] + h10*f_prev_[j] + h01*delta_[j] + h11*f_next_[j];
+            }
+        };
+        // the reference is exact, only the deviation is interpolated
+        auto interpolant = [&](double t, std::vector<double>& y)
+        {
+            hermite(t);
+            Eigen::Vector3d r_ref, v_ref;
+            Reference(t, r_ref, v_ref);
+            y.resize(9);
+            for (int j=0; j<3; j++)
+            {
+                y[j] = r_ref(j) + d[j];
+                y[3+j] = v_ref(j) + d[3+j];
+            }
+            y[6] = mu_;
+            y[7] = J2_;
+            y[8] = C_D_;
+        };
+        double t_stop;
+        if (LocateEvents(t0, t_, interpolant, t_stop))
+        {
+            hermite(t_stop);
+            delta_ = d;
+            t_ = t_stop;
+            stop = true;
+        }
+    }
+
+    double d2 = delta_[0]*delta_[0] + delta_[1]*delta_[1] + delta_[2]*delta_[2];
+    Eigen::Vector3d r_ref, v_ref;
+    Reference(t_, r_ref, v_ref);
+    if (d2 > rectify_ratio_*rectify_ratio_*r_ref.squaredNorm())
+    {
+        Rectify();
+    }
+    return stop;
+}
+
+void EnckeSolver::UpdateState(double dt)
+{
+    terminated_ = false;
+    double t_target = t_ + dt;
+    // the last step is shortened to land on t_target
+    while (t_target - t_ > 1e-9*mStepSize)
+    {
+        if (Step(std::min(mStepSize, t_target - t_)))
+        {
+            return;
+        }
+    }
+    t_ = t_target;
+}
+
+void EnckeSolver::SolveEquation(std::vector<double>)
+{
+    Eigen::VectorXd x(9);
+    for (int i=0; i<9; i++)
+    {
+        x(i) = mInitialValueVector[i];
+    }
+    t_ = mInitialTime;
+    setState(x);
+    UpdateState(mFinalTime - mInitialTime);
+}
+
+void EnckeSolver::getState(Eigen::VectorXd& x)
+{
+    Eigen::Vector3d r_ref, v_ref;
+    Reference(t_, r_ref, v_ref);
+    x.resize(9);
+    for (int i=0; i<3; i++)
+    {
+        x(i) = r_ref(i) + delta_[i];
+        x(3+i) = v_ref(i) + delta_[3+i];
+    }
+    x(6) = mu_;
+    x(7) = J2_;
+    x(8) = C_D_;
+}
+
+void EnckeSolver::setState(const Eigen::VectorXd& x)
+{
+    r_epoch_ << x(0), x(1), x(2);
+    v_epoch_ << x(3), x(4), x(5);
+    mu_ = x(6);
+    J2_ = x(7);
+    C_D_ = x(8);
+    t_epoch_ = t_;
+    delta_.fill(0.0);
+    cached_ = false;
+}
+
+Vector3D EnckeSolver::position()
+{
+    Eigen::VectorXd x;
+    getState(x);
+    return Vector3D(x(0), x(1), x(2));
+}
+
+Vector3D EnckeSolver::velocity()
+{
+    Eigen::VectorXd x;
+    getState(x);
+    return Vector3D(x(3), x(4), x(5));
+}
+
+long EnckeSolver::rectifications() const
+{
+    return rectifications_;
+}
+
+long EnckeSolver::rhs_evaluations() const
+{
+    return rhs_evaluations_;
+}
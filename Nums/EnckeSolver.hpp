@@ -0,0 +1,92 @@
+#ifndef ENCKESOLVER_H
+#define ENCKESOLVER_H
+
+#include <array>
+#include <vector>
+#include "Vector3D.hpp"
+#include "Eigen/Dense"
+
+#include "AbstractOdeSolver.hpp"
+#include "RungeKuttaStepper.hpp"
+
+/* Encke propagation of the SatelliteSolver dynamics (point mass, J2 and
+ * exponential atmosphere drag).  The Keplerian part is propagated analytically
+ * from an osculating epoch state with Omt::state_transition (universal
+ * variables) and only the deviation d = r - r_ref is integrated with RK4,
+ *   d'' = -mu/r_ref^3 (d + f(q) r) + a_p(r, v)
+ * with Battin's f(q) = (r_ref/r)^3 - 1 evaluated without cancellation.  The
+ * deviation is small and smooth, so much larger steps than with the full
+ * (Cowell) acceleration give the same accuracy.  When |d| exceeds a fraction
+ * of |r_ref| the reference is rectified: the true state becomes the new
+ * epoch state and the deviation restarts from zero.
+ *
+ * getState/setState use the 9 component layout of SatelliteSolver,
+ * [x, y, z, u, v, w, mu, J2, C_D], which is also the state the event
+ * functions get.  Events are located on the reference orbit plus the cubic
+ * Hermite interpolant of the deviation over the step, before rectifying.
+ */
+class EnckeSolver : public AbstractOdeSolver
+{
+private:
+    // osculating reference orbit at the epoch
+    Eigen::Vector3d r_epoch_;
+    Eigen::Vector3d v_epoch_;
+    double t_epoch_ = 0;
+    // deviation from the reference orbit, position then velocity
+    std::array<double, 6> delta_;
+    double mu_ = 0;
+    double J2_ = 0;
+    double C_D_ = 0;
+    double rectify_ratio_ = 3e-5;
+    long rectifications_ = 0;
+    long rhs_evaluations_ = 0;
+    FixedRungeKutta<6> stepper_;
+    // deviation at the step ends for the event interpolant
+    std::array<double, 6> delta_prev_;
+    std::array<double, 6> f_prev_;
+    std::array<double, 6> f_next_;
+
+    // the reference at the last requested time, RK4 asks for each time twice
+    double t_cached_ = 0;
+    bool cached_ = false;
+    Eigen::Vector3d r_cached_;
+    Eigen::Vector3d v_cached_;
+
+    void Reference(double t, Eigen::Vector3d& r, Eigen::Vector3d& v);
+    void Deviation(double t, const std::array<double, 6>& d, std::array<double, 6>& f);
+    void Rectify();
+    // returns true when the step stopped at a terminal event
+    bool Step(double h);
+public:
+    EnckeSolver();
+
+    // Battin's f(q) = q(3 + 3q + q^2)/(1 + (1+q)^(3/2)), equal to (r_ref/r)^3 - 1
+    // for q = d.(d - 2r)/r^2
+    static double BattinF(double q);
+
+    // implementations of virtual methods from inherited class
+    void InitialConditions();
+    void InitialConditions(Eigen::VectorXd& x, double dt);
+    void UpdateState(double dt);
+    void SolveEquation(std::vector<double> yi);
+
+    // rectify when |d|/|r_ref| exceeds ratio, rectifying is cheap and for LEO a
+    // small ratio (about 200 m) is more accurate than letting d grow
+    void SetRectificationThreshold(double ratio);
+
+    // full state [pos, vel, mu, J2, C_D], setState rectifies the reference
+    void getState(Eigen::VectorXd& x);
+    void setState(const Eigen::VectorXd& x);
+
+    // outputs from the simulation
+    Vector3D position();
+    Vector3D velocity();
+    long rectifications() const;
+    long rhs_evaluations() const;
+
+    // acceleration other than the central body, J2 and drag by default
+    virtual void PerturbingAcceleration(double t, const Eigen::Vector3d& r, const Eigen::Vector3d& v,
+                                        Eigen::Vector3d& a);
+};
+
+#endif // ENCKESOLVER_H
@@ -14,6 +14,46 @@ FiniteDifferenceGrid::FiniteDifferenceGrid(unsigned long num_nodes, double t_min
     assert(nodes_.size() == num_nodes);
 }
 
+int FiniteDifferenceGrid::num_nodes() const
+{
+    return static_cast<int>(nodes_.size());
+}
 
+Eigen::VectorXd FiniteDifferenceGrid::coordinates() const
+{
+    Eigen::VectorXd t(nodes_.size());
+    for (unsigned long i=0; i<nodes_.size(); i++)
+    {
+        t(i) = nodes_[i].coordinate;
+    }
+    return t;
+}
 
+void FiniteDifferenceGrid::Equidistribute(const std::vector<double>& density, unsigned long num_nodes)
+{
+    assert(density.size() == nodes_.size()-1 && num_nodes >= 2);
+    // cumulative integral of the monitor function at the current nodes
+    std::vector<double> integral(nodes_.size(), 0.0);
+    for (unsigned long i=0; i+1<nodes_.size(); i++)
+    {
+        integral[i+1] = integral[i] + density[i]*(nodes_[i+1].coordinate-nodes_[i].coordinate);
+    }
 
+    std::vector<Node> nodes(num_nodes);
+    nodes.front() = nodes_.front();
+    nodes.back() = nodes_.back();
+    unsigned long i = 0;
+    for (unsigned long j=1; j+1<num_nodes; j++)
+    {
+        double target = integral.back()*j/(num_nodes-1);
+        while (i+2 < nodes_.size() && integral[i+1] < target)
+        {
+            i++;
+        }
+        // the integral is linear inside an interval
+        double h = nodes_[i+1].coordinate-nodes_[i].coordinate;
+        double fraction = (target-integral[i])/(integral[i+1]-integral[i]);
+        nodes[j].coordinate = nodes_[i].coordinate + fraction*h;
+    }
+    nodes_.swap(nodes);
+}
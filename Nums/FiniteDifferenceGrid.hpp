@@ -13,6 +13,14 @@ private:
     std::vector<Node> nodes_;
 public:
     FiniteDifferenceGrid(unsigned long num_nodes, double t_min, double t_max);
+
+    int num_nodes() const;
+    Eigen::VectorXd coordinates() const;
+
+    // moves the nodes, keeping both ends, so that a monitor function given by
+    // its constant value density[i] on each current interval i has the same
+    // integral over every new interval
+    void Equidistribute(const std::vector<double>& density, unsigned long num_nodes);
 };
 
 #endif
@@ -0,0 +1,291 @@
+#include "GaussJacksonSolver.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+// coefficients of the operator series of the first sum (odd derivatives 1, 3, 5, 7)
+// and the second sum (even derivatives 0, 2, ..., 8), from the Bernoulli numbers
+const long double FIRST_SUM_SERIES[4] = {-1.0L/12, 1.0L/720, -1.0L/30240, 1.0L/1209600};
+const long double SECOND_SUM_SERIES[5] = {1.0L/12, -1.0L/240, 1.0L/6048, -1.0L/172800, 1.0L/5322240};
+
+// corrector iterations over the starting points
+const int MAX_START_ITER = 10;
+const double START_TOL = 1e-14;
+
+GaussJacksonSolver::GaussJacksonSolver(RungeKuttaSolver& system)
+    : MultistepSolver(system)
+{
+    ComputeCoefficients();
+    AddPositionBlock(0, 3, 3);
+}
+
+void GaussJacksonSolver::AddPositionBlock(int first, int count, int velocity_offset)
+{
+    position_first_.push_back(first);
+    position_count_.push_back(count);
+    velocity_offset_.push_back(velocity_offset);
+    Restart();
+}
+
+void GaussJacksonSolver::ClearPositionBlocks()
+{
+    position_first_.clear();
+    position_count_.clear();
+    velocity_offset_.clear();
+    Restart();
+}
+
+int GaussJacksonSolver::start_iterations() const
+{
+    return start_iterations_;
+}
+
+void GaussJacksonSolver::ComputeCoefficients()
+{
+    std::vector<long double> nodes(kPoints);
+    for (int k=0; k<kPoints; k++)
+    {
+        nodes[k] = k;
+    }
+    std::vector<std::vector<long double> > basis;
+    LagrangeBasis(nodes, basis);
+
+    // the predictor is evaluated at node kPoints, one step past the window
+    for (int j=0; j<=kPoints; j++)
+    {
+        for (int k=0; k<kPoints; k++)
+        {
+            long double first = 0.0L;
+            for (int m=0; m<4; m++)
+            {
+                first += FIRST_SUM_SERIES[m]*PolynomialDerivative(basis[k], 2*m+1, j);
+            }
+            long double second = 0.0L;
+            for (int m=0; m<5; m++)
+            {
+                second += SECOND_SUM_SERIES[m]*PolynomialDerivative(basis[k], 2*m, j);
+            }
+            if (j < kPoints)
+            {
+                first_corrector_[j][k] = static_cast<double>(first);
+                second_corrector_[j][k] = static_cast<double>(second);
+            }
+            else
+            {
+                // the predicted first sum still lacks half of the new derivative
+                first_predictor_[k] = static_cast<double>(first + 0.5L*PolynomialDerivative(basis[k], 0, j));
+                second_predictor_[k] = static_cast<double>(second);
+            }
+        }
+    }
+}
+
+void GaussJacksonSolver::StateFromSums(int j, const std::vector<double>& s, const std::vector<double>& S,
+                                       std::vector<double>& y) const
+{
+    const double h = mStepSize;
+    for (int i=0; i<state_dim_; i++)
+    {
+        int v = velocity_of_[i];
+        double sum = 0;
+        if (v >= 0)
+        {
+            for (int k=0; k<kPoints; k++)
+            {
+                sum += second_corrector_[j][k]*g_[k][v];
+            }
+            y[i] = h*h*(S[i] + sum);
+        }
+        else
+        {
+            for (int k=0; k<kPoints; k++)
+            {
+                sum += first_corrector_[j][k]*g_[k][i];
+            }
+            y[i] = h*(s[i] + sum);
+        }
+    }
+}
+
+// first and second sums at the first starting point, chosen such that the
+// corrector formulas reproduce its state
+void GaussJacksonSolver::InitialSums()
+{
+    const double h = mStepSize;
+    for (int i=0; i<state_dim_; i++)
+    {
+        double sum = 0;
+        for (int k=0; k<kPoints; k++)
+        {
+            sum += first_corrector_[0][k]*g_[k][i];
+        }
+        s_[i] = start_states_[0][i]/h - sum;
+        int v = velocity_of_[i];
+        if (v >= 0)
+        {
+            sum = 0;
+            for (int k=0; k<kPoints; k++)
+            {
+                sum += second_corrector_[0][k]*g_[k][v];
+            }
+            S_[i] = start_states_[0][i]/(h*h) - sum;
+        }
+    }
+}
+
+// moves the sums from window node j-1 to node j
+void GaussJacksonSolver::AdvanceSums(int j)
+{
+    for (int i=0; i<state_dim_; i++)
+    {
+        int v = velocity_of_[i];
+        if (v >= 0)
+        {
+            S_[i] += s_[v] + 0.5*g_[j-1][v];
+        }
+    }
+    for (int i=0; i<state_dim_; i++)
+    {
+        s_[i] += 0.5*(g_[j-1][i] + g_[j][i]);
+    }
+}
+
+void GaussJacksonSolver::Start()
+{
+    const double h = mStepSize;
+    const int n = state_dim_;
+    const double t0 = t_int_;
+
+    velocity_of_.assign(n, -1);
+    for (unsigned int b=0; b<position_first_.size(); b++)
+    {
+        for (int i=0; i<position_count_[b]; i++)
+        {
+            velocity_of_[position_first_[b]+i] = position_first_[b]+i+velocity_offset_[b];
+        }
+    }
+    g_.assign(kPoints, std::vector<double>(n, 0.0));
+    g_new_.assign(n, 0.0);
+    s_.assign(n, 0.0);
+    S_.assign(n, 0.0);
+    y_pred_.assign(n, 0.0);
+
+    // starting points from RK4 with substeps
+    start_states_.assign(kPoints, y_);
+    EvaluateRhs(t0, start_states_[0], g_[0]);
+    for (int j=1; j<kPoints; j++)
+    {
+        start_states_[j] = start_states_[j-1];
+        StartingStep(t0+(j-1)*h, h, start_states_[j], 4);
+        EvaluateRhs(t0+j*h, start_states_[j], g_[j]);
+    }
+
+    // iterate the corrector over the starting points until they are consistent
+    // with the 8th order formulas, the first point stays fixed
+    for (start_iterations_=1; start_iterations_<=MAX_START_ITER; start_iterations_++)
+    {
+        InitialSums();
+        double change = 0;
+        for (int j=1; j<kPoints; j++)
+        {
+            AdvanceSums(j);
+            StateFromSums(j, s_, S_, y_pred_);
+            for (int i=0; i<n; i++)
+            {
+                double scale = std::max(std::abs(y_pred_[i]), std::abs(start_states_[j][i]));
+                if (scale > 0)
+                {
+                    change = std::max(change, std::abs(y_pred_[i] - start_states_[j][i])/scale);
+                }
+            }
+            start_states_[j].swap(y_pred_);
+        }
+        for (int j=1; j<kPoints; j++)
+        {
+            EvaluateRhs(t0+j*h, start_states_[j], g_[j]);
+        }
+        if (change < START_TOL) break;
+    }
+    start_iterations_ = std::min(start_iterations_, MAX_START_ITER);
+
+    // sums at the last starting point with the final derivatives
+    InitialSums();
+    for (int j=1; j<kPoints; j++)
+    {
+        AdvanceSums(j);
+    }
+    y_ = start_states_[kPoints-1];
+    t_int_ = t0 + (kPoints-1)*h;
+}
+
+void GaussJacksonSolver::Step()
+{
+    const double h = mStepSize;
+    const int n = state_dim_;
+    const std::vector<double>& g_last = g_[kPoints-1];
+
+    // predict, the second sums move to the new point first
+    for (int i=0; i<n; i++)
+    {
+        int v = velocity_of_[i];
+        double sum = 0;
+        if (v >= 0)
+        {
+            S_[i] += s_[v] + 0.5*g_last[v];
+            for (int k=0; k<kPoints; k++)
+            {
+                sum += second_predictor_[k]*g_[k][v];
+            }
+            y_pred_[i] = h*h*(S_[i] + sum);
+        }
+        else
+        {
+            for (int k=0; k<kPoints; k++)
+            {
+                sum += first_predictor_[k]*g_[k][i];
+            }
+            y_pred_[i] = h*(s_[i] + 0.5*g_last[i] + sum);
+        }
+    }
+    EvaluateRhs(t_int_+h, y_pred_, g_new_);
+
+    // shift the window, the storage of the oldest derivative is reused
+    std::rotate(g_.begin(), g_.begin()+1, g_.end());
+    g_[kPoints-1].swap(g_new_);
+
+    // correct with the predicted derivative and evaluate again
+    const std::vector<double>& g_prev = g_[kPoints-2];
+    const std::vector<double>& g_cur = g_[kPoints-1];
+    for (int i=0; i<n; i++)
+    {
+        int v = velocity_of_[i];
+        double sum = 0;
+        if (v >= 0)
+        {
+            for (int k=0; k<kPoints; k++)
+            {
+                sum += second_corrector_[kPoints-1][k]*g_[k][v];
+            }
+            y_[i] = h*h*(S_[i] + sum);
+        }
+        else
+        {
+            for (int k=0; k<kPoints; k++)
+            {
+                sum += first_corrector_[kPoints-1][k]*g_[k][i];
+            }
+            y_[i] = h*(s_[i] + 0.5*(g_prev[i] + g_cur[i]) + sum);
+        }
+    }
+    t_int_ += h;
+    EvaluateRhs(t_int_, y_, g_[kPoints-1]);
+    for (int i=0; i<n; i++)
+    {
+        s_[i] += 0.5*(g_prev[i] + g_cur[i]);
+    }
+}
+
+const std::vector<double>& GaussJacksonSolver::derivative() const
+{
+    return g_[kPoints-1];
+}
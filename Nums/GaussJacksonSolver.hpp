@@ -0,0 +1,76 @@
+#ifndef GAUSSJACKSONSOLVER_H
+#define GAUSSJACKSONSOLVER_H
+
+#include <vector>
+
+#include "MultistepSolver.hpp"
+
+/* Gauss-Jackson 8th order integrator for second order dynamics r'' = a(t, r, v)
+ * in the summed (second sum) form, PECE with two right hand side evaluations
+ * per step.  Positions are obtained from the second sums of their accelerations,
+ * every other component (velocities, parameters, transition matrix rows, ...)
+ * from the first sums of its derivative (summed Adams-Moulton).
+ *
+ * Which components are positions is set with AddPositionBlock, by default
+ * components 0-2 with their velocities in 3-5, the layout of SatelliteSolver
+ * and GroundTrackingSolver.  The derivative of a position component has to be
+ * the velocity component.
+ *
+ * The sums are initialised from nine RK4 started points which are then
+ * iterated with the corrector, see Berry and Healy, Implementation of
+ * Gauss-Jackson integration for orbit propagation (2004).  The ordinate
+ * coefficients are derived here from the operator expansions
+ *   r/h^2 = S + (1/12 - D^2/240 + D^4/6048 - ...) a
+ *   v/h   = s + (-D/12 + D^3/720 - D^5/30240 + ...) a
+ * of the interpolating polynomial.
+ */
+class GaussJacksonSolver : public MultistepSolver
+{
+public:
+    static const int kOrder = 8;
+    static const int kPoints = kOrder+1;
+
+private:
+    // ordinate coefficients: corrector at window node j, predictor one node past the window
+    double first_corrector_[kPoints][kPoints];
+    double second_corrector_[kPoints][kPoints];
+    double first_predictor_[kPoints];
+    double second_predictor_[kPoints];
+
+    // velocity component of each component, -1 if it is not a position
+    std::vector<int> velocity_of_;
+    std::vector<int> position_first_;
+    std::vector<int> position_count_;
+    std::vector<int> velocity_offset_;
+
+    // derivatives on the window nodes, g_[kPoints-1] belongs to the current grid point
+    std::vector<std::vector<double> > g_;
+    std::vector<double> g_new_;
+    // first sums of all components and second sums of the positions at the current grid point
+    std::vector<double> s_;
+    std::vector<double> S_;
+    std::vector<double> y_pred_;
+    int start_iterations_ = 0;
+
+    void ComputeCoefficients();
+    void InitialSums();
+    void AdvanceSums(int j);
+    // state at window node j from the sums at that node
+    void StateFromSums(int j, const std::vector<double>& s, const std::vector<double>& S,
+                       std::vector<double>& y) const;
+protected:
+    void Start();
+    void Step();
+    const std::vector<double>& derivative() const;
+public:
+    explicit GaussJacksonSolver(RungeKuttaSolver& system);
+
+    // components first..first+count-1 are positions with velocities at +velocity_offset
+    void AddPositionBlock(int first, int count, int velocity_offset);
+    void ClearPositionBlocks();
+
+    // number of corrector passes over the starting points at the last start
+    int start_iterations() const;
+};
+
+#endif // GAUSSJACKSONSOLVER_H
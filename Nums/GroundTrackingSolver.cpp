@@ -1,10 +1,10 @@
+#include <algorithm>
 #include <cassert>
 #include <iostream>
 #include <fstream>
 #include <math.h>
 #include <vector>
 #include <cmath>
-#include <QApplication>
 
 #include "Nums/GroundTrackingSolver.hpp"
 
@@ -33,137 +33,243 @@ void GroundTrackingSolver::InitialConditions()
 
 void GroundTrackingSolver::InitialConditions(Eigen::VectorXd& x, double dt)
 {
-    RungeKuttaSolver::SetStateDimension(18+18*18);
     RungeKuttaSolver::SetStepSize(h);
-
-    for (unsigned int i=0; i<x.size(); i++)
+    if (analytic_stations_)
+    {
+        // orbit and parameters with the upper left 9x9 block of the transition matrix
+        RungeKuttaSolver::SetStateDimension(9+9*9);
+        for (unsigned int i=0; i<9; i++)
+        {
+            state[i] = x(i);
+            stations_[i] = x(9+i);
+            for (unsigned int j=0; j<9; j++)
+            {
+                state[9+9*j+i] = x(18+18*j+i);
+            }
+        }
+        station_epoch_ = 0;
+    }
+    else
     {
-        state[i] = x(i);
+        RungeKuttaSolver::SetStateDimension(18+18*18);
+        for (unsigned int i=0; i<x.size(); i++)
+        {
+            state[i] = x(i);
+        }
     }
     SetInitialValue(state);
     SetTimeInterval(0, dt);
     t_ = 0;
 }
 
-void GroundTrackingSolver::RightHandSide(double t, const std::vector<double> &x_, std::vector<double> &f)
-{
-    double x = x_[0];
-    double y = x_[1];
-    double z = x_[2];
-    double u = x_[3];
-    double v = x_[4];
-    double w = x_[5];
-    double uoy = u+omega_E*y;
-    double vox = v-omega_E*x;
-    double v_rel = sqrt(uoy*uoy+vox*vox+w*w);
-    double r = sqrt(x*x+y*y+z*z);
-    double rcubed = r*r*r;
-    double r2five = rcubed*r*r;
-    double r2six = r2five*r;
-    double r2seven = r2six*r;
-    double r2eight = r2seven*r;
-    double r2nine = r2eight*r;
-
-    double mu = x_[6];
-    double J2 = x_[7];
-    double C_D = x_[8];
-
-    double rho = rho_0*exp(-(r-r_0)/H);
-    double P_DmC = -0.5*rho*sat_area/970;
-
-    double P_D = P_DmC*C_D;
-    double P_G = mu*J2*R_e*R_e;
-    double R3_15 = 1.5/r2five-7.5*z*z/r2seven;
-    double R9_15 = 4.5/r2five-7.5*z*z/r2seven;
-    double R15_105 = -7.5/r2seven+52.5*z*z/r2nine;
-    double R45_105 = -22.5/r2seven+52.5*z*z/r2nine;
-    double ReSq = R_e*R_e;
-
-    Eigen::MatrixXd A = Eigen::MatrixXd::Zero(18, 18);
-
-    A(0, 3) = 1;
-    A(1, 4) = 1;
-    A(2, 5) = 1;
-
-    A(3, 0) = -mu/rcubed + 3*mu*x*x/r2five - P_G*(R3_15 + x*x*R15_105) + P_D*omega_E*uoy*vox/v_rel + P_D*v_rel*uoy*x/(r*H);
-    A(3, 1) = 3*mu*x*y/r2five - P_G*x*y*R15_105 - P_D*omega_E*(v_rel + uoy*uoy/v_rel) + P_D*v_rel*uoy*y/(r*H);
-    A(3, 2) = 3*mu*x*z/r2five - P_G*x*z*R45_105 + P_D*v_rel*uoy*z/(r*H);
-    A(3, 3) = -P_D*(v_rel +  uoy*uoy/v_rel);
-    A(3, 4) = -P_D*vox*uoy/v_rel;
-    A(3, 5) = -P_D*uoy*w/v_rel;
-    A(3, 6) = -x/rcubed - J2*ReSq*x*R3_15;
-    A(3, 7) = -mu*ReSq*x*R3_15;
-    A(3, 8) = P_DmC*v_rel*uoy;
-
-    A(4, 0) = 3*mu*y*x/r2five - P_G*x*y*R15_105 - P_D*omega_E*(v_rel + vox*vox/v_rel) + P_D*v_rel*vox*x/(r*H);
-    A(4, 1) = -mu/rcubed + 3*mu*y*y/r2five - P_G*(R3_15 + y*y*R15_105) - P_D*omega_E*uoy*vox/v_rel + P_D*v_rel*vox*y/(r*H);
-    A(4, 2) = 3*mu*y*z/r2five - P_G*y*z*R45_105 + P_D*v_rel*vox*z/(r*H);
-    A(4, 3) = -P_D*vox*uoy/v_rel;
-    A(4, 4) = -P_D*(v_rel +  vox*vox/v_rel);
-    A(4, 5) = -P_D*vox*w/v_rel;
-    A(4, 6) = -y/rcubed - J2*ReSq*y*R3_15;
-    A(4, 7) = -mu*ReSq*y*R3_15;
-    A(4, 8) = P_DmC*v_rel*vox;
-
-    A(5, 0) = 3*mu*x*z/r2five - P_G*x*z*R45_105 + P_D*omega_E*vox*w/v_rel + P_D*v_rel*w*x/(r*H);
-    A(5, 1) = 3*mu*y*z/r2five - P_G*y*z*R45_105 - P_D*omega_E*uoy*w/v_rel + P_D*v_rel*w*y/(r*H);
-    A(5, 2) = -mu/rcubed + 3*mu*z*z/r2five - P_G*(4.5/r2five-45*z*z/r2seven+52.5*z*z/r2nine)
-             + P_D*v_rel*w*z/(r*H);
-    A(5, 3) = -P_D*uoy*w/v_rel;
-    A(5, 4) = -P_D*vox*w/v_rel;
-    A(5, 5) = -P_D*(v_rel+w*w/v_rel);
-    A(5, 6) = -z/rcubed - J2*ReSq*z*R9_15;
-    A(5, 7) = -mu*ReSq*z*R9_15;
-    A(5, 8) = P_DmC*v_rel*w;
-
-    A(9, 10) = -omega_E;
-    A(10, 9) = omega_E;
-
-    A(12, 13) = -omega_E;
-    A(13, 12) = omega_E;
-
-    A(15, 16) = -omega_E;
-    A(16, 15) = omega_E;
-
-    Eigen::Vector3d pos, vel;
-
-    pos << x_[0], x_[1], x_[2];
-    vel << x_[3], x_[4], x_[5];
-
-    f[0] = vel(0);
-    f[1] = vel(1);
-    f[2] = vel(2);
-    f[3] = -mu*pos(0)/(r*r*r) - mu*J2*R_e*R_e*pos(0)*(1.5/(pow(r,5))-7.5*pos(2)*pos(2)/pow(r,7))
-            + P_D*v_rel*(vel(0) + omega_E*vel(1));
-    f[4] = -mu*pos(1)/(r*r*r) - mu*J2*R_e*R_e*pos(1)*(1.5/(pow(r,5))-7.5*pos(2)*pos(2)/pow(r,7))
-            + P_D*v_rel*(vel(1) - omega_E*vel(0));
-    f[5] = -mu*pos(2)/(r*r*r) - mu*J2*R_e*R_e*pos(2)*(4.5/(pow(r,5))-7.5*pos(2)*pos(2)/pow(r,7))
-            + P_D*v_rel*vel(2);
+void GroundTrackingSolver::SetAnalyticStations(bool analytic)
+{
+    analytic_stations_ = analytic;
+}
+
+bool GroundTrackingSolver::analytic_stations() const
+{
+    return analytic_stations_;
+}
+
+// station positions after rotating the ones at station_epoch_ with the Earth for dt
+void GroundTrackingSolver::RotateStations(double dt, double* st) const
+{
+    double c = cos(omega_E*dt);
+    double s = sin(omega_E*dt);
+    for (unsigned int i=0; i<3; i++)
+    {
+        st[3*i] = c*stations_[3*i] - s*stations_[3*i+1];
+        st[3*i+1] = s*stations_[3*i] + c*stations_[3*i+1];
+        st[3*i+2] = stations_[3*i+2];
+    }
+}
+
+AbstractOdeSolver::EventFunction GroundTrackingSolver::ElevationEvent(int station, double min_elevation)
+{
+    double sin_min = sin(min_elevation);
+    return [this, station, sin_min](double t, const std::vector<double>& y)
+    {
+        double st[9];
+        if (analytic_stations_)
+        {
+            RotateStations(t-station_epoch_, st);
+        }
+        else
+        {
+            std::copy(y.begin()+9, y.begin()+18, st);
+        }
+        const double* s = st+3*station;
+        // spherical Earth, the local vertical is along the station position
+        double dx = y[0]-s[0];
+        double dy = y[1]-s[1];
+        double dz = y[2]-s[2];
+        double up = (dx*s[0]+dy*s[1]+dz*s[2])/sqrt(s[0]*s[0]+s[1]*s[1]+s[2]*s[2]);
+        return up/sqrt(dx*dx+dy*dy+dz*dz) - sin_min;
+    };
+}
+
+// point mass, J2 and drag acceleration of x_ = [pos, vel, mu, J2, C_D], the
+// common factors are taken out so that a dual evaluation does as few gradient
+// updates as possible
+template <class T>
+void GroundTrackingSolver::Acceleration(const T* x_, T* acc) const
+{
+    const T& x = x_[0];
+    const T& y = x_[1];
+    const T& z = x_[2];
+    const T& u = x_[3];
+    const T& v = x_[4];
+    const T& w = x_[5];
+    const T& mu = x_[6];
+    const T& J2 = x_[7];
+    const T& C_D = x_[8];
+    T uoy = u+omega_E*y;
+    T vox = v-omega_E*x;
+    T v_rel = sqrt(uoy*uoy+vox*vox+w*w);
+    T r2 = x*x+y*y+z*z;
+    T r = sqrt(r2);
+    T inv_r2 = 1/r2;
+
+    // mu/r^3, mu J2 R_e^2/r^5 and the drag factor -1/2 rho C_D A/m v_rel
+    T k = mu*inv_r2/r;
+    T P_G = (R_e*R_e)*J2*k*inv_r2;
+    T P_D = (-0.5*sat_area/970*rho_0)*exp((r_0-r)/H)*C_D*v_rel;
+    T g = k + P_G*(1.5 - (7.5*z*z)*inv_r2);
+
+    // the drag acts along (u + omega_E v, v - omega_E u, w)
+    acc[0] = P_D*(u + omega_E*v) - g*x;
+    acc[1] = P_D*(v - omega_E*u) - g*y;
+    acc[2] = P_D*w - (g + 3*P_G)*z;
+}
+
+// acceleration and rows 3-5 of A restricted to the first nine columns,
+// B = [d(acc)/d(pos) d(acc)/d(vel) d(acc)/d(mu, J2, C_D)], in one forward
+// mode pass
+void GroundTrackingSolver::StatePartials(const std::vector<double>& x_, Eigen::Matrix<double, 3, 9>& B,
+                                         double* acc) const
+{
+    Dual<9> s[9];
+    for (int i=0; i<9; i++)
+    {
+        s[i] = Dual<9>(x_[i], i);
+    }
+    Dual<9> a[3];
+    Acceleration(s, a);
+    for (int i=0; i<3; i++)
+    {
+        acc[i] = a[i].value();
+        B.row(i) = a[i].grad().transpose();
+    }
+}
+
+// A for the orbit, stations and every column of the transition matrix.  The
+// dependence of A*Phi on the orbit through A is left out, which is enough for
+// the W-methods and keeps the Jacobian block diagonal.
+int GroundTrackingSolver::Jacobian(double, const std::vector<double>& x_, Eigen::MatrixXd& J)
+{
+    const int ns = analytic_stations_ ? 9 : 18;
+    Eigen::Matrix<double, 3, 9> B;
+    double acc[3];
+    StatePartials(x_, B, acc);
+    Eigen::MatrixXd A = Eigen::MatrixXd::Zero(ns, ns);
+    A.block<3, 3>(0, 3).setIdentity();
+    A.block<3, 9>(3, 0) = B;
+    if (!analytic_stations_)
+    {
+        for (unsigned int i=0; i<3; i++)
+        {
+            A(9+3*i, 10+3*i) = -omega_E;
+            A(10+3*i, 9+3*i) = omega_E;
+        }
+    }
+
+    const int n = ns + ns*ns;
+    J = Eigen::MatrixXd::Zero(n, n);
+    J.topLeftCorner(ns, ns) = A;
+    for (int c=0; c<ns; c++)
+    {
+        J.block(ns + ns*c, ns + ns*c, ns, ns) = A;
+    }
+    return 0;
+}
+
+void GroundTrackingSolver::RightHandSide(double, const std::vector<double> &x_, std::vector<double> &f)
+{
+    // The 18x18 Jacobian A of the dynamics is mostly zero: rows 0-2 are the identity
+    // in the velocity columns, rows 6-8 (mu, J2, C_D) vanish and every station has
+    // a constant 2x2 rotation block.  Only rows 3-5 restricted to the first nine
+    // columns are state dependent, they come with the acceleration.
+    f[0] = x_[3];
+    f[1] = x_[4];
+    f[2] = x_[5];
     f[6] = 0;
     f[7] = 0;
     f[8] = 0;
-    f[9] = x_[10]*omega_E;
-    f[10] = -x_[9]*omega_E;
+
+    if (analytic_stations_)
+    {
+        Eigen::Map<const Eigen::Matrix<double, 9, 9> > Phi(x_.data()+9);
+        Eigen::Map<Eigen::Matrix<double, 9, 9> > dPhi(f.data()+9);
+
+        // seeded with the rows of Phi the forward pass carries B*Phi directly,
+        // at the cost of B alone
+        Dual<9> s[9];
+        for (int i=0; i<9; i++)
+        {
+            s[i] = Dual<9>(x_[i], Phi.row(i).transpose());
+        }
+        Dual<9> a[3];
+        Acceleration(s, a);
+        dPhi.topRows<3>() = Phi.middleRows<3>(3);
+        for (int i=0; i<3; i++)
+        {
+            f[3+i] = a[i].value();
+            dPhi.row(3+i) = a[i].grad().transpose();
+        }
+        dPhi.bottomRows<3>().setZero();
+        return;
+    }
+
+    // stations rotate with the Earth, consistent with the rotation blocks of A
+    f[9] = -x_[10]*omega_E;
+    f[10] = x_[9]*omega_E;
     f[11] = 0;
-    f[12] = x_[13]*omega_E;
-    f[13] = -x_[12]*omega_E;
+    f[12] = -x_[13]*omega_E;
+    f[13] = x_[12]*omega_E;
     f[14] = 0;
-    f[15] = x_[16]*omega_E;
-    f[16] = -x_[15]*omega_E;
+    f[15] = -x_[16]*omega_E;
+    f[16] = x_[15]*omega_E;
     f[17] = 0;
 
-    for (unsigned int i=0; i<18; i++) {
-        for (unsigned int j=0; j<18; j++) {
-            f[18+18*i+j] =0;
-            for (unsigned int k=0; k<18; k++) {
-                 f[18+18*i+j] = f[18+18*i+j] + A(j,k)*x_[18+18*i+k];
-            }
-        }
+    // variational equations dPhi/dt = A*Phi, the transition matrix is stored
+    // column major after the state; rows 3-5 of A*Phi come with the
+    // acceleration from the first nine rows of Phi as seeds
+    Eigen::Map<const Eigen::Matrix<double, 18, 18> > Phi(x_.data()+18);
+    Eigen::Map<Eigen::Matrix<double, 18, 18> > dPhi(f.data()+18);
+    Dual<18> s[9];
+    for (int i=0; i<9; i++)
+    {
+        s[i] = Dual<18>(x_[i], Phi.row(i).transpose());
+    }
+    Dual<18> a[3];
+    Acceleration(s, a);
+    for (int i=0; i<3; i++)
+    {
+        f[3+i] = a[i].value();
+        dPhi.row(3+i) = a[i].grad().transpose();
     }
 
+    dPhi.topRows<3>() = Phi.middleRows<3>(3);
+    dPhi.middleRows<3>(6).setZero();
+    for (unsigned int i=0; i<3; i++) {
+        dPhi.row(9+3*i) = -omega_E*Phi.row(10+3*i);
+        dPhi.row(10+3*i) = omega_E*Phi.row(9+3*i);
+        dPhi.row(11+3*i).setZero();
+    }
 }
 
-QVector3D GroundTrackingSolver::position()
+Vector3D GroundTrackingSolver::position()
 {
     double XG;
     double YG;
@@ -173,24 +279,50 @@ QVector3D GroundTrackingSolver::position()
     YG = state[1];
     ZG = state[2];
 
-    return QVector3D(XG, YG, ZG);
+    return Vector3D(XG, YG, ZG);
 }
 
 
-void GroundTrackingSolver::getState(Eigen::VectorXd& st)
+void GroundTrackingSolver::GetState(double* st) const
 {
-    st = Eigen::VectorXd(18);
+    if (analytic_stations_)
+    {
+        for (int i=0; i<9; i++ )
+        {
+             st[i] = state[i];
+        }
+        RotateStations(t_-station_epoch_, st+9);
+        return;
+    }
     for (int i=0; i<18; i++ )
     {
-         st(i) = state[i];
+         st[i] = state[i];
     }
 }
 
-void GroundTrackingSolver::setState(const Eigen::VectorXd& st)
+void GroundTrackingSolver::SetState(const double* st)
 {
+    if (analytic_stations_)
+    {
+        for (int i=0; i<9; i++ )
+        {
+             state[i] = st[i];
+             stations_[i] = st[9+i];
+        }
+        station_epoch_ = t_;
+        for (unsigned int i=9; i<9+9*9; i++)
+        {
+            state[i] = 0;
+        }
+        for (unsigned int i=0; i<9; i++)
+        {
+            state[9+10*i] = 1;
+        }
+        return;
+    }
     for (int i=0; i<18; i++ )
     {
-         state[i] = st(i);
+         state[i] = st[i];
     }
     for (unsigned int i=18; i<18+18*18; i++)
     {
@@ -202,11 +334,65 @@ void GroundTrackingSolver::setState(const Eigen::VectorXd& st)
     }
 }
 
-void GroundTrackingSolver::getTransitionMatrix(Eigen::MatrixXd& mat)
+void GroundTrackingSolver::GetTransitionMatrix(double* mat) const
 {
+    Eigen::Map<Eigen::Matrix<double, 18, 18> > Phi(mat);
+    if (analytic_stations_)
+    {
+        // orbit block from the variational equations, the stations only rotate
+        // since the last setState
+        Phi.setZero();
+        for (unsigned int i=0; i<9; i++) {
+            for (unsigned int j=0; j<9;j++) {
+                Phi(i,j) = state[9+9*j+i];
+            }
+        }
+        double c = cos(omega_E*(t_-station_epoch_));
+        double s = sin(omega_E*(t_-station_epoch_));
+        for (unsigned int i=9; i<18; i+=3) {
+            Phi(i,i) = c;
+            Phi(i,i+1) = -s;
+            Phi(i+1,i) = s;
+            Phi(i+1,i+1) = c;
+            Phi(i+2,i+2) = 1;
+        }
+        return;
+    }
     for (unsigned int i=0; i<18; i++) {
         for (unsigned int j=0; j<18;j++) {
-            mat(i,j) = state[18+18*j+i];
+            Phi(i,j) = state[18+18*j+i];
         }
     }
 }
+
+void GroundTrackingSolver::getState(Eigen::VectorXd& st)
+{
+    st.resize(18);
+    GetState(st.data());
+}
+
+void GroundTrackingSolver::setState(const Eigen::VectorXd& st)
+{
+    SetState(st.data());
+}
+
+void GroundTrackingSolver::getState(Eigen::Matrix<double, 18, 1>& st)
+{
+    GetState(st.data());
+}
+
+void GroundTrackingSolver::setState(const Eigen::Matrix<double, 18, 1>& st)
+{
+    SetState(st.data());
+}
+
+void GroundTrackingSolver::getTransitionMatrix(Eigen::MatrixXd& mat)
+{
+    mat.resize(18, 18);
+    GetTransitionMatrix(mat.data());
+}
+
+void GroundTrackingSolver::getTransitionMatrix(Eigen::Matrix<double, 18, 18>& mat)
+{
+    GetTransitionMatrix(mat.data());
+}
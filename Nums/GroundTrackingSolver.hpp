@@ -1,19 +1,41 @@
 #ifndef GROUNDTRACKINGSOLVER_H
 #define GROUNDTRACKINGSOLVER_H
 
-#include "Common/Output.hpp"
 #include "Orbital/Omt.hpp"
 #include "Eigen/Dense"
 
-#include <QVector3D>
-#include <QtCharts>
+#include "Vector3D.hpp"
+#include "Dual.hpp"
 
 #include "RungeKuttaSolver.hpp"
 
 using namespace std;
 
+/* Satellite orbit with estimated mu, J2, C_D and three tracking stations,
+ * propagated together with the 18x18 state transition matrix.
+ * With analytic stations only the orbit and parameters (9 states and a 9x9
+ * transition matrix) are integrated.  The stations are kept at their positions
+ * from the last setState and rotated about z in closed form, the 18 state
+ * interface of getState/setState/getTransitionMatrix is unchanged.
+ */
 class GroundTrackingSolver : public RungeKuttaSolver
 {
+private:
+    bool analytic_stations_ = false;
+    // station positions at time station_epoch_
+    double stations_[9];
+    double station_epoch_ = 0;
+
+    void RotateStations(double dt, double* st) const;
+    // point mass, J2 and drag acceleration, with T = double or a Dual
+    template <class T>
+    void Acceleration(const T* x_, T* acc) const;
+    // acceleration acc and its partials B with respect to the orbit and parameters
+    void StatePartials(const std::vector<double>& x_, Eigen::Matrix<double, 3, 9>& B, double* acc) const;
+    // 18 state and column major 18x18 transition matrix behind both interfaces
+    void GetState(double* st) const;
+    void SetState(const double* st);
+    void GetTransitionMatrix(double* mat) const;
 public:
     // orbital mechanics toolbox
     Omt omt;
@@ -21,16 +43,29 @@ public:
     void InitialConditions();
     void InitialConditions(Eigen::VectorXd& x, double dt);
     void RightHandSide(double t, const std::vector<double>& x_, std::vector<double> &  f);
+    int Jacobian(double t, const std::vector<double>& x_, Eigen::MatrixXd& J);
 
     void getState(Eigen::VectorXd& st);
     void setState(const Eigen::VectorXd& st);
+    // fixed size versions, which do not allocate
+    void getState(Eigen::Matrix<double, 18, 1>& st);
+    void setState(const Eigen::Matrix<double, 18, 1>& st);
 
     // outputs from the simulation
-    QVector3D position();
-    QVector3D velocity();
+    Vector3D position();
+    Vector3D velocity();
     void getTransitionMatrix(Eigen::MatrixXd& mat);
+    void getTransitionMatrix(Eigen::Matrix<double, 18, 18>& mat);
 
     double eccentricity();
+
+    // event function for AddEvent, sine of the elevation of the satellite seen from
+    // station (0..2) minus that of min_elevation [rad]; rises at AOS and falls at LOS
+    EventFunction ElevationEvent(int station, double min_elevation);
+
+    // has to be set before InitialConditions
+    void SetAnalyticStations(bool analytic);
+    bool analytic_stations() const;
 };
 
 #endif // GROUNDTRACKINGSOLVER_H
@@ -0,0 +1,114 @@
+#include "KSRestricted3BodySolver.hpp"
+
+#include <cmath>
+
+const double G = 6.67259e-20;
+const double m1 = 5.9742e24;
+const double m2 = 7.348e22;
+
+const double h = 2*M_PI/100;
+
+const double mu1 = G*m1;
+const double mu2 = G*m2;
+const double pi1 = m1/(m1+m2);
+const double pi2 = m2/(m1+m2);
+
+const double r12 = 384400;
+const double R1 = 6378;
+const double R2 = 1737;
+
+const double Omega = sqrt(G*(m1+m2)/(r12*r12*r12));
+
+KSRestricted3BodySolver::KSRestricted3BodySolver()
+{
+    switching_radius_ = r12*pow(m2/m1, 0.4);
+}
+
+void KSRestricted3BodySolver::InitialConditions()
+{
+    SetStepSize(h);
+
+    double phi = -90*(M_PI/180);
+    double gamma = 20*(M_PI/180);
+    double vbo = 10.9148;
+
+    Eigen::VectorXd x(6);
+    x << (6378+200)*cos(phi)-pi2*r12, (6378+200)*sin(phi), 0,
+         vbo*cos(phi+M_PI/2-gamma), vbo*sin(phi+M_PI/2-gamma), 0;
+    t_ = 0;
+    setState(x);
+
+    SetInitialValue(state);
+    SetTimeInterval(0, 400);
+}
+
+void KSRestricted3BodySolver::PerturbingAcceleration(double, const Eigen::Vector3d& r, const Eigen::Vector3d& v,
+                                                     Eigen::Vector3d& a)
+{
+    a << 2*Omega*v(1) + Omega*Omega*r(0),
+         -2*Omega*v(0) + Omega*Omega*r(1),
+         0;
+    // the primary that is not expanded about
+    Eigen::Vector3d d = primary_ == 0 ? Eigen::Vector3d(r(0)-pi1*r12, r(1), r(2))
+                                      : Eigen::Vector3d(r(0)+pi2*r12, r(1), r(2));
+    double mu = primary_ == 0 ? mu2 : mu1;
+    double dist = d.norm();
+    a -= mu*d/(dist*dist*dist);
+}
+
+void KSRestricted3BodySolver::SelectPrimary(const Eigen::Vector3d& r)
+{
+    double r2 = sqrt((r(0)-pi1*r12)*(r(0)-pi1*r12) + r(1)*r(1) + r(2)*r(2));
+    int primary = r2 < switching_radius_ ? 1 : 0;
+    if (primary == primary_)
+    {
+        return;
+    }
+    primary_ = primary;
+    if (primary == 1)
+    {
+        SetPrimary(Eigen::Vector3d(pi1*r12, 0, 0), mu2, R2);
+    }
+    else
+    {
+        SetPrimary(Eigen::Vector3d(-pi2*r12, 0, 0), mu1, R1);
+    }
+}
+
+void KSRestricted3BodySolver::SetSwitchingRadius(double radius)
+{
+    switching_radius_ = radius;
+}
+
+int KSRestricted3BodySolver::primary() const
+{
+    return primary_;
+}
+
+Vector3D KSRestricted3BodySolver::position()
+{
+    return Vector3D(state[0], state[1], state[2]);
+}
+
+Vector3D KSRestricted3BodySolver::velocity()
+{
+    return Vector3D(state[3], state[4], state[5]);
+}
+
+Vector3D KSRestricted3BodySolver::body1pos()
+{
+    return Vector3D(-pi2*r12, 0, 0);
+}
+
+Vector3D KSRestricted3BodySolver::body2pos()
+{
+    return Vector3D(pi1*r12, 0, 0);
+}
+
+double KSRestricted3BodySolver::jacobi_constant()
+{
+    double r1 = sqrt((state[0]+pi2*r12)*(state[0]+pi2*r12) + state[1]*state[1] + state[2]*state[2]);
+    double r2 = sqrt((state[0]-pi1*r12)*(state[0]-pi1*r12) + state[1]*state[1] + state[2]*state[2]);
+    double v2 = state[3]*state[3] + state[4]*state[4] + state[5]*state[5];
+    return Omega*Omega*(state[0]*state[0]+state[1]*state[1]) + 2*mu1/r1 + 2*mu2/r2 - v2;
+}
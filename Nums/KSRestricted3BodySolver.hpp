@@ -0,0 +1,45 @@
+#ifndef KSRESTRICTED3BODYSOLVER_H
+#define KSRESTRICTED3BODYSOLVER_H
+
+#include "KSSolver.hpp"
+#include "Eigen/Dense"
+
+#include "Vector3D.hpp"
+
+/* Circular restricted three body problem (Earth-Moon) in the rotating frame,
+ * the problem of Restricted3BodySolver extended to z, propagated in KS
+ * variables about the nearer primary.  The expansion moves to the Moon inside
+ * its sphere of influence (r12 (m2/m1)^(2/5), about 66000 km) and back to the
+ * Earth outside of it, the other primary and the Coriolis and centrifugal
+ * terms are the perturbation.  Launch and lunar swing-by then take the same
+ * number of steps per eccentric anomaly as the coast between them.
+ */
+class KSRestricted3BodySolver : public KSSolver
+{
+private:
+    // 0 for the Earth, 1 for the Moon, -1 before the first state
+    int primary_ = -1;
+    double switching_radius_;
+public:
+    KSRestricted3BodySolver();
+
+    // define initial conditions and the dynamics equation
+    void InitialConditions();
+    void PerturbingAcceleration(double t, const Eigen::Vector3d& r, const Eigen::Vector3d& v,
+                                Eigen::Vector3d& a);
+    void SelectPrimary(const Eigen::Vector3d& r);
+
+    // distance from the Moon below which the expansion is about the Moon
+    void SetSwitchingRadius(double radius);
+    int primary() const;
+
+    // outputs from the simulation
+    Vector3D position();
+    Vector3D velocity();
+    Vector3D body1pos();
+    Vector3D body2pos();
+    // Jacobi constant, conserved by the exact flow
+    double jacobi_constant();
+};
+
+#endif // KSRESTRICTED3BODYSOLVER_H
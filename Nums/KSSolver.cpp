@@ -0,0 +1,267 @@
+#include "KSSolver.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+KSSolver::KSSolver()
+{
+    w_.fill(0.0);
+    w_prev_.fill(0.0);
+    state.assign(6, 0.0);
+    SetStepSize(0.1);
+}
+
+Eigen::Matrix4d KSSolver::KSMatrix(const Eigen::Vector4d& u)
+{
+    Eigen::Matrix4d L;
+    L << u(0), -u(1), -u(2),  u(3),
+         u(1),  u(0), -u(3), -u(2),
+         u(2),  u(3),  u(0),  u(1),
+         u(3), -u(2),  u(1), -u(0);
+    return L;
+}
+
+void KSSolver::ToKS(const Eigen::Vector3d& r, const Eigen::Vector3d& v,
+                    Eigen::Vector4d& u, Eigen::Vector4d& du)
+{
+    double r_norm = r.norm();
+    // the branch with the larger square root avoids the cancellation
+    if (r(0) >= 0)
+    {
+        u(0) = sqrt(0.5*(r_norm + r(0)));
+        u(1) = r(1)/(2*u(0));
+        u(2) = r(2)/(2*u(0));
+        u(3) = 0;
+    }
+    else
+    {
+        u(1) = sqrt(0.5*(r_norm - r(0)));
+        u(0) = r(1)/(2*u(1));
+        u(3) = r(2)/(2*u(1));
+        u(2) = 0;
+    }
+    Eigen::Vector4d v4(v(0), v(1), v(2), 0);
+    du = 0.5*KSMatrix(u).transpose()*v4;
+}
+
+void KSSolver::FromKS(const Eigen::Vector4d& u, const Eigen::Vector4d& du,
+                      Eigen::Vector3d& r, Eigen::Vector3d& v)
+{
+    Eigen::Matrix4d L = KSMatrix(u);
+    r = (L*u).head<3>();
+    v = (2/u.squaredNorm())*(L*du).head<3>();
+}
+
+void KSSolver::ToCartesian(const State& w, Eigen::Vector3d& r, Eigen::Vector3d& v) const
+{
+    Eigen::Vector4d u(w[0], w[1], w[2], w[3]);
+    Eigen::Vector4d du(w[4], w[5], w[6], w[7]);
+    FromKS(u, du, r, v);
+    r += center_;
+}
+
+void KSSolver::FromCartesian(const Eigen::Vector3d& r, const Eigen::Vector3d& v, double t, State& w) const
+{
+    Eigen::Vector3d x = r - center_;
+    Eigen::Vector4d u, du;
+    ToKS(x, v, u, du);
+    for (int i=0; i<4; i++)
+    {
+        w[i] = u(i);
+        w[4+i] = du(i);
+    }
+    w[8] = mu_/x.norm() - 0.5*v.squaredNorm();
+    w[9] = t;
+}
+
+void KSSolver::SetPrimary(const Eigen::Vector3d& center, double mu, double radius)
+{
+    Eigen::Vector3d r, v;
+    bool transform = started_;
+    if (transform)
+    {
+        ToCartesian(w_, r, v);
+    }
+    center_ = center;
+    mu_ = mu;
+    radius_ = radius;
+    if (transform)
+    {
+        FromCartesian(r, v, w_[9], w_);
+        Derivatives(w_, f_);
+        w_prev_ = w_;
+        f_prev_ = f_;
+        ds_last_ = 0;
+        switches_++;
+    }
+}
+
+void KSSolver::Derivatives(const State& w, State& f)
+{
+    rhs_evaluations_++;
+    Eigen::Vector4d u(w[0], w[1], w[2], w[3]);
+    Eigen::Vector4d du(w[4], w[5], w[6], w[7]);
+    double h = w[8];
+    double r = u.squaredNorm();
+    Eigen::Matrix4d L = KSMatrix(u);
+
+    Eigen::Vector3d x = center_ + (L*u).head<3>();
+    Eigen::Vector3d v = (2/r)*(L*du).head<3>();
+    Eigen::Vector3d a;
+    PerturbingAcceleration(w[9], x, v, a);
+    Eigen::Vector4d LtP = L.transpose()*Eigen::Vector4d(a(0), a(1), a(2), 0);
+
+    Eigen::Vector4d ddu = -0.5*h*u + 0.5*r*LtP;
+    for (int i=0; i<4; i++)
+    {
+        f[i] = du(i);
+        f[4+i] = ddu(i);
+    }
+    f[8] = -2*du.dot(LtP);
+    f[9] = r;
+}
+
+void KSSolver::Step(double ds)
+{
+    w_prev_ = w_;
+    f_prev_ = f_;
+    // autonomous in s, the time is part of the state; the last stage is
+    // evaluated at the new node
+    stepper_.k(0) = f_;
+    stepper_.Advance([this](double, const State& wi, State& fi) { Derivatives(wi, fi); }, 0, ds, w_prev_, w_);
+    f_ = stepper_.k(6);
+    ds_last_ = ds;
+    steps_++;
+}
+
+void KSSolver::Interpolate(double t, std::vector<double>& y) const
+{
+    State w = w_;
+    if (ds_last_ > 0 && t < w_[9])
+    {
+        // Newton on the time component, dt/dsigma = ds r
+        double t0 = w_prev_[9];
+        double t1 = w_[9];
+        double d0 = ds_last_*f_prev_[9];
+        double d1 = ds_last_*f_[9];
+        double sigma = (t - t0)/(t1 - t0);
+        for (int i=0; i<20; i++)
+        {
+            double s2 = sigma*sigma;
+            double value = (2*s2*sigma - 3*s2 + 1)*t0 + (s2*sigma - 2*s2 + sigma)*d0
+                    + (-2*s2*sigma + 3*s2)*t1 + (s2*sigma - s2)*d1;
+            double slope = (6*s2 - 6*sigma)*(t0 - t1) + (3*s2 - 4*sigma + 1)*d0 + (3*s2 - 2*sigma)*d1;
+            double step = (t - value)/slope;
+            sigma += step;
+            if (std::abs(step) < 1e-15) break;
+        }
+        double s2 = sigma*sigma;
+        double h00 = 2*s2*sigma - 3*s2 + 1;
+        double h10 = (s2*sigma - 2*s2 + sigma)*ds_last_;
+        double h01 = -2*s2*sigma + 3*s2;
+        double h11 = (s2*sigma - s2)*ds_last_;
+        for (int i=0; i<10; i++)
+        {
+            w[i] = h00*w_prev_[i] + h10*f_prev_[i] + h01*w_[i] + h11*f_[i];
+        }
+    }
+    Eigen::Vector3d r, v;
+    ToCartesian(w, r, v);
+    y.resize(6);
+    for (int i=0; i<3; i++)
+    {
+        y[i] = r(i);
+        y[3+i] = v(i);
+    }
+}
+
+void KSSolver::UpdateState(double dt)
+{
+    terminated_ = false;
+    double t_target = t_ + dt;
+    // events are searched up to the end of each step, starting with the rest
+    // of the current one
+    double t_checked = t_;
+    while (true)
+    {
+        double t_end = std::min(w_[9], t_target);
+        double t_stop;
+        if (has_events() && t_end > t_checked
+                && LocateEvents(t_checked, t_end,
+                                [this](double t, std::vector<double>& y) { Interpolate(t, y); }, t_stop))
+        {
+            Interpolate(t_stop, state);
+            t_ = t_stop;
+            return;
+        }
+        t_checked = std::max(t_checked, t_end);
+        if (w_[9] >= t_target)
+        {
+            break;
+        }
+        Eigen::Vector3d r, v;
+        ToCartesian(w_, r, v);
+        SelectPrimary(r);
+        Step(mStepSize*sqrt(radius_/mu_));
+    }
+    Interpolate(t_target, state);
+    t_ = t_target;
+}
+
+void KSSolver::SolveEquation(std::vector<double>)
+{
+    Eigen::VectorXd x(6);
+    for (int i=0; i<6; i++)
+    {
+        x(i) = mInitialValueVector[i];
+    }
+    t_ = mInitialTime;
+    setState(x);
+    UpdateState(mFinalTime - mInitialTime);
+}
+
+void KSSolver::getState(Eigen::VectorXd& x)
+{
+    x.resize(6);
+    for (int i=0; i<6; i++)
+    {
+        x(i) = state[i];
+    }
+}
+
+void KSSolver::setState(const Eigen::VectorXd& x)
+{
+    for (int i=0; i<6; i++)
+    {
+        state[i] = x(i);
+    }
+    Eigen::Vector3d r(x(0), x(1), x(2));
+    Eigen::Vector3d v(x(3), x(4), x(5));
+    started_ = false;
+    SelectPrimary(r);
+    FromCartesian(r, v, t_, w_);
+    Derivatives(w_, f_);
+    w_prev_ = w_;
+    f_prev_ = f_;
+    ds_last_ = 0;
+    started_ = true;
+}
+
+void KSSolver::SelectPrimary(const Eigen::Vector3d&)
+{
+}
+
+long KSSolver::steps() const
+{
+    return steps_;
+}
+
+long KSSolver::rhs_evaluations() const
+{
+    return rhs_evaluations_;
+}
+
+long KSSolver::switches() const
+{
+    return switches_;
+}
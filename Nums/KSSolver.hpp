@@ -0,0 +1,102 @@
+#ifndef KSSOLVER_H
+#define KSSOLVER_H
+
+#include <array>
+#include <vector>
+#include "Eigen/Dense"
+
+#include "AbstractOdeSolver.hpp"
+#include "RungeKuttaStepper.hpp"
+
+/* Kustaanheimo-Stiefel regularised propagation about a primary of
+ * gravitational parameter mu.  The position x relative to the primary is the
+ * KS map x = L(u) u of u in R^4, and with the Sundman transformation
+ * dt = r ds to the fictitious time s the perturbed Kepler problem
+ * x'' = -mu x/r^3 + P becomes (Stiefel and Scheifele 1971)
+ *   u'' + (h/2) u = (r/2) L(u)^T P,   h' = -2 u'.L(u)^T P,   t' = r
+ * with h = mu/r - v^2/2, a harmonic oscillator without the 1/r^3 singularity.
+ * The 5th order Dormand-Prince formula then takes uniform steps in s, which
+ * are short in t near the primary and long far from it, about a constant step
+ * in eccentric anomaly.
+ *
+ * The step size of SetStepSize is made dimensionless with the radius R of the
+ * primary, ds = h sqrt(R/mu): the eccentric anomaly advances by h sqrt(R/a) a
+ * step.  The fictitious steps run on independently of the requested times,
+ * UpdateState finds s for t + dt by Newton's method on the cubic Hermite
+ * interpolant of the last step, whose end derivatives are the first and last
+ * stages of the formula.
+ *
+ * SelectPrimary is called before every step and may move the expansion to
+ * another primary with SetPrimary, the Cartesian state is kept.  The state is
+ * [x, y, z, u, v, w] in the frame of the primaries.  Events are located on the
+ * same interpolant, so an event function of that state (e.g. the distance to
+ * a primary for a sphere of influence crossing) is resolved within the long
+ * steps far from the primaries.
+ */
+class KSSolver : public AbstractOdeSolver
+{
+private:
+    // KS state [u, u', h, t] about the current primary
+    typedef std::array<double, 10> State;
+    State w_;
+    // node before the last step and the derivatives at both nodes
+    State w_prev_;
+    State f_;
+    State f_prev_;
+    double ds_last_ = 0;
+    Eigen::Vector3d center_ = Eigen::Vector3d::Zero();
+    double mu_ = 0;
+    double radius_ = 1;
+    // set once setState gave a state to transform
+    bool started_ = false;
+    FixedRungeKutta<10, DormandPrince54Tableau> stepper_;
+
+    long steps_ = 0;
+    long rhs_evaluations_ = 0;
+    long switches_ = 0;
+
+    void Derivatives(const State& w, State& f);
+    void Step(double ds);
+    void ToCartesian(const State& w, Eigen::Vector3d& r, Eigen::Vector3d& v) const;
+    void FromCartesian(const Eigen::Vector3d& r, const Eigen::Vector3d& v, double t, State& w) const;
+    // Cartesian state y at t between w_prev_ and w_
+    void Interpolate(double t, std::vector<double>& y) const;
+protected:
+    std::vector<double> state;
+
+    // expands about the primary at center, the first call sets it up, later
+    // calls transform the current state
+    void SetPrimary(const Eigen::Vector3d& center, double mu, double radius);
+public:
+    KSSolver();
+
+    // KS map from the position and velocity relative to the primary to u and
+    // u' = du/ds (with u4 = 0 or u3 = 0, the bilinear relation holds)
+    static void ToKS(const Eigen::Vector3d& r, const Eigen::Vector3d& v,
+                     Eigen::Vector4d& u, Eigen::Vector4d& du);
+    static void FromKS(const Eigen::Vector4d& u, const Eigen::Vector4d& du,
+                       Eigen::Vector3d& r, Eigen::Vector3d& v);
+    static Eigen::Matrix4d KSMatrix(const Eigen::Vector4d& u);
+
+    // implementations of virtual methods from inherited class
+    void UpdateState(double dt);
+    void SolveEquation(std::vector<double> yi);
+
+    // state at the current time, setState restarts the fictitious steps
+    void getState(Eigen::VectorXd& x);
+    void setState(const Eigen::VectorXd& x);
+
+    long steps() const;
+    long rhs_evaluations() const;
+    long switches() const;
+
+    // virtual methods
+    virtual void InitialConditions() = 0;
+    // acceleration other than the central term of the current primary
+    virtual void PerturbingAcceleration(double t, const Eigen::Vector3d& r, const Eigen::Vector3d& v,
+                                        Eigen::Vector3d& a) = 0;
+    // chooses the primary for the next step at position r, nothing by default
+    virtual void SelectPrimary(const Eigen::Vector3d& r);
+};
+
+#endif // KSSOLVER_H
@@ -0,0 +1,54 @@
+#include "KSTwoBodySolver.hpp"
+
+#include <cmath>
+
+// about 100 steps per revolution of an orbit with a = R_e
+const double h = 2*M_PI/100;
+const double G = 6.67259e-20;
+const double m1 = 5.974e24;
+const double mu = G*m1;
+const double R_e = 6378.1363;
+
+void KSTwoBodySolver::InitialConditions()
+{
+    Eigen::Vector3d Rx, Vx;
+    // satellite orbit
+    Rx << 757.7, 5222.607, 4851.5;
+    Vx << 2.21321, 4.67834, -5.37130;
+    InitialConditions(Rx, Vx);
+}
+
+void KSTwoBodySolver::InitialConditions(Eigen::Vector3d r, Eigen::Vector3d v)
+{
+    SetPrimary(Eigen::Vector3d::Zero(), mu, R_e);
+    SetStepSize(h);
+    t_ = 0;
+
+    Eigen::VectorXd x(6);
+    x << r, v;
+    setState(x);
+    SetInitialValue(state);
+}
+
+void KSTwoBodySolver::PerturbingAcceleration(double, const Eigen::Vector3d&, const Eigen::Vector3d&,
+                                             Eigen::Vector3d& a)
+{
+    a.setZero();
+}
+
+Vector3D KSTwoBodySolver::position()
+{
+    return Vector3D(state[0], state[1], state[2]);
+}
+
+Vector3D KSTwoBodySolver::velocity()
+{
+    return Vector3D(state[3], state[4], state[5]);
+}
+
+double KSTwoBodySolver::energy()
+{
+    double r = sqrt(state[0]*state[0] + state[1]*state[1] + state[2]*state[2]);
+    double v2 = state[3]*state[3] + state[4]*state[4] + state[5]*state[5];
+    return 0.5*v2 - mu/r;
+}
@@ -0,0 +1,30 @@
+#ifndef KSTWOBODYSOLVER_H
+#define KSTWOBODYSOLVER_H
+
+#include "KSSolver.hpp"
+#include "Eigen/Dense"
+
+#include "Vector3D.hpp"
+
+/* Satellite around a point mass Earth, the same problem as TwoBodySolver but
+ * propagated in KS variables.  Without perturbations the KS equations are
+ * linear, so the error comes only from the oscillator phase and stays
+ * uniform around eccentric orbits.
+ */
+class KSTwoBodySolver : public KSSolver
+{
+public:
+    // define initial conditions and the dynamics equation
+    void InitialConditions();
+    void InitialConditions(Eigen::Vector3d r, Eigen::Vector3d v);
+    void PerturbingAcceleration(double t, const Eigen::Vector3d& r, const Eigen::Vector3d& v,
+                                Eigen::Vector3d& a);
+
+    // outputs from the simulation
+    Vector3D position();
+    Vector3D velocity();
+    // specific orbital energy
+    double energy();
+};
+
+#endif // KSTWOBODYSOLVER_H
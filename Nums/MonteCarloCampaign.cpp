@@ -0,0 +1,143 @@
+#include "MonteCarloCampaign.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <sstream>
+
+MonteCarloCampaign::MonteCarloCampaign(ThreadPool& pool)
+    : pool_(pool)
+{
+}
+
+void MonteCarloCampaign::SetSeed(unsigned long seed)
+{
+    seed_ = seed;
+}
+
+void MonteCarloCampaign::SetOutputPrefix(const std::string& prefix)
+{
+    prefix_ = prefix;
+}
+
+long MonteCarloCampaign::runs() const
+{
+    return runs_;
+}
+
+const Eigen::VectorXd& MonteCarloCampaign::mean() const
+{
+    return mean_;
+}
+
+const Eigen::MatrixXd& MonteCarloCampaign::covariance() const
+{
+    return covariance_;
+}
+
+double MonteCarloCampaign::mean_miss() const
+{
+    return mean_miss_;
+}
+
+double MonteCarloCampaign::MissPercentile(double p) const
+{
+    if (miss_.empty())
+    {
+        return 0;
+    }
+    // linear interpolation between the order statistics
+    double pos = std::min(1.0, std::max(0.0, p))*(miss_.size()-1);
+    unsigned long i = static_cast<unsigned long>(pos);
+    if (i+1 >= miss_.size())
+    {
+        return miss_.back();
+    }
+    return miss_[i] + (pos-i)*(miss_[i+1]-miss_[i]);
+}
+
+// Welford update of the worker's mean and scatter matrix with acc.result
+void MonteCarloCampaign::Accumulate(Accumulator& acc, long run, double miss)
+{
+    acc.n++;
+    acc.delta = acc.result - acc.mean;
+    acc.mean += acc.delta/acc.n;
+    acc.m2.noalias() += ((acc.n-1.0)/acc.n)*acc.delta*acc.delta.transpose();
+
+    if (acc.output.is_open())
+    {
+        acc.output << run << " " << miss;
+        for (int j=0; j<acc.result.size(); j++)
+        {
+            acc.output << " " << acc.result(j);
+        }
+        acc.output << "\n";
+    }
+}
+
+int MonteCarloCampaign::Run(long num_runs, int result_dim, const RunFunction& run)
+{
+    const int num_workers = pool_.size();
+    std::vector<std::unique_ptr<Accumulator> > acc;
+    for (int w=0; w<num_workers; w++)
+    {
+        acc.emplace_back(new Accumulator);
+        acc[w]->n = 0;
+        acc[w]->mean = Eigen::VectorXd::Zero(result_dim);
+        acc[w]->m2 = Eigen::MatrixXd::Zero(result_dim, result_dim);
+        acc[w]->result = Eigen::VectorXd::Zero(result_dim);
+        acc[w]->delta = Eigen::VectorXd::Zero(result_dim);
+        if (!prefix_.empty())
+        {
+            std::ostringstream name;
+            name << prefix_ << "." << w << ".csv";
+            acc[w]->output.open(name.str().c_str());
+            if (!acc[w]->output.is_open())
+            {
+                return 1;
+            }
+            acc[w]->output.precision(17);
+        }
+    }
+    // every run writes only its own slot
+    miss_.assign(num_runs, 0.0);
+
+    long grain = std::max(1L, num_runs/(16*num_workers));
+    pool_.ParallelFor(0, num_runs, grain, [&](long i, int worker)
+    {
+        // independent stream per run, reproducible whatever thread executes it
+        unsigned long long seed = seed_;
+        unsigned long long index = i;
+        std::seed_seq seq{static_cast<unsigned>(seed), static_cast<unsigned>(seed >> 32),
+                          static_cast<unsigned>(index), static_cast<unsigned>(index >> 32)};
+        std::mt19937_64 rng(seq);
+        Accumulator& a = *acc[worker];
+        double miss = run(i, rng, a.result);
+        miss_[i] = miss;
+        Accumulate(a, i, miss);
+    });
+
+    // merge the per worker statistics (Chan et al. pairwise update)
+    runs_ = 0;
+    mean_ = Eigen::VectorXd::Zero(result_dim);
+    Eigen::MatrixXd m2 = Eigen::MatrixXd::Zero(result_dim, result_dim);
+    for (int w=0; w<num_workers; w++)
+    {
+        const Accumulator& a = *acc[w];
+        if (a.n == 0) continue;
+        long n = runs_ + a.n;
+        Eigen::VectorXd d = a.mean - mean_;
+        mean_ += d*(static_cast<double>(a.n)/n);
+        m2 += a.m2 + d*d.transpose()*(static_cast<double>(runs_)*a.n/n);
+        runs_ = n;
+    }
+    covariance_ = runs_ > 1 ? Eigen::MatrixXd(m2/(runs_-1)) : m2;
+
+    double sum = 0;
+    for (long i=0; i<num_runs; i++)
+    {
+        sum += miss_[i];
+    }
+    mean_miss_ = num_runs > 0 ? sum/num_runs : 0;
+    std::sort(miss_.begin(), miss_.end());
+    return 0;
+}
@@ -0,0 +1,76 @@
+#ifndef MONTECARLOCAMPAIGN_H
+#define MONTECARLOCAMPAIGN_H
+
+#include <fstream>
+#include <functional>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "Eigen/Dense"
+#include "ThreadPool.hpp"
+
+/* Runs a Monte Carlo campaign of independent simulations on a thread pool.
+ * A run is any function that draws its dispersions (initial state, drag
+ * coefficient, measurement noise, ...) from the random number generator it is
+ * given, propagates with one of the solvers, fills a fixed length result
+ * vector and returns the miss distance of the run.
+ *
+ * Every run gets its own generator seeded from (campaign seed, run index), so
+ * the results do not depend on the number of threads or on the scheduling.
+ * Each worker accumulates mean and covariance of the results on its own
+ * (Welford) and writes its runs to its own file, the per worker statistics
+ * are merged once all runs are done.  Apart from one double per run for the
+ * miss distance percentiles nothing is kept in memory.
+ */
+class MonteCarloCampaign
+{
+public:
+    typedef std::function<double(long run, std::mt19937_64& rng, Eigen::VectorXd& result)> RunFunction;
+
+    explicit MonteCarloCampaign(ThreadPool& pool);
+
+    void SetSeed(unsigned long seed);
+    // runs are streamed to <prefix>.<worker>.csv as "run miss result...", empty prefix disables output
+    void SetOutputPrefix(const std::string& prefix);
+
+    // executes runs [0, num_runs), returns 1 if an output file could not be opened and 0 otherwise
+    int Run(long num_runs, int result_dim, const RunFunction& run);
+
+    long runs() const;
+    const Eigen::VectorXd& mean() const;
+    // sample covariance of the results
+    const Eigen::MatrixXd& covariance() const;
+    double mean_miss() const;
+    // miss distance below which a fraction p (0..1) of the runs fall
+    double MissPercentile(double p) const;
+
+private:
+    // statistics of the runs done by one worker, allocated separately and padded
+    // so that workers do not share cache lines
+    struct Accumulator
+    {
+        long n;
+        Eigen::VectorXd mean;
+        Eigen::MatrixXd m2;
+        Eigen::VectorXd result;
+        Eigen::VectorXd delta;
+        std::ofstream output;
+        char padding[64];
+    };
+
+    ThreadPool& pool_;
+    unsigned long seed_ = 0;
+    std::string prefix_;
+
+    long runs_ = 0;
+    Eigen::VectorXd mean_;
+    Eigen::MatrixXd covariance_;
+    std::vector<double> miss_;
+    double mean_miss_ = 0;
+
+    void Accumulate(Accumulator& acc, long run, double miss);
+};
+
+#endif // MONTECARLOCAMPAIGN_H
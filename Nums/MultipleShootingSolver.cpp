@@ -0,0 +1,152 @@
+#include "MultipleShootingSolver.hpp"
+
+#include <cassert>
+#include <iostream>
+
+MultipleShootingSolver::MultipleShootingSolver(DifferentialSystem* p_ode, int num_segments, int dim, ThreadPool& pool)
+    : p_ode_(p_ode), pool_(pool), num_segments_(num_segments), dim_(dim)
+{
+    assert(num_segments >= 1);
+    mesh_ = Eigen::VectorXd::LinSpaced(num_segments+1, p_ode->t_min_, p_ode->t_max_);
+    sol_vec_ = Eigen::VectorXd::Zero((num_segments+1)*dim);
+    for (int i=0; i<num_segments; i++)
+    {
+        segments_.emplace_back(new Segment);
+        segments_.back()->stepper.Resize(dim+dim*dim);
+        segments_.back()->y.resize(dim+dim*dim);
+    }
+    abd_.Resize(num_segments+1, dim);
+}
+
+void MultipleShootingSolver::SetStepsPerSegment(int steps)
+{
+    steps_ = steps;
+}
+
+void MultipleShootingSolver::SetNewtonTolerance(double tol)
+{
+    newton_tol_ = tol;
+}
+
+void MultipleShootingSolver::SetInitialGuess(const Eigen::VectorXd& sol)
+{
+    assert(sol.size() == sol_vec_.size());
+    sol_vec_ = sol;
+}
+
+void MultipleShootingSolver::SetVerbose(bool verbose)
+{
+    verbose_ = verbose;
+}
+
+// state and transition matrix of segment i at its end, starting from s_i and the identity
+void MultipleShootingSolver::Integrate(int i, const Eigen::VectorXd& s)
+{
+    const int d = dim_;
+    Segment& seg = *segments_[i];
+    auto rhs = [this, d](double t, const std::vector<double>& y, std::vector<double>& f)
+    {
+        Eigen::Map<const Eigen::VectorXd> x(y.data(), d);
+        Eigen::Map<Eigen::VectorXd>(f.data(), d) = p_ode_->p_RhsFunc(t, x);
+        Eigen::Map<const Eigen::MatrixXd> Phi(y.data()+d, d, d);
+        Eigen::Map<Eigen::MatrixXd>(f.data()+d, d, d).noalias() = p_ode_->p_RhsGradYFunc(t, x)*Phi;
+    };
+
+    Eigen::Map<Eigen::VectorXd>(seg.y.data(), d) = s.segment(d*i, d);
+    Eigen::Map<Eigen::MatrixXd>(seg.y.data()+d, d, d).setIdentity();
+    double t = mesh_(i);
+    double h = (mesh_(i+1)-mesh_(i))/steps_;
+    for (int k=0; k<steps_; k++)
+    {
+        seg.stepper.Step(rhs, t, h, seg.y);
+        t = mesh_(i) + (k+1)*h;
+    }
+}
+
+double MultipleShootingSolver::Residual(const Eigen::VectorXd& s, Eigen::VectorXd& r)
+{
+    const int d = dim_;
+    const int m = num_segments_;
+    pool_.ParallelFor(0, m, 1, [this, &s](long i, int) { Integrate(static_cast<int>(i), s); });
+
+    r.resize((m+1)*d);
+    for (int i=0; i<m; i++)
+    {
+        r.segment(d*i, d) = s.segment(d*(i+1), d) - Eigen::Map<const Eigen::VectorXd>(segments_[i]->y.data(), d);
+    }
+    r.tail(d) = -p_ode_->p_BcsFunc(s.head(d), s.tail(d));
+    return r.norm();
+}
+
+int MultipleShootingSolver::Solve()
+{
+    const int d = dim_;
+    const int m = num_segments_;
+    Eigen::VectorXd r, r_trial, w, s_trial;
+    double norm = Residual(sol_vec_, r);
+    for (iterations_=0; iterations_<MAX_ITER; iterations_++)
+    {
+        // Jacobian at the current nodes, the segments hold their transition matrices
+        for (int i=0; i<m; i++)
+        {
+            abd_.left(i) = Eigen::Map<const Eigen::MatrixXd>(segments_[i]->y.data()+d, d, d);
+            abd_.right(i) = -Eigen::MatrixXd::Identity(d, d);
+        }
+        abd_.bc_left() = p_ode_->p_BcsGrad1Func(sol_vec_.head(d), sol_vec_.tail(d));
+        abd_.bc_right() = p_ode_->p_BcsGrad2Func(sol_vec_.head(d), sol_vec_.tail(d));
+        if (abd_.Factorize())
+        {
+            if (verbose_)
+            {
+                std::cout << "Singular matching system" << std::endl;
+            }
+            return 1;
+        }
+        abd_.Solve(r, w);
+
+        // a full step below the tolerance is taken even if the residual is
+        // already at the round off
+        const bool converged = w.norm() < newton_tol_;
+        double lambda = 1;
+        double norm_trial = 0;
+        bool reduced = false;
+        for (int k=0; k<=MAX_HALVINGS && !reduced; k++)
+        {
+            s_trial = sol_vec_ + lambda*w;
+            norm_trial = Residual(s_trial, r_trial);
+            reduced = converged || norm_trial < norm;
+            lambda *= 0.5;
+        }
+        if (!reduced)
+        {
+            // no damped step reduced the residual, the iteration has stalled
+            iterations_++;
+            return 1;
+        }
+        sol_vec_.swap(s_trial);
+        r.swap(r_trial);
+        norm = norm_trial;
+
+        if (converged)
+        {
+            iterations_++;
+            return 0;
+        }
+    }
+    return 1;
+}
+
+Eigen::VectorXd MultipleShootingSolver::sol_vec() const
+{
+    return sol_vec_;
+}
+
+Eigen::VectorXd MultipleShootingSolver::mesh() const
+{
+    return mesh_;
+}
+
+int MultipleShootingSolver::iterations() const
+{
+    return iterations_;
+}
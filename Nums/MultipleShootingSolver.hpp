@@ -0,0 +1,83 @@
+#ifndef MULTIPLESHOOTINGSOLVER_H
+#define MULTIPLESHOOTINGSOLVER_H
+
+#include <memory>
+#include <vector>
+#include "Eigen/Dense"
+
+#include "AlmostBlockDiagonalSolver.hpp"
+#include "DifferentialSystem.hpp"
+#include "RungeKuttaStepper.hpp"
+#include "ThreadPool.hpp"
+
+/* Multiple shooting for the two point boundary value problems described by a
+ * DifferentialSystem, an alternative to the finite difference
+ * BoundaryValueProblem for sensitive problems such as orbit transfers.
+ *
+ * [t_min, t_max] is split into equal segments, the unknowns are the states s_i
+ * at the segment starts and s_M at t_max.  Every Newton iteration integrates
+ * each segment from s_i together with its transition matrix Phi_i (RK4 with a
+ * fixed number of steps) on the thread pool, one task per segment, and solves
+ * the matching conditions
+ *   y(t_{i+1}; s_i) - s_{i+1} = 0,   g(s_0, s_M) = 0
+ * whose Jacobian with blocks [Phi_i, -I] is condensed by the
+ * AlmostBlockDiagonalSolver.  The Newton step is halved while it does not
+ * reduce the residual, Newton has converged when the undamped step is below
+ * the tolerance and fails when no halving reduces the residual.
+ */
+class MultipleShootingSolver
+{
+private:
+    // integration workspace of one segment, allocated separately so that
+    // workers do not share cache lines
+    struct Segment
+    {
+        DynamicRungeKutta<ClassicalRK4Tableau> stepper;
+        // state followed by the column major transition matrix
+        std::vector<double> y;
+        char padding[64];
+    };
+
+    DifferentialSystem* p_ode_;
+    ThreadPool& pool_;
+    int num_segments_;
+    int dim_;
+    int steps_ = 100;
+    double newton_tol_ = 1e-8;
+    int iterations_ = 0;
+    bool verbose_ = false;
+
+    Eigen::VectorXd mesh_;
+    Eigen::VectorXd sol_vec_;
+    std::vector<std::unique_ptr<Segment> > segments_;
+    AlmostBlockDiagonalSolver abd_;
+
+    static const int MAX_ITER = 50;
+    static const int MAX_HALVINGS = 10;
+
+    void Integrate(int i, const Eigen::VectorXd& s);
+    // integrates all segments from the node values s and returns the norm of
+    // the Newton right hand side r (minus the matching and boundary residuals)
+    double Residual(const Eigen::VectorXd& s, Eigen::VectorXd& r);
+public:
+    MultipleShootingSolver(DifferentialSystem* p_ode, int num_segments, int dim, ThreadPool& pool);
+
+    void SetStepsPerSegment(int steps);
+    // bound on the norm of the last undamped Newton correction
+    void SetNewtonTolerance(double tol);
+    // node values s_0..s_M one after the other, zero by default
+    void SetInitialGuess(const Eigen::VectorXd& sol);
+    // reports a singular matching system on std::cout, off by default
+    void SetVerbose(bool verbose);
+
+    // returns 0 if Newton converged and 1 if it stalled, did not converge in
+    // MAX_ITER iterations or the matching system was singular
+    int Solve();
+
+    Eigen::VectorXd sol_vec() const;
+    // segment boundaries t_0..t_M belonging to sol_vec()
+    Eigen::VectorXd mesh() const;
+    int iterations() const;
+};
+
+#endif // MULTIPLESHOOTINGSOLVER_H
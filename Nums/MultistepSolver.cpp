@@ -0,0 +1,229 @@
+#include "MultistepSolver.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+MultistepSolver::MultistepSolver(RungeKuttaSolver& system)
+    : system_(system)
+{
+    SetStepSize(10);
+}
+
+void MultistepSolver::InitialConditions()
+{
+    system_.InitialConditions();
+    Restart();
+}
+
+void MultistepSolver::Restart()
+{
+    started_ = false;
+}
+
+long MultistepSolver::rhs_evaluations() const
+{
+    return rhs_evaluations_;
+}
+
+void MultistepSolver::EvaluateRhs(double t, const std::vector<double>& y, std::vector<double>& f)
+{
+    rhs_evaluations_++;
+    system_.RightHandSide(t, y, f);
+}
+
+void MultistepSolver::StartingStep(double t, double h, std::vector<double>& y, int substeps)
+{
+    double hs = h/substeps;
+    for (int i=0; i<substeps; i++)
+    {
+        stepper_.Step([this](double ti, const std::vector<double>& yi, std::vector<double>& fi)
+                      { EvaluateRhs(ti, yi, fi); }, t+i*hs, hs, y);
+    }
+}
+
+bool MultistepSolver::CheckEvents(double t, const std::vector<double>& y, const std::vector<double>& f)
+{
+    if (t <= t_checked_)
+    {
+        return false;
+    }
+    const double t0 = t_checked_;
+    const double h = t - t0;
+    auto hermite = [&](double ti, std::vector<double>& yi)
+    {
+        double theta = (ti - t0)/h;
+        double theta2 = theta*theta;
+        double h00 = (2*theta - 3)*theta2 + 1;
+        double h10 = ((theta - 2)*theta + 1)*theta*h;
+        double h01 = (3 - 2*theta)*theta2;
+        double h11 = (theta - 1)*theta2*h;
+        yi.resize(state_dim_);
+        for (int j=0; j<state_dim_; j++)
+        {
+            yi[j] = h00*y_checked_[j] + h10*f_checked_[j] + h01*y[j] + h11*f[j];
+        }
+    };
+    double t_stop;
+    if (LocateEvents(t0, t, hermite, t_stop))
+    {
+        hermite(t_stop, y_event_);
+        t_event_ = t_stop;
+        return true;
+    }
+    t_checked_ = t;
+    y_checked_ = y;
+    f_checked_ = f;
+    return false;
+}
+
+void MultistepSolver::UpdateState(double dt)
+{
+    terminated_ = false;
+    Eigen::VectorXd x;
+    // the base class version gives the full state, including e.g. transition matrices
+    system_.RungeKuttaSolver::getState(x);
+    std::vector<double> current(x.data(), x.data()+x.size());
+
+    if (!started_ || system_.time() != t_reported_ || current != reported_)
+    {
+        // new history from the current state of the system
+        state_dim_ = static_cast<int>(current.size());
+        stepper_.Resize(state_dim_);
+        y_ = current;
+        t_int_ = system_.time();
+        t_start_ = t_int_;
+        start_states_.clear();
+        Start();
+        started_ = true;
+        if (has_events())
+        {
+            t_checked_ = t_start_;
+            y_checked_ = start_states_[0];
+            f_checked_.resize(state_dim_);
+            f_work_.resize(state_dim_);
+            EvaluateRhs(t_checked_, y_checked_, f_checked_);
+        }
+    }
+
+    double t_target = system_.time() + dt;
+    bool stop = false;
+    if (has_events())
+    {
+        // starting points up to the requested time
+        for (unsigned int j=1; j<start_states_.size() && !stop; j++)
+        {
+            double t = t_start_ + j*mStepSize;
+            if (t > t_checked_ && t <= t_target + 1e-9*mStepSize)
+            {
+                EvaluateRhs(t, start_states_[j], f_work_);
+                stop = CheckEvents(t, start_states_[j], f_work_);
+            }
+        }
+    }
+    // stay on the grid, the last partial step is not taken by the multistep method
+    while (!stop && t_int_ + mStepSize <= t_target + 1e-9*mStepSize)
+    {
+        Step();
+        if (has_events())
+        {
+            stop = CheckEvents(t_int_, y_, derivative());
+        }
+    }
+    if (!stop)
+    {
+        double t_out = t_int_;
+        out_ = y_;
+        if (t_target < t_int_)
+        {
+            // requested time lies inside the starting steps
+            int j = static_cast<int>(floor((t_target - t_start_)/mStepSize));
+            j = std::max(0, std::min(j, static_cast<int>(start_states_.size())-1));
+            t_out = t_start_ + j*mStepSize;
+            out_ = start_states_[j];
+        }
+        if (t_target > t_out)
+        {
+            StartingStep(t_out, t_target - t_out, out_, 1);
+        }
+        if (has_events())
+        {
+            EvaluateRhs(t_target, out_, f_work_);
+            stop = CheckEvents(t_target, out_, f_work_);
+        }
+    }
+    if (stop)
+    {
+        // the history runs past the event, the next update starts from it
+        out_ = y_event_;
+        t_target = t_event_;
+        started_ = false;
+    }
+
+    for (int i=0; i<state_dim_; i++)
+    {
+        x(i) = out_[i];
+    }
+    system_.RungeKuttaSolver::setState(x);
+    system_.SetTime(t_target);
+    t_ = t_target;
+    reported_ = out_;
+    t_reported_ = t_target;
+}
+
+void MultistepSolver::SolveEquation(std::vector<double>)
+{
+    Restart();
+    UpdateState(mFinalTime - mInitialTime);
+}
+
+void MultistepSolver::LagrangeBasis(const std::vector<long double>& nodes,
+                                    std::vector<std::vector<long double> >& basis)
+{
+    const int n = static_cast<int>(nodes.size());
+    basis.assign(n, std::vector<long double>(n, 0.0L));
+    for (int k=0; k<n; k++)
+    {
+        std::vector<long double>& c = basis[k];
+        c[0] = 1.0L;
+        int degree = 0;
+        for (int m=0; m<n; m++)
+        {
+            if (m == k) continue;
+            // multiply by (x - x_m)/(x_k - x_m)
+            long double scale = 1.0L/(nodes[k] - nodes[m]);
+            for (int j=degree+1; j>0; j--)
+            {
+                c[j] = (c[j-1] - nodes[m]*c[j])*scale;
+            }
+            c[0] = -nodes[m]*c[0]*scale;
+            degree++;
+        }
+    }
+}
+
+long double MultistepSolver::PolynomialDerivative(const std::vector<long double>& c, int d, long double x)
+{
+    long double value = 0.0L;
+    for (int m=static_cast<int>(c.size())-1; m>=d; m--)
+    {
+        long double factor = 1.0L;
+        for (int j=0; j<d; j++)
+        {
+            factor *= m-j;
+        }
+        value = value*x + factor*c[m];
+    }
+    return value;
+}
+
+long double MultistepSolver::PolynomialIntegral(const std::vector<long double>& c, long double a, long double b)
+{
+    long double fa = 0.0L;
+    long double fb = 0.0L;
+    for (int m=static_cast<int>(c.size())-1; m>=0; m--)
+    {
+        fa = fa*a + c[m]/(m+1);
+        fb = fb*b + c[m]/(m+1);
+    }
+    return fb*b - fa*a;
+}
@@ -0,0 +1,91 @@
+#ifndef MULTISTEPSOLVER_H
+#define MULTISTEPSOLVER_H
+
+#include <vector>
+
+#include "AbstractOdeSolver.hpp"
+#include "RungeKuttaSolver.hpp"
+#include "RungeKuttaStepper.hpp"
+
+/* Common part of the fixed step multistep integrators.  The dynamics come from
+ * an existing RungeKuttaSolver (SatelliteSolver, GroundTrackingSolver, ...):
+ * its RightHandSide is integrated and after every UpdateState the new state
+ * and time are written back into it, so all of its outputs keep working.
+ *
+ * The integrator runs on its own grid t0 + n*h.  UpdateState(dt) steps along
+ * the grid and reaches the requested time with an RK4 step from the last grid
+ * point.  If the state or time of the system is changed from outside
+ * (maneuver, measurement update) the history is discarded and the method is
+ * started again with RK4 from the new state.
+ *
+ * Events are located on the cubic Hermite interpolant between the points the
+ * solution passes (starting points, grid points and the requested times),
+ * with the derivative the method already has at the grid points.  A terminal
+ * event restarts the method from the state at the event.
+ */
+class MultistepSolver : public AbstractOdeSolver
+{
+private:
+    // state and time handed out by the last UpdateState, used to detect external changes
+    std::vector<double> reported_;
+    double t_reported_ = 0;
+    bool started_ = false;
+    std::vector<double> out_;
+    DynamicRungeKutta<ClassicalRK4Tableau> stepper_;
+    // last point searched for events and the next one, with their derivatives
+    double t_checked_ = 0;
+    std::vector<double> y_checked_;
+    std::vector<double> f_checked_;
+    double t_event_ = 0;
+    std::vector<double> y_event_;
+    std::vector<double> f_work_;
+
+    // searches (t_checked_, t] on the way to y at t with derivative f, true at a
+    // terminal event with the state at the event in y_event_ and its time in t_event_
+    bool CheckEvents(double t, const std::vector<double>& y, const std::vector<double>& f);
+
+protected:
+    RungeKuttaSolver& system_;
+    int state_dim_ = 0;
+    // integrator state y_ at grid time t_int_
+    std::vector<double> y_;
+    double t_int_ = 0;
+    // states on the grid points covered by Start, from the restart time on
+    std::vector<std::vector<double> > start_states_;
+    double t_start_ = 0;
+    long rhs_evaluations_ = 0;
+
+    void EvaluateRhs(double t, const std::vector<double>& y, std::vector<double>& f);
+    // RK4 step of size h from (t, y) using substeps, for starting the methods
+    void StartingStep(double t, double h, std::vector<double>& y, int substeps);
+
+    // monomial coefficients of the Lagrange basis polynomials for the given
+    // nodes, basis[k][m] is the coefficient of x^m in L_k
+    static void LagrangeBasis(const std::vector<long double>& nodes,
+                              std::vector<std::vector<long double> >& basis);
+    // d-th derivative of the polynomial with coefficients c at x
+    static long double PolynomialDerivative(const std::vector<long double>& c, int d, long double x);
+    // integral of the polynomial with coefficients c over [a, b]
+    static long double PolynomialIntegral(const std::vector<long double>& c, long double a, long double b);
+
+    // builds the history from y_ at t_int_, fills start_states_ and may advance y_ and t_int_
+    virtual void Start() = 0;
+    // one step of the method along the grid, updates y_ and t_int_
+    virtual void Step() = 0;
+    // derivative at y_ and t_int_ after Step
+    virtual const std::vector<double>& derivative() const = 0;
+public:
+    explicit MultistepSolver(RungeKuttaSolver& system);
+
+    // implementations of virtual methods from inherited class
+    void InitialConditions();
+    void UpdateState(double dt);
+    void SolveEquation(std::vector<double> yi);
+
+    // discards the history, the next update starts from the current state of the system
+    void Restart();
+
+    long rhs_evaluations() const;
+};
+
+#endif // MULTISTEPSOLVER_H
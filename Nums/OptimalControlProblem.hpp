@@ -0,0 +1,46 @@
+#ifndef OPTIMALCONTROLPROBLEM_H
+#define OPTIMALCONTROLPROBLEM_H
+
+#include "Eigen/Dense"
+
+/* Optimal control problem for DirectCollocation: minimise the Mayer cost
+ *   phi(x(tf), tf)
+ * subject to the autonomous dynamics x' = f(x, u) on [0, tf], the boundary
+ * conditions psi(x(0), x(tf), tf) = 0 and the path constraints g(x, u) <= 0.
+ * All derivatives are analytic.
+ */
+class OptimalControlProblem
+{
+public:
+    virtual ~OptimalControlProblem() {}
+
+    virtual int num_states() const = 0;
+    virtual int num_controls() const = 0;
+    virtual int num_boundary() const = 0;
+    virtual int num_path() const
+    {
+        return 0;
+    }
+
+    virtual void Dynamics(const Eigen::VectorXd& x, const Eigen::VectorXd& u, Eigen::VectorXd& f) = 0;
+    virtual void DynamicsJacobian(const Eigen::VectorXd& x, const Eigen::VectorXd& u,
+                                  Eigen::MatrixXd& f_x, Eigen::MatrixXd& f_u) = 0;
+
+    virtual void Boundary(const Eigen::VectorXd& x0, const Eigen::VectorXd& xf, double tf,
+                          Eigen::VectorXd& psi) = 0;
+    virtual void BoundaryJacobian(const Eigen::VectorXd& x0, const Eigen::VectorXd& xf, double tf,
+                                  Eigen::MatrixXd& psi_x0, Eigen::MatrixXd& psi_xf, Eigen::VectorXd& psi_tf) = 0;
+
+    virtual void Path(const Eigen::VectorXd&, const Eigen::VectorXd&, Eigen::VectorXd&)
+    {
+    }
+    virtual void PathJacobian(const Eigen::VectorXd&, const Eigen::VectorXd&,
+                              Eigen::MatrixXd&, Eigen::MatrixXd&)
+    {
+    }
+
+    virtual double Cost(const Eigen::VectorXd& xf, double tf) = 0;
+    virtual void CostGradient(const Eigen::VectorXd& xf, double tf, Eigen::VectorXd& phi_x, double& phi_tf) = 0;
+};
+
+#endif // OPTIMALCONTROLPROBLEM_H
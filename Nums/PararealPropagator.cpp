@@ -0,0 +1,130 @@
+#include "PararealPropagator.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+PararealPropagator::PararealPropagator(ThreadPool& pool, const Propagator& coarse, const Propagator& fine)
+    : pool_(pool), coarse_(coarse), fine_(fine), slices_(pool.size())
+{
+}
+
+void PararealPropagator::SetSlices(int slices)
+{
+    slices_ = slices;
+}
+
+void PararealPropagator::SetTolerance(double tol)
+{
+    tol_ = tol;
+}
+
+void PararealPropagator::SetMaxIterations(int iterations)
+{
+    max_iterations_ = iterations;
+}
+
+// coarse propagation over slice n into coarse_end_[n]
+void PararealPropagator::Coarse(int n, const Eigen::VectorXd& x)
+{
+    coarse_end_[n] = x;
+    coarse_(times_[n], times_[n+1], coarse_end_[n]);
+    coarse_propagations_++;
+}
+
+int PararealPropagator::Propagate(double t0, double t1, Eigen::VectorXd& x)
+{
+    const int N = std::max(slices_, 1);
+    const int max_iterations = max_iterations_ > 0 ? std::min(max_iterations_, N) : N;
+    times_.resize(N+1);
+    for (int n=0; n<=N; n++)
+    {
+        times_[n] = t0 + (t1 - t0)*n/N;
+    }
+    times_[N] = t1;
+    states_.assign(N+1, x);
+    coarse_end_.assign(N, x);
+    fine_end_.assign(N, x);
+    iterations_ = 0;
+    defect_ = 0;
+
+    // initial guess from the coarse model alone
+    for (int n=0; n<N; n++)
+    {
+        Coarse(n, states_[n]);
+        states_[n+1] = coarse_end_[n];
+    }
+
+    int converged = 0;
+    while (iterations_ < max_iterations)
+    {
+        // slices before the iteration count are exact already
+        const int k = iterations_;
+        pool_.ParallelFor(k, N, 1, [this](long n, int)
+        {
+            fine_end_[n] = states_[n];
+            fine_(times_[n], times_[n+1], fine_end_[n]);
+        });
+        fine_propagations_ += N - k;
+        iterations_++;
+
+        // sequential correction, slice k is now exact
+        Eigen::VectorXd old = states_[k+1];
+        states_[k+1] = fine_end_[k];
+        defect_ = (states_[k+1] - old).lpNorm<Eigen::Infinity>();
+        for (int n=k+1; n<N; n++)
+        {
+            Eigen::VectorXd coarse_old = coarse_end_[n];
+            Coarse(n, states_[n]);
+            old = states_[n+1];
+            states_[n+1] = coarse_end_[n] + fine_end_[n] - coarse_old;
+            double change = (states_[n+1] - old).lpNorm<Eigen::Infinity>();
+            // also takes up a NaN
+            if (!(change <= defect_))
+            {
+                defect_ = change;
+            }
+        }
+        if (!(defect_ < HUGE_VAL))
+        {
+            // the corrections diverged, the coarse model is too far off
+            break;
+        }
+        if (defect_ <= tol_ || iterations_ == N)
+        {
+            converged = 1;
+            break;
+        }
+    }
+    x = states_[N];
+    return converged ? 0 : 1;
+}
+
+int PararealPropagator::iterations() const
+{
+    return iterations_;
+}
+
+double PararealPropagator::defect() const
+{
+    return defect_;
+}
+
+const std::vector<Eigen::VectorXd>& PararealPropagator::states() const
+{
+    return states_;
+}
+
+const std::vector<double>& PararealPropagator::times() const
+{
+    return times_;
+}
+
+long PararealPropagator::fine_propagations() const
+{
+    return fine_propagations_;
+}
+
+long PararealPropagator::coarse_propagations() const
+{
+    return coarse_propagations_;
+}
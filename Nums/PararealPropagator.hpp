@@ -0,0 +1,72 @@
+#ifndef PARAREALPROPAGATOR_H
+#define PARAREALPROPAGATOR_H
+
+#include <functional>
+#include <vector>
+
+#include "Eigen/Dense"
+#include "ThreadPool.hpp"
+
+/* Parareal parallel in time propagation (Lions, Maday and Turinici 2001).
+ * [t0, t1] is cut into N slices.  A cheap coarse propagator G gives a first
+ * guess of the states U_n at the slice boundaries, then each iteration runs
+ * the accurate fine propagator F on all slices at once on the thread pool and
+ * corrects the boundaries in one sequential coarse sweep
+ *   U_{n+1} = G(U_n) + F(U_n^old) - G(U_n^old).
+ * After k iterations the first k slices equal the sequential fine solution, and
+ * a good coarse model converges in a few iterations.  The ideal speedup with
+ * N workers is then about N/k, as long as G costs little against F.
+ *
+ * Both propagators advance x from t0 to t1 in place.  The fine one is called
+ * concurrently from the workers, so it has to build its own solver (or use
+ * one per worker) instead of sharing state.
+ */
+class PararealPropagator
+{
+public:
+    typedef std::function<void(double t0, double t1, Eigen::VectorXd& x)> Propagator;
+
+    PararealPropagator(ThreadPool& pool, const Propagator& coarse, const Propagator& fine);
+
+    // number of time slices, by default one per worker of the pool
+    void SetSlices(int slices);
+    // converged once no boundary state changes by more than tol (max norm)
+    void SetTolerance(double tol);
+    // 0 allows as many iterations as slices, which reproduces the fine solution
+    void SetMaxIterations(int iterations);
+
+    // propagates x from t0 to t1, returns 1 if the tolerance was not met within
+    // the maximum number of iterations (x is then the last iterate) and 0 otherwise
+    int Propagate(double t0, double t1, Eigen::VectorXd& x);
+
+    int iterations() const;
+    // largest change of a boundary state in the last iteration
+    double defect() const;
+    // states at the N+1 slice boundaries and their times
+    const std::vector<Eigen::VectorXd>& states() const;
+    const std::vector<double>& times() const;
+    long fine_propagations() const;
+    long coarse_propagations() const;
+
+private:
+    ThreadPool& pool_;
+    Propagator coarse_;
+    Propagator fine_;
+    int slices_;
+    double tol_ = 1e-6;
+    int max_iterations_ = 0;
+
+    std::vector<double> times_;
+    std::vector<Eigen::VectorXd> states_;
+    // coarse and fine propagations of the previous boundary states
+    std::vector<Eigen::VectorXd> coarse_end_;
+    std::vector<Eigen::VectorXd> fine_end_;
+    int iterations_ = 0;
+    double defect_ = 0;
+    long fine_propagations_ = 0;
+    long coarse_propagations_ = 0;
+
+    void Coarse(int n, const Eigen::VectorXd& x);
+};
+
+#endif // PARAREALPROPAGATOR_H
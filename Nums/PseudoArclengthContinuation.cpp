@@ -0,0 +1,197 @@
+#include "PseudoArclengthContinuation.hpp"
+
+#include <cmath>
+#include <iostream>
+
+PseudoArclengthContinuation::PseudoArclengthContinuation(BoundaryValueProblem* p_bvp, void (*set_parameter)(double))
+    : p_bvp_(p_bvp), p_SetParameter(set_parameter)
+{
+}
+
+void PseudoArclengthContinuation::SetStepSize(double ds, double ds_min, double ds_max)
+{
+    ds_ = ds;
+    ds_min_ = ds_min;
+    ds_max_ = ds_max;
+}
+
+void PseudoArclengthContinuation::SetNewtonTolerance(double tol)
+{
+    newton_tol_ = tol;
+}
+
+int PseudoArclengthContinuation::Start(double lambda, double direction)
+{
+    lambda_ = lambda;
+    p_SetParameter(lambda_);
+    factorizations_ = 0;
+    turning_point_ = false;
+    if (p_bvp_->Newton() || Linearize(true))
+    {
+        return 1;
+    }
+    theta_ = 1.0/p_bvp_->sol_vec_.size();
+
+    // F_y tau_y + F_lambda tau_lambda = 0
+    p_bvp_->abd_.Solve(F_lambda_, b_);
+    tau_y_ = -b_;
+    tau_lambda_ = 1;
+    double norm = direction < 0 ? -sqrt(theta_*tau_y_.squaredNorm() + 1) : sqrt(theta_*tau_y_.squaredNorm() + 1);
+    tau_y_ /= norm;
+    tau_lambda_ /= norm;
+    return 0;
+}
+
+int PseudoArclengthContinuation::Linearize(bool refactor)
+{
+    BoundaryValueProblem& bvp = *p_bvp_;
+    refactor = refactor || !factorized_;
+    Q_.resize(bvp.sol_vec_.size());
+    Q_plus_.resize(bvp.sol_vec_.size());
+
+    // perturbed residual first, the stage corrections of the assembly at
+    // lambda are the ones applied by the bvp
+    double delta = 1e-7*(1+fabs(lambda_));
+    p_SetParameter(lambda_+delta);
+    bvp.Assemble(Q_plus_, false);
+    p_SetParameter(lambda_);
+    bvp.Assemble(Q_, refactor);
+    F_lambda_ = (Q_-Q_plus_)/delta;
+
+    if (refactor)
+    {
+        factorizations_++;
+        factorized_ = bvp.abd_.Factorize() == 0;
+        if (!factorized_)
+        {
+            if (bvp.verbose_)
+            {
+                std::cout << "Singular Newton matrix" << std::endl;
+            }
+            return 1;
+        }
+    }
+    return 0;
+}
+
+int PseudoArclengthContinuation::Correct(const Eigen::VectorXd& y_p, double lambda_p)
+{
+    BoundaryValueProblem& bvp = *p_bvp_;
+    double last_norm = 0;
+    bool refactor = false;
+    for (iterations_=1; iterations_<=MAX_ITER; iterations_++)
+    {
+        bool fresh = refactor || !factorized_;
+        if (Linearize(refactor))
+        {
+            return 1;
+        }
+        bvp.abd_.Solve(Q_, a_);
+        bvp.abd_.Solve(F_lambda_, b_);
+
+        // w = a - b dlambda with the linearised arclength condition
+        double n = theta_*tau_y_.dot(bvp.sol_vec_-y_p) + tau_lambda_*(lambda_-lambda_p);
+        double d_lambda = (-n - theta_*tau_y_.dot(a_))/(tau_lambda_ - theta_*tau_y_.dot(b_));
+        a_ -= d_lambda*b_;
+        double norm = a_.norm() + fabs(d_lambda);
+        if (!std::isfinite(norm) || (iterations_ > 1 && norm > last_norm && fresh))
+        {
+            return 1;
+        }
+        if (iterations_ > 1 && norm > last_norm)
+        {
+            // the old factorization is too far off, retry from here
+            refactor = true;
+            continue;
+        }
+        bvp.Correct(a_);
+        lambda_ += d_lambda;
+        // with the contraction rate the remaining error of the linearly
+        // converging iteration is bounded by rate/(1-rate) times the correction
+        double rate = iterations_ > 1 ? norm/last_norm : 0;
+        if (norm < newton_tol_ || (iterations_ > 1 && rate*norm < (1-rate)*newton_tol_))
+        {
+            return 0;
+        }
+        refactor = rate > 0.03;
+        last_norm = norm;
+    }
+    return 1;
+}
+
+int PseudoArclengthContinuation::Step()
+{
+    BoundaryValueProblem& bvp = *p_bvp_;
+    y_start_ = bvp.sol_vec_;
+    double lambda_start = lambda_;
+    while (true)
+    {
+        Eigen::VectorXd y_p = y_start_ + ds_*tau_y_;
+        double lambda_p = lambda_start + ds_*tau_lambda_;
+        bvp.sol_vec_ = y_p;
+        lambda_ = lambda_p;
+        if (bvp.stages_ > 0)
+        {
+            bvp.InitStages();
+        }
+        if (Correct(y_p, lambda_p) == 0)
+        {
+            break;
+        }
+        factorized_ = false;
+        ds_ *= 0.5;
+        if (ds_ < ds_min_)
+        {
+            bvp.sol_vec_ = y_start_;
+            lambda_ = lambda_start;
+            p_SetParameter(lambda_);
+            return 1;
+        }
+    }
+
+    // tangent (-F_y^-1 F_lambda, 1) from the last corrector iteration,
+    // oriented along the secant so that it keeps its direction through
+    // turning points
+    Eigen::VectorXd tau_y = -b_;
+    double tau_lambda = 1;
+    double norm = sqrt(theta_*tau_y.squaredNorm() + 1);
+    if (theta_*tau_y.dot(bvp.sol_vec_-y_start_) + tau_lambda*(lambda_-lambda_start) < 0)
+    {
+        norm = -norm;
+    }
+    tau_y /= norm;
+    tau_lambda /= norm;
+    turning_point_ = tau_lambda*tau_lambda_ < 0;
+    tau_y_ = tau_y;
+    tau_lambda_ = tau_lambda;
+
+    if (iterations_ <= 4)
+    {
+        ds_ = std::min(1.5*ds_, ds_max_);
+    }
+    else if (iterations_ >= 8)
+    {
+        ds_ = std::max(0.5*ds_, ds_min_);
+    }
+    return 0;
+}
+
+double PseudoArclengthContinuation::parameter() const
+{
+    return lambda_;
+}
+
+bool PseudoArclengthContinuation::turning_point() const
+{
+    return turning_point_;
+}
+
+int PseudoArclengthContinuation::iterations() const
+{
+    return iterations_;
+}
+
+int PseudoArclengthContinuation::factorizations() const
+{
+    return factorizations_;
+}
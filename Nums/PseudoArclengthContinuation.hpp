@@ -0,0 +1,84 @@
+#ifndef PSEUDOARCLENGTHCONTINUATION_H
+#define PSEUDOARCLENGTHCONTINUATION_H
+
+#include "Eigen/Dense"
+#include "BoundaryValueProblem.hpp"
+
+/* Pseudo-arclength continuation of a family F(y, lambda) = 0 of boundary
+ * value problems on the fixed mesh and scheme of a BoundaryValueProblem.  The
+ * parameter reaches the functions of the DifferentialSystem through
+ * set_parameter, which typically sets a file scope variable they read.
+ *
+ * Each step predicts along the unit tangent (tau_y, tau_lambda), from
+ * F_y tau_y + F_lambda tau_lambda = 0 at the last solution and oriented by
+ * the secant, and corrects with Newton's method on F bordered by the
+ * arclength condition
+ *   theta tau_y.(y - y_p) + tau_lambda (lambda - lambda_p) = 0
+ * with theta = 1/size(y), so that step sizes do not depend on the mesh.  The
+ * bordered system takes two solves with the block factorization of F_y
+ * (F_lambda by a forward difference).  That factorization is kept from
+ * earlier iterations and steps while successive corrections shrink by a
+ * factor 30 or more, so along smooth stretches steps mostly cost residual
+ * evaluations.  The step grows by 1.5 after at most 4 iterations and is
+ * halved after 8 or more.  Unlike natural continuation in lambda the
+ * corrector stays regular at turning points, where tau_lambda changes sign.
+ */
+class PseudoArclengthContinuation
+{
+private:
+    BoundaryValueProblem* p_bvp_;
+    void (*p_SetParameter)(double lambda);
+
+    double lambda_ = 0;
+    double ds_ = 0.1;
+    double ds_min_ = 1e-6;
+    double ds_max_ = 1;
+    double newton_tol_ = 1e-8;
+    double theta_ = 1;
+
+    Eigen::VectorXd tau_y_;
+    double tau_lambda_ = 1;
+    bool factorized_ = false;
+    bool turning_point_ = false;
+    int iterations_ = 0;
+    int factorizations_ = 0;
+
+    // workspace
+    Eigen::VectorXd y_start_;
+    Eigen::VectorXd Q_;
+    Eigen::VectorXd Q_plus_;
+    Eigen::VectorXd F_lambda_;
+    Eigen::VectorXd a_;
+    Eigen::VectorXd b_;
+
+    static const int MAX_ITER = 20;
+
+    // Q_ and F_lambda_ at the current solution, the jacobian refactorized if
+    // asked for or there is none, returns 1 if it is singular
+    int Linearize(bool refactor);
+    // Newton on the bordered system from the predicted point, returns 1 if it failed
+    int Correct(const Eigen::VectorXd& y_p, double lambda_p);
+public:
+    PseudoArclengthContinuation(BoundaryValueProblem* p_bvp, void (*set_parameter)(double));
+
+    // initial, smallest and largest arclength step
+    void SetStepSize(double ds, double ds_min, double ds_max);
+    void SetNewtonTolerance(double tol);
+
+    // solves the problem at lambda starting from the current solution of the
+    // bvp and sets up the tangent towards increasing lambda, or decreasing for
+    // a negative direction, returns 1 if Newton failed
+    int Start(double lambda, double direction = 1);
+    // one predictor corrector step along the branch, retried with halved
+    // steps down to the smallest one, returns 1 if none converged
+    int Step();
+
+    double parameter() const;
+    // true if lambda turned back in the last step
+    bool turning_point() const;
+    // Newton iterations of the last step and factorizations since Start
+    int iterations() const;
+    int factorizations() const;
+};
+
+#endif // PSEUDOARCLENGTHCONTINUATION_H
@@ -1,4 +1,5 @@
 #include "Restricted3BodySolver.hpp"
+#include "TaylorTape.hpp"
 
 #include <cassert>
 #include <iostream>
@@ -6,9 +7,7 @@
 #include <math.h>
 #include <vector>
 #include <cmath>
-#include <QApplication>
 
-#include <Python.h>
 
 #define _USE_MATH_DEFINES
 
@@ -50,31 +49,42 @@ void Restricted3BodySolver::InitialConditions()
 
 void Restricted3BodySolver::RightHandSide(double t, const std::vector<double> &y, std::vector<double> &f)
 {
-    double r1 = sqrt((y[0]+pi2*r12)*(y[0]+pi2*r12)+y[1]*y[1]);
-    double r2 = sqrt((y[0]-pi1*r12)*(y[0]-pi1*r12)+y[1]*y[1]);
-    double r1cube = r1*r1*r1;
-    double r2cube = r2*r2*r2;
+    Dynamics(t, y.data(), f.data());
+}
+
+template <class T>
+void Restricted3BodySolver::Dynamics(const T&, const T* y, T* f) const
+{
+    T x1 = y[0]+pi2*r12;
+    T x2 = y[0]-pi1*r12;
+    T r1 = sqrt(x1*x1+y[1]*y[1]);
+    T r2 = sqrt(x2*x2+y[1]*y[1]);
+    T r1cube = r1*r1*r1;
+    T r2cube = r2*r2*r2;
 
     f[0] = y[2];
     f[1] = y[3];
-    f[2] = 2*Omega*y[3]+Omega*Omega*y[0]-mu1*(y[0]+pi2*r12)/r1cube-mu2*(y[0]-pi1*r12)/r2cube;
+    f[2] = 2*Omega*y[3]+Omega*Omega*y[0]-mu1*x1/r1cube-mu2*x2/r2cube;
     f[3] = -2*Omega*y[2]+Omega*Omega*y[1]-mu1*y[1]/r1cube-mu2*y[1]/r2cube;
 }
 
-QVector3D Restricted3BodySolver::position()
+template void Restricted3BodySolver::Dynamics(const double&, const double*, double*) const;
+template void Restricted3BodySolver::Dynamics(const TaylorVariable&, const TaylorVariable*, TaylorVariable*) const;
+
+Vector3D Restricted3BodySolver::position()
 {
-    return QVector3D(state[0], state[1], 0);
+    return Vector3D(state[0], state[1], 0);
 }
-QVector3D Restricted3BodySolver::body1pos()
+Vector3D Restricted3BodySolver::body1pos()
 {
-    return QVector3D(-pi2*r12, 0, 0);
+    return Vector3D(-pi2*r12, 0, 0);
 }
-QVector3D Restricted3BodySolver::body2pos()
+Vector3D Restricted3BodySolver::body2pos()
 {
-    return QVector3D(pi1*r12, 0, 0);
+    return Vector3D(pi1*r12, 0, 0);
 }
 
-QVector3D Restricted3BodySolver::velocity()
+Vector3D Restricted3BodySolver::velocity()
 {
     double U;
     double V;
@@ -84,7 +94,7 @@ QVector3D Restricted3BodySolver::velocity()
     V = 0;
     W = 0;
 
-    return QVector3D(U, V, W);
+    return Vector3D(U, V, W);
 }
 
 double Restricted3BodySolver::eccentricity()
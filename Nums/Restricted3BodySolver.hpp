@@ -1,7 +1,7 @@
 #ifndef RESTRICTED3BODYSOLVER_H
 #define RESTRICTED3BODYSOLVER_H
 
-#include <QVector3D>
+#include "Vector3D.hpp"
 #include "AdaptiveRungeKuttaSolver.hpp"
 #include "RungeKuttaSolver.hpp"
 
@@ -13,12 +13,15 @@ public:
     // define initial conditions and the dynamics equation
     void InitialConditions();
     void RightHandSide(double t, const std::vector<double> &  y, std::vector<double> &  f);
+    // right hand side on any scalar type, double or TaylorVariable for TaylorSolver
+    template <class T>
+    void Dynamics(const T& t, const T* y, T* f) const;
 
     // outputs from the simulation
-    QVector3D position();
-    QVector3D velocity();
-    QVector3D body1pos();
-    QVector3D body2pos();
+    Vector3D position();
+    Vector3D velocity();
+    Vector3D body1pos();
+    Vector3D body2pos();
     double eccentricity();
 };
 
@@ -0,0 +1,495 @@
+#include "RosenbrockSolver.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+// ROS34PW2, Rang and Angermann, BIT 45 (2005)
+const int STAGES = 4;
+const double GAMMA = 0.43586652150845899942;
+const double ALPHA[STAGES][STAGES] = {
+    {0, 0, 0, 0},
+    {0.87173304301691800777, 0, 0, 0},
+    {0.84457060015369423573, -0.11299064236484185560, 0, 0},
+    {0, 0, 1, 0}};
+const double GAMMA_OFF[STAGES][STAGES] = {
+    {0, 0, 0, 0},
+    {-0.87173304301691800777, 0, 0, 0},
+    {-0.90338057013044082332, 0.054180672388095326249, 0, 0},
+    {0.24212380706095346592, -1.2232505839045147297, 0.54526025533510214278, 0}};
+const double B[STAGES] = {0.24212380706095346592, -1.2232505839045147297,
+                          1.5452602553351021428, 0.43586652150845899942};
+const double B_HAT[STAGES] = {0.37810903145819369083, -0.096042292212423178479,
+                              0.5, 0.21793326075422949971};
+
+// step size controller and stiffness test
+const double SAFETY = 0.9;
+const double MIN_FACTOR = 0.2;
+const double MAX_FACTOR = 5.0;
+const double KEEP_FACTOR = 1.2;
+const double STIFF_HLAMBDA = 3.25;
+const int STIFF_STEPS = 15;
+const int NONSTIFF_STEPS = 6;
+
+/* The method in the variables u_i = sum_j gamma_ij k_j (Hairer and Wanner,
+ * Solving ODEs II, IV.7), which need no products with J:
+ *   (I/(gamma h) - J) u_i = f(y + sum_j a_ij u_j) + sum_j c_ij/h u_j
+ *   y1 = y + sum_i m_i u_i
+ * with a = alpha Gamma^-1, c = diag(1/gamma) - Gamma^-1, m = b Gamma^-1.
+ */
+struct TransformedCoefficients
+{
+    double a[STAGES][STAGES];
+    double c[STAGES][STAGES];
+    double m[STAGES];
+    double e[STAGES];
+
+    TransformedCoefficients()
+    {
+        Eigen::Matrix4d alpha, gamma, b, b_hat;
+        for (int i=0; i<STAGES; i++)
+        {
+            for (int j=0; j<STAGES; j++)
+            {
+                alpha(i, j) = ALPHA[i][j];
+                gamma(i, j) = i == j ? GAMMA : GAMMA_OFF[i][j];
+            }
+        }
+        Eigen::Matrix4d gamma_inv = gamma.inverse();
+        Eigen::Matrix4d ta = alpha*gamma_inv;
+        Eigen::Matrix4d tc = -gamma_inv;
+        Eigen::RowVector4d tm = Eigen::RowVector4d(B[0], B[1], B[2], B[3])*gamma_inv;
+        Eigen::RowVector4d tm_hat = Eigen::RowVector4d(B_HAT[0], B_HAT[1], B_HAT[2], B_HAT[3])*gamma_inv;
+        for (int i=0; i<STAGES; i++)
+        {
+            for (int j=0; j<STAGES; j++)
+            {
+                a[i][j] = j < i ? ta(i, j) : 0;
+                c[i][j] = j < i ? tc(i, j) : 0;
+            }
+            m[i] = tm(i);
+            e[i] = tm(i) - tm_hat(i);
+        }
+    }
+};
+
+static const TransformedCoefficients& Coefficients()
+{
+    static const TransformedCoefficients coefficients;
+    return coefficients;
+}
+
+RosenbrockSolver::RosenbrockSolver(RungeKuttaSolver& system)
+    : system_(system)
+{
+    SetStepSize(10);
+}
+
+void RosenbrockSolver::InitialConditions()
+{
+    system_.InitialConditions();
+    started_ = false;
+}
+
+void RosenbrockSolver::SetMode(Mode mode)
+{
+    mode_ = mode;
+    started_ = false;
+}
+
+void RosenbrockSolver::SetTolerances(double atol, double rtol)
+{
+    atol_value_ = atol;
+    rtol_value_ = rtol;
+    atol_.assign(dim_, atol);
+    rtol_.assign(dim_, rtol);
+}
+
+void RosenbrockSolver::SetJacobianReuse(int steps)
+{
+    jacobian_reuse_ = steps;
+}
+
+bool RosenbrockSolver::stiff() const
+{
+    return stiff_;
+}
+
+long RosenbrockSolver::rhs_evaluations() const
+{
+    return rhs_evaluations_;
+}
+
+long RosenbrockSolver::jacobian_evaluations() const
+{
+    return jacobian_evaluations_;
+}
+
+long RosenbrockSolver::decompositions() const
+{
+    return decompositions_;
+}
+
+long RosenbrockSolver::explicit_steps() const
+{
+    return explicit_steps_;
+}
+
+long RosenbrockSolver::implicit_steps() const
+{
+    return implicit_steps_;
+}
+
+long RosenbrockSolver::rejected_steps() const
+{
+    return rejected_steps_;
+}
+
+void RosenbrockSolver::EvaluateRhs(double t, const std::vector<double>& y, std::vector<double>& f)
+{
+    rhs_evaluations_++;
+    system_.RightHandSide(t, y, f);
+}
+
+void RosenbrockSolver::Restart(double t)
+{
+    if (dim_ != static_cast<int>(y_.size()))
+    {
+        dim_ = static_cast<int>(y_.size());
+        f_.assign(dim_, 0.0);
+        y_new_.assign(dim_, 0.0);
+        f_new_.assign(dim_, 0.0);
+        err_.assign(dim_, 0.0);
+        stage_.assign(dim_, 0.0);
+        explicit_.Resize(dim_);
+        for (int i=0; i<STAGES; i++)
+        {
+            u_[i] = Eigen::VectorXd::Zero(dim_);
+        }
+        rhs_ = Eigen::VectorXd::Zero(dim_);
+    }
+    atol_.assign(dim_, atol_value_);
+    rtol_.assign(dim_, rtol_value_);
+    EvaluateRhs(t, y_, f_);
+    h_ = mStepSize;
+    stiff_ = mode_ == IMPLICIT;
+    stiff_count_ = 0;
+    nonstiff_count_ = 0;
+    jacobian_current_ = false;
+    lu_current_ = false;
+    started_ = true;
+}
+
+// analytic Jacobian of the system if it has one, forward differences otherwise
+void RosenbrockSolver::ComputeJacobian(double t)
+{
+    jacobian_evaluations_++;
+    if (system_.Jacobian(t, y_, J_) != 0)
+    {
+        J_.resize(dim_, dim_);
+        stage_ = y_;
+        for (int j=0; j<dim_; j++)
+        {
+            double delta = sqrt(std::numeric_limits<double>::epsilon())*std::max(std::abs(y_[j]), 1e-5);
+            stage_[j] = y_[j] + delta;
+            EvaluateRhs(t, stage_, f_new_);
+            for (int i=0; i<dim_; i++)
+            {
+                J_(i, j) = (f_new_[i] - f_[i])/delta;
+            }
+            stage_[j] = y_[j];
+        }
+    }
+    jacobian_current_ = true;
+    lu_current_ = false;
+    jacobian_age_ = 0;
+
+    // spectral radius by power iteration, the last two factors are averaged
+    // since the dominant eigenvalues often come in complex pairs
+    Eigen::VectorXd v = Eigen::VectorXd::Ones(dim_);
+    double g_prev = 0;
+    double g = 0;
+    for (int k=0; k<12; k++)
+    {
+        Eigen::VectorXd Jv = J_*v;
+        g_prev = g;
+        g = Jv.norm()/v.norm();
+        if (g == 0) break;
+        v = Jv/Jv.norm();
+    }
+    rho_ = sqrt(g*g_prev);
+}
+
+// weighted RMS norm of the local error estimate
+double RosenbrockSolver::ErrorNorm() const
+{
+    double sum = 0;
+    for (int j=0; j<dim_; j++)
+    {
+        double scale = atol_[j] + rtol_[j]*std::max(std::abs(y_[j]), std::abs(y_new_[j]));
+        double ratio = err_[j]/scale;
+        sum += ratio*ratio;
+    }
+    return sqrt(sum/dim_);
+}
+
+bool RosenbrockSolver::ExplicitStep(double t, double h)
+{
+    auto rhs = [this](double ti, const std::vector<double>& yi, std::vector<double>& fi)
+               { EvaluateRhs(ti, yi, fi); };
+    explicit_.k(0) = f_;
+    explicit_.Advance(rhs, t, h, y_, y_new_);
+    explicit_.ErrorEstimate(h, err_);
+    double err = ErrorNorm();
+    // a NaN error is rejected as well
+    if (!(err <= 1))
+    {
+        h_ = h*std::max(MIN_FACTOR, SAFETY*pow(err, -0.2));
+        rejected_steps_++;
+        return false;
+    }
+    const int last = DormandPrince54Tableau::kStages-1;
+    f_new_ = explicit_.k(last);
+
+    // stiffness test: h |k7 - k6|/|y7 - y6| estimates h times the dominant
+    // eigenvalue, the stage of k6 is rebuilt from the stages
+    double num = 0;
+    double den = 0;
+    for (int j=0; j<dim_; j++)
+    {
+        double y6 = y_[j];
+        for (int m=0; m<last-1; m++)
+        {
+            y6 += h*DormandPrince54Tableau::a[last-1][m]*explicit_.k(m)[j];
+        }
+        double dk = explicit_.k(last)[j] - explicit_.k(last-1)[j];
+        double dy = y_new_[j] - y6;
+        num += dk*dk;
+        den += dy*dy;
+    }
+    if (mode_ == AUTOMATIC && den > 0)
+    {
+        if (h*sqrt(num/den) > STIFF_HLAMBDA)
+        {
+            nonstiff_count_ = 0;
+            if (++stiff_count_ == STIFF_STEPS)
+            {
+                stiff_ = true;
+                stiff_count_ = 0;
+                jacobian_current_ = false;
+            }
+        }
+        else if (++nonstiff_count_ == NONSTIFF_STEPS)
+        {
+            stiff_count_ = 0;
+        }
+    }
+
+    double factor = err > 0 ? SAFETY*pow(err, -0.2) : MAX_FACTOR;
+    h_ = h*std::min(MAX_FACTOR, std::max(MIN_FACTOR, factor));
+    explicit_steps_++;
+    return true;
+}
+
+bool RosenbrockSolver::RosenbrockStep(double t, double h)
+{
+    const TransformedCoefficients& co = Coefficients();
+    if (!jacobian_current_)
+    {
+        ComputeJacobian(t);
+    }
+    if (!lu_current_ || h != h_lu_)
+    {
+        Eigen::MatrixXd W = -J_;
+        W.diagonal().array() += 1/(GAMMA*h);
+        lu_.compute(W);
+        h_lu_ = h;
+        lu_current_ = true;
+        decompositions_++;
+    }
+
+    for (int i=0; i<STAGES; i++)
+    {
+        const std::vector<double>* fi = &f_;
+        if (i > 0)
+        {
+            double ci = 0;
+            for (int j=0; j<i; j++)
+            {
+                ci += ALPHA[i][j];
+            }
+            for (int k=0; k<dim_; k++)
+            {
+                double s = y_[k];
+                for (int j=0; j<i; j++)
+                {
+                    s += co.a[i][j]*u_[j](k);
+                }
+                stage_[k] = s;
+            }
+            EvaluateRhs(t + ci*h, stage_, f_new_);
+            fi = &f_new_;
+        }
+        for (int k=0; k<dim_; k++)
+        {
+            double s = (*fi)[k];
+            for (int j=0; j<i; j++)
+            {
+                s += co.c[i][j]/h*u_[j](k);
+            }
+            rhs_(k) = s;
+        }
+        u_[i] = lu_.solve(rhs_);
+    }
+    for (int k=0; k<dim_; k++)
+    {
+        double y = y_[k];
+        double e = 0;
+        for (int i=0; i<STAGES; i++)
+        {
+            y += co.m[i]*u_[i](k);
+            e += co.e[i]*u_[i](k);
+        }
+        y_new_[k] = y;
+        err_[k] = e;
+    }
+
+    double err = ErrorNorm();
+    if (!(err <= 1))
+    {
+        h_ = h*std::max(MIN_FACTOR, SAFETY*pow(err, -1.0/3));
+        rejected_steps_++;
+        // the old Jacobian may be the reason
+        if (jacobian_age_ > 0)
+        {
+            jacobian_current_ = false;
+        }
+        return false;
+    }
+    EvaluateRhs(t + h, y_new_, f_new_);
+    if (++jacobian_age_ >= jacobian_reuse_)
+    {
+        jacobian_current_ = false;
+    }
+
+    double factor = err > 0 ? SAFETY*pow(err, -1.0/3) : MAX_FACTOR;
+    factor = std::min(MAX_FACTOR, std::max(MIN_FACTOR, factor));
+    if (factor >= 1 && factor <= KEEP_FACTOR)
+    {
+        // keeps the decomposition
+        factor = 1;
+    }
+    h_ = h*factor;
+
+    if (mode_ == AUTOMATIC)
+    {
+        // back to the explicit method once it would be stable with this step
+        if (h*rho_ < 0.5*STIFF_HLAMBDA)
+        {
+            if (++nonstiff_count_ == NONSTIFF_STEPS)
+            {
+                stiff_ = false;
+                nonstiff_count_ = 0;
+                stiff_count_ = 0;
+            }
+        }
+        else
+        {
+            nonstiff_count_ = 0;
+        }
+    }
+    implicit_steps_++;
+    return true;
+}
+
+void RosenbrockSolver::UpdateState(double dt)
+{
+    terminated_ = false;
+    failed_ = false;
+    Eigen::VectorXd x;
+    // the base class version gives the full state, including e.g. transition matrices
+    system_.RungeKuttaSolver::getState(x);
+    std::vector<double> current(x.data(), x.data()+x.size());
+    double t = system_.time();
+    if (!started_ || t != t_reported_ || current != reported_)
+    {
+        y_ = current;
+        Restart(t);
+    }
+
+    double t_target = t + dt;
+    while (t_target - t > 1e-12*std::max(1.0, std::abs(t)))
+    {
+        double h_trial = h_;
+        double h = std::min(h_trial, t_target - t);
+        bool accepted = stiff_ ? RosenbrockStep(t, h) : ExplicitStep(t, h);
+        if (!accepted)
+        {
+            if (h_ < 16*std::numeric_limits<double>::epsilon()*std::max(1.0, std::abs(t)))
+            {
+                // no step makes progress, stay at the last accepted one
+                terminated_ = true;
+                failed_ = true;
+                break;
+            }
+            continue;
+        }
+        if (h < h_trial)
+        {
+            // shortened to land on the target, not limited by the error
+            h_ = std::max(h_, h_trial);
+        }
+
+        if (has_events())
+        {
+            // cubic Hermite interpolation between the step ends
+            auto hermite = [&](double ti, std::vector<double>& yi)
+            {
+                double theta = (ti - t)/h;
+                double theta2 = theta*theta;
+                double h00 = (2*theta - 3)*theta2 + 1;
+                double h10 = ((theta - 2)*theta + 1)*theta*h;
+                double h01 = (3 - 2*theta)*theta2;
+                double h11 = (theta - 1)*theta2*h;
+                yi.resize(dim_);
+                for (int j=0; j<dim_; j++)
+                {
+                    yi[j] = h00*y_[j] + h10*f_[j] + h01*y_new_[j] + h11*f_new_[j];
+                }
+            };
+            double t_stop;
+            if (LocateEvents(t, t + h, hermite, t_stop))
+            {
+                std::vector<double> y_event;
+                hermite(t_stop, y_event);
+                y_.swap(y_event);
+                t = t_stop;
+                EvaluateRhs(t, y_, f_);
+                break;
+            }
+        }
+        y_.swap(y_new_);
+        f_.swap(f_new_);
+        t += h;
+    }
+    if (!terminated_)
+    {
+        t = t_target;
+    }
+
+    for (int i=0; i<dim_; i++)
+    {
+        x(i) = y_[i];
+    }
+    system_.RungeKuttaSolver::setState(x);
+    system_.SetTime(t);
+    t_ = t;
+    reported_ = y_;
+    t_reported_ = t;
+}
+
+void RosenbrockSolver::SolveEquation(std::vector<double>)
+{
+    started_ = false;
+    UpdateState(mFinalTime - mInitialTime);
+}
@@ -0,0 +1,118 @@
+#ifndef ROSENBROCKSOLVER_H
+#define ROSENBROCKSOLVER_H
+
+#include <vector>
+#include "Eigen/Dense"
+
+#include "AbstractOdeSolver.hpp"
+#include "RungeKuttaSolver.hpp"
+#include "RungeKuttaStepper.hpp"
+
+/* Variable step integrator for problems that become stiff, e.g. decay through
+ * the exponential atmosphere.  The dynamics come from an existing
+ * RungeKuttaSolver as in MultistepSolver, the state and time are written back
+ * into it after every UpdateState.
+ *
+ * Non-stiff stretches are integrated with Dormand-Prince 5(4).  The stiffness
+ * test of Hairer and Wanner (h times the local Lipschitz estimate from the last
+ * two stages above 3.25 for 15 steps) switches to ROS34PW2 (Rang and
+ * Angermann 2005), a 4 stage L-stable Rosenbrock-W method of order 3 with an
+ * embedded order 2 solution.  Being a W-method it keeps its order with any
+ * Jacobian approximation, so J from RungeKuttaSolver::Jacobian (or from
+ * forward differences if the system has none) and the LU decomposition of
+ * I/(gamma h) - J are reused over many steps: J is refreshed every few steps or
+ * after a rejection, the LU only when h changes, and h is kept when the
+ * controller would change it by less than 20%.  When h times the spectral
+ * radius of J stays small the explicit method takes over again.
+ *
+ * The right hand side is assumed not to depend on t explicitly.  When the
+ * step size falls below 16 eps |t| after rejections (e.g. a NaN error estimate
+ * once the state overflowed) the update stops with failed() at the last
+ * accepted step.
+ */
+class RosenbrockSolver : public AbstractOdeSolver
+{
+public:
+    enum Mode { AUTOMATIC, EXPLICIT, IMPLICIT };
+
+private:
+    RungeKuttaSolver& system_;
+    Mode mode_ = AUTOMATIC;
+    int dim_ = 0;
+
+    // integrator state y_ at the time of the system, f_ = f(t, y_)
+    std::vector<double> y_;
+    std::vector<double> f_;
+    std::vector<double> y_new_;
+    std::vector<double> f_new_;
+    std::vector<double> err_;
+    std::vector<double> stage_;
+    // state and time handed out by the last UpdateState, used to detect external changes
+    std::vector<double> reported_;
+    double t_reported_ = 0;
+    bool started_ = false;
+
+    DynamicRungeKutta<DormandPrince54Tableau> explicit_;
+
+    // Rosenbrock stages and Jacobian
+    Eigen::VectorXd u_[4];
+    Eigen::VectorXd rhs_;
+    Eigen::MatrixXd J_;
+    Eigen::PartialPivLU<Eigen::MatrixXd> lu_;
+    bool jacobian_current_ = false;
+    bool lu_current_ = false;
+    int jacobian_age_ = 0;
+    int jacobian_reuse_ = 20;
+    double h_lu_ = 0;
+    // estimate of the spectral radius of J
+    double rho_ = 0;
+
+    // step size control, the tolerances are expanded to the dimension in Restart
+    double atol_value_ = 1e-9;
+    double rtol_value_ = 1e-9;
+    std::vector<double> atol_;
+    std::vector<double> rtol_;
+    double h_ = 0;
+    bool stiff_ = false;
+    int stiff_count_ = 0;
+    int nonstiff_count_ = 0;
+
+    long rhs_evaluations_ = 0;
+    long jacobian_evaluations_ = 0;
+    long decompositions_ = 0;
+    long explicit_steps_ = 0;
+    long implicit_steps_ = 0;
+    long rejected_steps_ = 0;
+
+    void Restart(double t);
+    void EvaluateRhs(double t, const std::vector<double>& y, std::vector<double>& f);
+    void ComputeJacobian(double t);
+    double ErrorNorm() const;
+    // one attempted step from (t, y_) to y_new_, false if it was rejected;
+    // both update the trial step size h_
+    bool ExplicitStep(double t, double h);
+    bool RosenbrockStep(double t, double h);
+public:
+    explicit RosenbrockSolver(RungeKuttaSolver& system);
+
+    // implementations of virtual methods from inherited class
+    void InitialConditions();
+    void UpdateState(double dt);
+    void SolveEquation(std::vector<double> yi);
+
+    // AUTOMATIC switches on the stiffness test, the others fix the method
+    void SetMode(Mode mode);
+    void SetTolerances(double atol, double rtol);
+    // number of accepted implicit steps a Jacobian is kept
+    void SetJacobianReuse(int steps);
+
+    bool stiff() const;
+    long rhs_evaluations() const;
+    long jacobian_evaluations() const;
+    long decompositions() const;
+    long explicit_steps() const;
+    long implicit_steps() const;
+    long rejected_steps() const;
+};
+
+#endif // ROSENBROCKSOLVER_H
@@ -6,7 +6,16 @@
 void RungeKuttaSolver::SetStateDimension(int state_dim)
 {
     state_dim_ = state_dim;
-    state.reserve(state_dim);
+    state.resize(state_dim);
+    stepper_.Resize(state_dim);
+    y_prev_.assign(state_dim, 0.0);
+    f_prev_.assign(state_dim, 0.0);
+    f_next_.assign(state_dim, 0.0);
+}
+
+int RungeKuttaSolver::state_dimension() const
+{
+    return state_dim_;
 }
 
 void RungeKuttaSolver::SolveEquation(std::vector<double> yi)
@@ -26,15 +35,75 @@ void RungeKuttaSolver::SolveEquation(std::vector<double> yi)
 
 void RungeKuttaSolver::UpdateState(double dt)
 {
+    terminated_ = false;
+    if (has_events())
+    {
+        UpdateStateWithEvents(dt);
+        return;
+    }
     double total_d = 0;
-    while (total_d < dt)
+    // the tolerance keeps the rounding of the summed steps from adding a step
+    while (total_d < dt - 1e-9*mStepSize)
     {
-        RKIteration(t_, state);
+        RKIteration(t_ + total_d, state);
         total_d += mStepSize;
     }
     t_ = t_ + total_d;
 }
 
+// same steps as UpdateState, the derivative at the end of a step is kept as the
+// first stage of the next one and together they give a cubic Hermite interpolant
+void RungeKuttaSolver::UpdateStateWithEvents(double dt)
+{
+    auto rhs = [this](double t, const std::vector<double>& y, std::vector<double>& f)
+               { RightHandSide(t, y, f); };
+    double t0 = t_;
+    double h = mStepSize;
+    RightHandSide(t0, state, f_next_);
+    auto hermite = [&](double t, std::vector<double>& y)
+    {
+        double theta = (t - t0)/h;
+        double theta2 = theta*theta;
+        double h00 = (2*theta - 3)*theta2 + 1;
+        double h10 = ((theta - 2)*theta + 1)*theta*h;
+        double h01 = (3 - 2*theta)*theta2;
+        double h11 = (theta - 1)*theta2*h;
+        y.resize(state_dim_);
+        for (int j=0; j<state_dim_; j++)
+        {
+            y[j] = h00*y_prev_[j] + h10*f_prev_[j] + h01*state[j] + h11*f_next_[j];
+        }
+    };
+
+    double total_d = 0;
+    while (total_d < dt - 1e-9*mStepSize)
+    {
+        t0 = t_ + total_d;
+        y_prev_ = state;
+        f_prev_.swap(f_next_);
+        stepper_.k(0) = f_prev_;
+        stepper_.Advance(rhs, t0, h, y_prev_, state);
+        RightHandSide(t0 + h, state, f_next_);
+        total_d += h;
+
+        double t_stop;
+        if (LocateEvents(t0, t0 + h, hermite, t_stop))
+        {
+            std::vector<double> y_event;
+            hermite(t_stop, y_event);
+            state.swap(y_event);
+            t_ = t_stop;
+            return;
+        }
+    }
+    t_ = t_ + total_d;
+}
+
+int RungeKuttaSolver::Jacobian(double, const std::vector<double>&, Eigen::MatrixXd&)
+{
+    return 1;
+}
+
 void RungeKuttaSolver::getState(Eigen::VectorXd& st)
 {
     st = Eigen::VectorXd(state_dim_);
@@ -54,45 +123,6 @@ void RungeKuttaSolver::setState(const Eigen::VectorXd& st)
 
 void RungeKuttaSolver::RKIteration(double ti, std::vector<double>& yi)
 {
-    std::vector<double> k1(state_dim_);
-    std::vector<double> k2(state_dim_);
-    std::vector<double> k3(state_dim_);
-    std::vector<double> k4(state_dim_);
-    std::vector<double> f1(state_dim_);
-    std::vector<double> f2(state_dim_);
-    std::vector<double> f3(state_dim_);
-    std::vector<double> f4(state_dim_);
-    std::vector<double> int2(state_dim_);
-    std::vector<double> int3(state_dim_);
-    std::vector<double> int4(state_dim_);
-
-    RightHandSide(ti, yi, f1);
-    for (int j=0; j < state_dim_; j++)
-    {
-        k1[j] = mStepSize*f1[j];
-        int2[j] = yi[j] + 0.5 * k1[j];
-    }
-    RightHandSide(ti+0.5*mStepSize, int2, f2);
-    for (int j=0; j < state_dim_; j++)
-    {
-        k2[j] = mStepSize*f2[j];
-        int3[j] = yi[j] + 0.5 * k2[j];
-    }
-    RightHandSide(ti+0.5*mStepSize, int3, f3);
-    for (int j=0; j < state_dim_; j++)
-    {
-        k3[j] = mStepSize*f3[j];
-        int4[j] = yi[j]+k3[j];
-    }
-
-    RightHandSide(ti+mStepSize, int4, f4);
-    for (int j=0; j < state_dim_; j++)
-    {
-        k4[j] = mStepSize*f4[j];
-        yi[j] = yi[j] + (1.0/6.0)*(k1[j] + 2*k2[j] + 2*k3[j] + k4[j]);
-    }
-
+    stepper_.Step([this](double t, const std::vector<double>& y, std::vector<double>& f)
+                  { RightHandSide(t, y, f); }, ti, mStepSize, yi);
 }
-
-
-
@@ -2,16 +2,25 @@
 #define RUNGEKUTTASOLVER
 
 #include "AbstractOdeSolver.hpp"
-#include <QVector3D>
+#include "RungeKuttaStepper.hpp"
+#include "Vector3D.hpp"
 #include "Eigen/Dense"
 
 class RungeKuttaSolver: public AbstractOdeSolver
 {
 private:
     int state_dim_;
+    // classical RK4 stepper, stage workspace is allocated once in SetStateDimension
+    DynamicRungeKutta<ClassicalRK4Tableau> stepper_;
+    // step ends for the cubic Hermite interpolation used by the events
+    std::vector<double> y_prev_;
+    std::vector<double> f_prev_;
+    std::vector<double> f_next_;
+
+    void UpdateStateWithEvents(double dt);
 protected:
     std::vector<double> state;
-    std::vector<QVector3D> results;
+    std::vector<Vector3D> results;
 public:
     // implementations of virtual methods from inherited class
     void UpdateState(double dt);
@@ -20,6 +29,7 @@ public:
     // single RK iteration
     void RKIteration(double ti, std::vector<double> &yi);
     void SetStateDimension(int state_dim);
+    int state_dimension() const;
 
     void getState(Eigen::VectorXd& st);
     void setState(const Eigen::VectorXd& st);
@@ -27,6 +37,9 @@ public:
     // virtual methods
     virtual void InitialConditions() = 0;
     virtual void RightHandSide(double t, const std::vector<double> &  y, std::vector<double> &  f) = 0;
+    // Jacobian df/dy of RightHandSide for the implicit integrators, returns 1 if
+    // the system has none and it has to be approximated by differences
+    virtual int Jacobian(double t, const std::vector<double>& y, Eigen::MatrixXd& J);
 };
 
 #endif
@@ -0,0 +1,135 @@
+#ifndef RUNGEKUTTASTEPPER_H
+#define RUNGEKUTTASTEPPER_H
+
+#include <array>
+#include <cassert>
+#include <vector>
+
+#include "RungeKuttaTableau.hpp"
+
+/* Explicit Runge-Kutta stepper for a given Butcher tableau.  The stage
+ * derivatives and the intermediate state are owned by the stepper and reused
+ * between steps, so stepping does not allocate.
+ *
+ * Vector is either std::array<double, N> when the state dimension is known at
+ * compile time, or std::vector<double>, in which case Resize must be called once
+ * before stepping.  The right hand side is any callable rhs(t, y, f) taking the
+ * same vector type.
+ */
+template <class Vector, class Tableau>
+class RungeKuttaStepper
+{
+public:
+    static constexpr int kStages = Tableau::kStages;
+
+    void Resize(int dim)
+    {
+        for (int s = 0; s < kStages; s++)
+        {
+            ResizeVector(k_[s], dim);
+        }
+        ResizeVector(stage_, dim);
+    }
+
+    int dimension() const
+    {
+        return static_cast<int>(stage_.size());
+    }
+
+    // advances y in place by one step of size h
+    template <class Rhs>
+    void Step(Rhs&& rhs, double t, double h, Vector& y)
+    {
+        rhs(t, y, k_[0]);
+        Advance(rhs, t, h, y, y);
+    }
+
+    // evaluates the remaining stages assuming k(0) already holds f(t, y) and writes
+    // the propagated state to y_new, which may alias y
+    template <class Rhs>
+    void Advance(Rhs&& rhs, double t, double h, const Vector& y, Vector& y_new)
+    {
+        const int n = dimension();
+        for (int s = 1; s < kStages; s++)
+        {
+            for (int j = 0; j < n; j++)
+            {
+                stage_[j] = y[j];
+            }
+            for (int m = 0; m < s; m++)
+            {
+                const double ha = h*Tableau::a[s][m];
+                if (ha == 0.0) continue;
+                const Vector& km = k_[m];
+                for (int j = 0; j < n; j++)
+                {
+                    stage_[j] += ha*km[j];
+                }
+            }
+            rhs(t + Tableau::c[s]*h, stage_, k_[s]);
+        }
+        for (int j = 0; j < n; j++)
+        {
+            y_new[j] = y[j];
+        }
+        for (int m = 0; m < kStages; m++)
+        {
+            const double hb = h*Tableau::b[m];
+            if (hb == 0.0) continue;
+            const Vector& km = k_[m];
+            for (int j = 0; j < n; j++)
+            {
+                y_new[j] += hb*km[j];
+            }
+        }
+    }
+
+    // local error estimate h*sum(e_i*k_i) of the last step, only for embedded pairs
+    void ErrorEstimate(double h, Vector& err) const
+    {
+        const int n = dimension();
+        for (int j = 0; j < n; j++)
+        {
+            err[j] = 0.0;
+        }
+        for (int m = 0; m < kStages; m++)
+        {
+            const double he = h*Tableau::e[m];
+            if (he == 0.0) continue;
+            const Vector& km = k_[m];
+            for (int j = 0; j < n; j++)
+            {
+                err[j] += he*km[j];
+            }
+        }
+    }
+
+    // stage derivatives of the last step
+    Vector& k(int s) { return k_[s]; }
+    const Vector& k(int s) const { return k_[s]; }
+
+private:
+    static void ResizeVector(std::vector<double>& v, int dim)
+    {
+        v.assign(dim, 0.0);
+    }
+    template <std::size_t N>
+    static void ResizeVector(std::array<double, N>& v, int dim)
+    {
+        assert(dim == static_cast<int>(N));
+        v.fill(0.0);
+    }
+
+    Vector k_[kStages];
+    Vector stage_;
+};
+
+// stepper with the state dimension fixed at compile time, workspace lives inside the object
+template <int N, class Tableau = ClassicalRK4Tableau>
+using FixedRungeKutta = RungeKuttaStepper<std::array<double, N>, Tableau>;
+
+// dynamic size fallback, workspace is allocated once by Resize
+template <class Tableau = ClassicalRK4Tableau>
+using DynamicRungeKutta = RungeKuttaStepper<std::vector<double>, Tableau>;
+
+#endif // RUNGEKUTTASTEPPER_H
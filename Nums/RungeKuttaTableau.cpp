@@ -0,0 +1,12 @@
+#include "RungeKuttaTableau.hpp"
+
+// out of class definitions of the static tableau arrays
+constexpr double ClassicalRK4Tableau::c[];
+constexpr double ClassicalRK4Tableau::a[][ClassicalRK4Tableau::kStages];
+constexpr double ClassicalRK4Tableau::b[];
+
+constexpr double DormandPrince54Tableau::c[];
+constexpr double DormandPrince54Tableau::a[][DormandPrince54Tableau::kStages];
+constexpr double DormandPrince54Tableau::b[];
+constexpr double DormandPrince54Tableau::e[];
+constexpr double DormandPrince54Tableau::d[];
@@ -0,0 +1,136 @@
+#include "SatelliteEnsemble.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+// same model constants as SatelliteSolver
+const double R_e = 6378.1363;
+const double r_0 = 7.0e2+R_e;
+const double H = 88.667;
+const double A = 3e-6;
+const double rho_0 = 3.614e-4;
+const double omega_E = 2*M_PI/86164;
+
+void SatelliteEnsemble::Resize(int members)
+{
+    members_ = members;
+    y_.assign(kStateDim*members, 0.0);
+    mu_.assign(members, 0.0);
+    J2_.assign(members, 0.0);
+    C_D_.assign(members, 0.0);
+    stepper_.Resize(kStateDim*members);
+}
+
+int SatelliteEnsemble::size() const
+{
+    return members_;
+}
+
+void SatelliteEnsemble::SetMember(int i, const Eigen::VectorXd& x)
+{
+    assert(i >= 0 && i < members_ && x.size() == kStateDim+3);
+    for (int c=0; c<kStateDim; c++)
+    {
+        y_[c*members_+i] = x(c);
+    }
+    mu_[i] = x(6);
+    J2_[i] = x(7);
+    C_D_[i] = x(8);
+}
+
+void SatelliteEnsemble::GetMember(int i, Eigen::VectorXd& x) const
+{
+    assert(i >= 0 && i < members_);
+    x = Eigen::VectorXd(kStateDim+3);
+    for (int c=0; c<kStateDim; c++)
+    {
+        x(c) = y_[c*members_+i];
+    }
+    x(6) = mu_[i];
+    x(7) = J2_[i];
+    x(8) = C_D_[i];
+}
+
+void SatelliteEnsemble::SetStepSize(double h)
+{
+    h_ = h;
+}
+
+void SatelliteEnsemble::SetTime(double t)
+{
+    t_ = t;
+}
+
+double SatelliteEnsemble::time() const
+{
+    return t_;
+}
+
+const double* SatelliteEnsemble::component(int c) const
+{
+    return y_.data()+c*members_;
+}
+
+double* SatelliteEnsemble::component(int c)
+{
+    return y_.data()+c*members_;
+}
+
+void SatelliteEnsemble::UpdateState(double dt)
+{
+    double t_target = t_ + dt;
+    auto rhs = [this](double, const std::vector<double>& y, std::vector<double>& f)
+               { RightHandSide(y, f); };
+    while (t_ < t_target)
+    {
+        double h = std::min(h_, t_target - t_);
+        stepper_.Step(rhs, t_, h, y_);
+        t_ = t_ + h;
+    }
+    t_ = t_target;
+}
+
+// accelerations of SatelliteSolver::RightHandSide for n members, every
+// component is its own contiguous array and none of them alias, which lets the
+// compiler vectorise the loop without runtime overlap checks
+static void EnsembleAccelerations(int n, const double* __restrict x, const double* __restrict y,
+                                  const double* __restrict z, const double* __restrict u,
+                                  const double* __restrict v, const double* __restrict w,
+                                  const double* __restrict mu, const double* __restrict J2,
+                                  const double* __restrict C_D, double* __restrict ax,
+                                  double* __restrict ay, double* __restrict az)
+{
+    for (int i=0; i<n; i++)
+    {
+        double r2 = x[i]*x[i] + y[i]*y[i] + z[i]*z[i];
+        double r = sqrt(r2);
+        double inv_r3 = 1.0/(r2*r);
+        double inv_r5 = inv_r3/r2;
+        double inv_r7 = inv_r5/r2;
+        double rho = rho_0*exp(-(r-r_0)/H);
+
+        double uo = u[i] + omega_E*v[i];
+        double vo = v[i] - omega_E*u[i];
+        double v_rel = sqrt(uo*uo + vo*vo + w[i]*w[i]);
+        double drag = -0.5*rho*C_D[i]*A*v_rel/970;
+
+        double P_G = mu[i]*J2[i]*R_e*R_e;
+        double zz = 7.5*z[i]*z[i]*inv_r7;
+
+        ax[i] = -mu[i]*x[i]*inv_r3 - P_G*x[i]*(1.5*inv_r5 - zz) + drag*uo;
+        ay[i] = -mu[i]*y[i]*inv_r3 - P_G*y[i]*(1.5*inv_r5 - zz) + drag*vo;
+        az[i] = -mu[i]*z[i]*inv_r3 - P_G*z[i]*(4.5*inv_r5 - zz) + drag*w[i];
+    }
+}
+
+void SatelliteEnsemble::RightHandSide(const std::vector<double>& y, std::vector<double>& f) const
+{
+    const int n = members_;
+    const double* p = y.data();
+    // position derivatives are the velocities
+    std::copy(p+3*n, p+6*n, f.begin());
+    EnsembleAccelerations(n, p, p+n, p+2*n, p+3*n, p+4*n, p+5*n,
+                          mu_.data(), J2_.data(), C_D_.data(),
+                          f.data()+3*n, f.data()+4*n, f.data()+5*n);
+}
@@ -0,0 +1,62 @@
+#ifndef SATELLITEENSEMBLE_H
+#define SATELLITEENSEMBLE_H
+
+#include <vector>
+#include "Eigen/Dense"
+
+#include "RungeKuttaStepper.hpp"
+
+/* Propagates many copies of the SatelliteSolver dynamics (point mass, J2 and
+ * exponential atmosphere drag) at once, e.g. for Monte Carlo dispersions.
+ * The ensemble is stored as a structure of arrays: each of the six state
+ * components is one contiguous array over all members, followed by the
+ * per member parameters mu, J2 and C_D.  The right hand side is a single loop
+ * over the members without branches or virtual calls, which the compiler
+ * vectorises; build with CONFIG+=native_simd to use AVX2/AVX-512 where available
+ * (the exp of the density only vectorises with -ffast-math and glibc).
+ *
+ * Members are set and read with the same 9 component layout as SatelliteSolver,
+ * [x, y, z, u, v, w, mu, J2, C_D].
+ */
+class SatelliteEnsemble
+{
+public:
+    static const int kStateDim = 6;
+
+    // number of members, all members are reset to zero
+    void Resize(int members);
+    int size() const;
+
+    void SetMember(int i, const Eigen::VectorXd& x);
+    void GetMember(int i, Eigen::VectorXd& x) const;
+
+    // fixed RK4 step size, the last step of an update is shortened to land on t + dt
+    void SetStepSize(double h);
+    void SetTime(double t);
+    double time() const;
+
+    // advances all members by dt
+    void UpdateState(double dt);
+
+    // contiguous array of state component c (0..5) over all members
+    const double* component(int c) const;
+    double* component(int c);
+
+private:
+    int members_ = 0;
+    double h_ = 10;
+    double t_ = 0;
+
+    // state components, component c of member i at y_[c*members_+i]
+    std::vector<double> y_;
+    std::vector<double> mu_;
+    std::vector<double> J2_;
+    std::vector<double> C_D_;
+
+    // RK4 over the whole ensemble as one vector of length 6*members_
+    DynamicRungeKutta<ClassicalRK4Tableau> stepper_;
+
+    void RightHandSide(const std::vector<double>& y, std::vector<double>& f) const;
+};
+
+#endif // SATELLITEENSEMBLE_H
@@ -4,9 +4,9 @@
 #include <math.h>
 #include <vector>
 #include <cmath>
-#include <QApplication>
 
 #include "Nums/SatelliteSolver.hpp"
+#include "Nums/TaylorTape.hpp"
 
 const double h = 0.01;
 const double G = 6.67259e-20;
@@ -42,34 +42,98 @@ void SatelliteSolver::InitialConditions(Eigen::VectorXd& x, double dt)
 
 void SatelliteSolver::RightHandSide(double t, const std::vector<double> &y, std::vector<double> &f)
 {
-    Eigen::Vector3d pos, vel;
-    double r = sqrt(y[0]*y[0] + y[1]*y[1] + y[2]*y[2]);
+    Dynamics(t, y.data(), f.data());
+}
+
+template <class T>
+void SatelliteSolver::Dynamics(const T&, const T* y, T* f) const
+{
+    T r2 = y[0]*y[0] + y[1]*y[1] + y[2]*y[2];
+    T r = sqrt(r2);
+    T r3 = r2*r;
+    T r5 = r3*r2;
+    T r7 = r5*r2;
+    T rho = rho_0*exp(-(r-r_0)/H);
+    T mu = y[6];
+    T J2 = y[7];
+    T C_D = y[8];
+
+    // velocity relative to the atmosphere
+    T u = y[3] + omega_E*y[4];
+    T v = y[4] - omega_E*y[3];
+    T w = y[5];
+    T v_rel = sqrt(u*u + v*v + w*w);
+
+    T P_G = mu*J2*R_e*R_e;
+    T g = 1.5/r5 - 7.5*y[2]*y[2]/r7;
+    T D = 0.5*rho*C_D*A*v_rel/970;
+
+    f[0] = y[3];
+    f[1] = y[4];
+    f[2] = y[5];
+    f[3] = -mu*y[0]/r3 - P_G*y[0]*g - D*u;
+    f[4] = -mu*y[1]/r3 - P_G*y[1]*g - D*v;
+    f[5] = -mu*y[2]/r3 - P_G*y[2]*(g + 3/r5) - D*w;
+    f[6] = 0;
+    f[7] = 0;
+    f[8] = 0;
+}
+
+template void SatelliteSolver::Dynamics(const double&, const double*, double*) const;
+template void SatelliteSolver::Dynamics(const TaylorVariable&, const TaylorVariable*, TaylorVariable*) const;
+
+int SatelliteSolver::Jacobian(double, const std::vector<double>& y, Eigen::MatrixXd& J)
+{
+    double r2 = y[0]*y[0] + y[1]*y[1] + y[2]*y[2];
+    double r = sqrt(r2);
+    double r3 = r2*r;
+    double r5 = r3*r2;
+    double r7 = r5*r2;
+    double r9 = r7*r2;
     double rho = rho_0*exp(-(r-r_0)/H);
     double mu = y[6];
     double J2 = y[7];
     double C_D = y[8];
+    double z = y[2];
 
-    pos << y[0], y[1], y[2];
-    vel << y[3], y[4], y[5];
-
-    double v_rel = sqrt((vel(0)+omega_E*vel(1))*(vel(0)+omega_E*vel(1))
-                        +(vel(1)-omega_E*vel(0))*(vel(1)-omega_E*vel(0))+vel(2)*vel(2));
-
-    f[0] = vel(0);
-    f[1] = vel(1);
-    f[2] = vel(2);
-    f[3] = -mu*pos(0)/(r*r*r) - mu*J2*R_e*R_e*pos(0)*(1.5/(pow(r,5))-7.5*pos(2)*pos(2)/pow(r,7))
-            -0.5*rho*C_D*A*v_rel*(vel(0) + omega_E*vel(1))/970;
-    f[4] = -mu*pos(1)/(r*r*r) - mu*J2*R_e*R_e*pos(1)*(1.5/(pow(r,5))-7.5*pos(2)*pos(2)/pow(r,7))
-            -0.5*rho*C_D*A*v_rel*(vel(1) - omega_E*vel(0))/970;
-    f[5] = -mu*pos(2)/(r*r*r) - mu*J2*R_e*R_e*pos(2)*(4.5/(pow(r,5))-7.5*pos(2)*pos(2)/pow(r,7))
-            -0.5*rho*C_D*A*v_rel*vel(2)/970;
-    f[6] = 0;
-    f[7] = 0;
-    f[8] = 0;
+    // velocity relative to the atmosphere as used by RightHandSide, w = M*vel
+    Eigen::Matrix3d M;
+    M << 1, omega_E, 0,
+         -omega_E, 1, 0,
+         0, 0, 1;
+    Eigen::Vector3d pos(y[0], y[1], y[2]);
+    Eigen::Vector3d w = M*Eigen::Vector3d(y[3], y[4], y[5]);
+    double v_rel = w.norm();
+    double k = 0.5*C_D*A/970;
+    const double c[3] = {1.5, 1.5, 4.5};
+
+    J = Eigen::MatrixXd::Zero(9, 9);
+    J.block<3, 3>(0, 3).setIdentity();
+
+    // point mass, J2 and the density gradient of the drag
+    Eigen::Matrix3d dadp = -mu*(Eigen::Matrix3d::Identity()/r3 - 3*pos*pos.transpose()/r5);
+    double P_G = mu*J2*R_e*R_e;
+    for (int i=0; i<3; i++)
+    {
+        double g = c[i]/r5 - 7.5*z*z/r7;
+        for (int j=0; j<3; j++)
+        {
+            double dg = (-5*c[i]/r7 + 52.5*z*z/r9)*pos(j);
+            if (j == 2) dg -= 15*z/r7;
+            dadp(i, j) -= P_G*((i == j ? g : 0) + pos(i)*dg);
+        }
+        J(3+i, 6) = -pos(i)/r3 - J2*R_e*R_e*pos(i)*g;
+        J(3+i, 7) = -mu*R_e*R_e*pos(i)*g;
+        J(3+i, 8) = -0.5*rho*A*v_rel*w(i)/970;
+    }
+    dadp += (k*rho*v_rel/(H*r))*w*pos.transpose();
+    J.block<3, 3>(3, 0) = dadp;
+    // drag, d(v_rel w)/dw = v_rel I + w w^T/v_rel
+    J.block<3, 3>(3, 3) = -k*rho*(v_rel*Eigen::Matrix3d::Identity() + w*w.transpose()/v_rel)*M;
+    return 0;
 }
 
-QVector3D SatelliteSolver::position()
+Vector3D SatelliteSolver::position()
 {
     double XG;
     double YG;
@@ -79,10 +143,10 @@ QVector3D SatelliteSolver::position()
     YG = state[1];
     ZG = state[2];
 
-    return QVector3D(XG, YG, ZG);
+    return Vector3D(XG, YG, ZG);
 }
 
-QVector3D SatelliteSolver::velocity()
+Vector3D SatelliteSolver::velocity()
 {
     double XG;
     double YG;
@@ -92,5 +156,5 @@ QVector3D SatelliteSolver::velocity()
     YG = state[4];
     ZG = state[5];
 
-    return QVector3D(XG, YG, ZG);
+    return Vector3D(XG, YG, ZG);
 }
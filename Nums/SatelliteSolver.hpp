@@ -1,12 +1,10 @@
 #ifndef SATELLITESOLVER_H
 #define SATELLITESOLVER_H
 
-#include "Common/Output.hpp"
 #include "Orbital/Omt.hpp"
 #include "Eigen/Dense"
 
-#include <QVector3D>
-#include <QtCharts>
+#include "Vector3D.hpp"
 
 #include "RungeKuttaSolver.hpp"
 
@@ -21,9 +19,13 @@ public:
     void InitialConditions();
     void InitialConditions(Eigen::VectorXd& x, double dt);
     void RightHandSide(double t, const std::vector<double> &  y, std::vector<double> &  f);
+    // right hand side on any scalar type, double or TaylorVariable for TaylorSolver
+    template <class T>
+    void Dynamics(const T& t, const T* y, T* f) const;
+    int Jacobian(double t, const std::vector<double>& y, Eigen::MatrixXd& J);
     // outputs from the simulation
-    QVector3D position();
-    QVector3D velocity();
+    Vector3D position();
+    Vector3D velocity();
 
     double eccentricity();
 };
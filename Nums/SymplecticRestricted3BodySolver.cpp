@@ -0,0 +1,78 @@
+#include "SymplecticRestricted3BodySolver.hpp"
+
+#include <cmath>
+
+const double G = 6.67259e-20;
+const double m1 = 5.9742e24;
+const double m2 = 7.348e22;
+
+const double h = 1;
+
+const double mu1 = G*m1;
+const double mu2 = G*m2;
+const double pi1 = m1/(m1+m2);
+const double pi2 = m2/(m1+m2);
+
+const double r12 = 384400;
+
+const double Omega = sqrt(G*(m1+m2)/(r12*r12*r12));
+
+void SymplecticRestricted3BodySolver::InitialConditions()
+{
+    SetDimension(2);
+    SetFrameRotation(Omega);
+    SetMethod(YOSHIDA4);
+    SetStepSize(h);
+
+    double phi = -90*(M_PI/180);
+    double gamma = 20*(M_PI/180);
+    double vbo = 10.9148;
+
+    state[0] = (6378+200)*cos(phi)-pi2*r12;
+    state[1] = (6378+200)*sin(phi);
+    state[2] = vbo*cos(phi+M_PI/2-gamma);
+    state[3] = vbo*sin(phi+M_PI/2-gamma);
+
+    SetInitialValue(state);
+    SetTimeInterval(0, 400);
+    t_ = 0;
+}
+
+void SymplecticRestricted3BodySolver::Acceleration(double, const std::vector<double> &y, std::vector<double> &a)
+{
+    double r1 = sqrt((y[0]+pi2*r12)*(y[0]+pi2*r12)+y[1]*y[1]);
+    double r2 = sqrt((y[0]-pi1*r12)*(y[0]-pi1*r12)+y[1]*y[1]);
+    double r1cube = r1*r1*r1;
+    double r2cube = r2*r2*r2;
+
+    a[0] = Omega*Omega*y[0]-mu1*(y[0]+pi2*r12)/r1cube-mu2*(y[0]-pi1*r12)/r2cube;
+    a[1] = Omega*Omega*y[1]-mu1*y[1]/r1cube-mu2*y[1]/r2cube;
+}
+
+Vector3D SymplecticRestricted3BodySolver::position()
+{
+    return Vector3D(state[0], state[1], 0);
+}
+
+Vector3D SymplecticRestricted3BodySolver::velocity()
+{
+    return Vector3D(state[2], state[3], 0);
+}
+
+Vector3D SymplecticRestricted3BodySolver::body1pos()
+{
+    return Vector3D(-pi2*r12, 0, 0);
+}
+
+Vector3D SymplecticRestricted3BodySolver::body2pos()
+{
+    return Vector3D(pi1*r12, 0, 0);
+}
+
+double SymplecticRestricted3BodySolver::jacobi_constant()
+{
+    double r1 = sqrt((state[0]+pi2*r12)*(state[0]+pi2*r12)+state[1]*state[1]);
+    double r2 = sqrt((state[0]-pi1*r12)*(state[0]-pi1*r12)+state[1]*state[1]);
+    double v2 = state[2]*state[2] + state[3]*state[3];
+    return Omega*Omega*(state[0]*state[0]+state[1]*state[1]) + 2*mu1/r1 + 2*mu2/r2 - v2;
+}
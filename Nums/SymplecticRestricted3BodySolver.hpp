@@ -0,0 +1,29 @@
+#ifndef SYMPLECTICRESTRICTED3BODYSOLVER_H
+#define SYMPLECTICRESTRICTED3BODYSOLVER_H
+
+#include "SymplecticSolver.hpp"
+
+#include "Vector3D.hpp"
+
+/* Planar circular restricted three body problem (Earth-Moon) in the rotating
+ * frame, the same problem as Restricted3BodySolver.  The Coriolis term is
+ * handled by the exact rotation of the splitting, the centrifugal and
+ * gravitational terms by the kicks.
+ */
+class SymplecticRestricted3BodySolver : public SymplecticSolver
+{
+public:
+    // define initial conditions and the dynamics equation
+    void InitialConditions();
+    void Acceleration(double t, const std::vector<double>& y, std::vector<double>& a);
+
+    // outputs from the simulation
+    Vector3D position();
+    Vector3D velocity();
+    Vector3D body1pos();
+    Vector3D body2pos();
+    // Jacobi constant, conserved by the exact flow
+    double jacobi_constant();
+};
+
+#endif // SYMPLECTICRESTRICTED3BODYSOLVER_H
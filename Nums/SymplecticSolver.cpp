@@ -0,0 +1,176 @@
+#include "SymplecticSolver.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+void SymplecticSolver::SetDimension(int dim)
+{
+    dim_ = dim;
+    state.resize(2*dim);
+    acc_.assign(dim, 0.0);
+    if (weights_.empty())
+    {
+        SetMethod(STORMER_VERLET);
+    }
+}
+
+void SymplecticSolver::SetFrameRotation(double omega)
+{
+    omega_ = omega;
+}
+
+void SymplecticSolver::SetMethod(Method method)
+{
+    weights_.clear();
+    switch (method)
+    {
+    case STORMER_VERLET:
+        weights_.push_back(1.0);
+        break;
+    case YOSHIDA4:
+    {
+        // triple jump, Yoshida (1990)
+        double w1 = 1/(2-cbrt(2.0));
+        double w0 = 1-2*w1;
+        weights_ = {w1, w0, w1};
+        break;
+    }
+    case YOSHIDA6:
+    {
+        // solution A of Yoshida (1990)
+        double w1 = -1.17767998417887100695;
+        double w2 = 0.235573213359358133684;
+        double w3 = 0.784513610477557263819;
+        double w0 = 1-2*(w1+w2+w3);
+        weights_ = {w3, w2, w1, w0, w1, w2, w3};
+        break;
+    }
+    }
+}
+
+// drift h/2, kick h/2, Coriolis h, kick h/2, drift h/2
+void SymplecticSolver::Substep(double h)
+{
+    for (int i=0; i<dim_; i++)
+    {
+        state[i] += 0.5*h*state[dim_+i];
+    }
+    // the Coriolis rotation does not move the positions, both kicks use the same acceleration
+    Acceleration(t_+0.5*h, state, acc_);
+    for (int i=0; i<dim_; i++)
+    {
+        state[dim_+i] += 0.5*h*acc_[i];
+    }
+    if (omega_ != 0)
+    {
+        double c = cos(2*omega_*h);
+        double s = sin(2*omega_*h);
+        double u = state[dim_];
+        double v = state[dim_+1];
+        state[dim_] = c*u + s*v;
+        state[dim_+1] = -s*u + c*v;
+    }
+    for (int i=0; i<dim_; i++)
+    {
+        state[dim_+i] += 0.5*h*acc_[i];
+    }
+    for (int i=0; i<dim_; i++)
+    {
+        state[i] += 0.5*h*state[dim_+i];
+    }
+}
+
+void SymplecticSolver::Step(double h)
+{
+    double t0 = t_;
+    for (unsigned int k=0; k<weights_.size(); k++)
+    {
+        Substep(weights_[k]*h);
+        t_ += weights_[k]*h;
+    }
+    t_ = t0 + h;
+}
+
+void SymplecticSolver::Derivative(double t, const std::vector<double>& y, std::vector<double>& f)
+{
+    f.resize(2*dim_);
+    Acceleration(t, y, acc_);
+    for (int i=0; i<dim_; i++)
+    {
+        f[i] = y[dim_+i];
+        f[dim_+i] = acc_[i];
+    }
+    if (omega_ != 0)
+    {
+        f[dim_] += 2*omega_*y[dim_+1];
+        f[dim_+1] -= 2*omega_*y[dim_];
+    }
+}
+
+void SymplecticSolver::UpdateState(double dt)
+{
+    terminated_ = false;
+    if (has_events())
+    {
+        UpdateStateWithEvents(dt);
+        return;
+    }
+    double t_target = t_ + dt;
+    while (t_ < t_target)
+    {
+        Step(std::min(mStepSize, t_target - t_));
+    }
+    t_ = t_target;
+}
+
+// same steps as UpdateState, with the derivatives at the step ends for a
+// cubic Hermite interpolant
+void SymplecticSolver::UpdateStateWithEvents(double dt)
+{
+    double t_target = t_ + dt;
+    double t0 = t_;
+    double h = mStepSize;
+    Derivative(t_, state, f_next_);
+    auto hermite = [&](double t, std::vector<double>& y)
+    {
+        double theta = (t - t0)/h;
+        double theta2 = theta*theta;
+        double h00 = (2*theta - 3)*theta2 + 1;
+        double h10 = ((theta - 2)*theta + 1)*theta*h;
+        double h01 = (3 - 2*theta)*theta2;
+        double h11 = (theta - 1)*theta2*h;
+        y.resize(2*dim_);
+        for (int j=0; j<2*dim_; j++)
+        {
+            y[j] = h00*y_prev_[j] + h10*f_prev_[j] + h01*state[j] + h11*f_next_[j];
+        }
+    };
+
+    while (t_ < t_target)
+    {
+        t0 = t_;
+        h = std::min(mStepSize, t_target - t_);
+        y_prev_ = state;
+        f_prev_.swap(f_next_);
+        Step(h);
+        Derivative(t_, state, f_next_);
+
+        double t_stop;
+        if (LocateEvents(t0, t_, hermite, t_stop))
+        {
+            std::vector<double> y_event;
+            hermite(t_stop, y_event);
+            state.swap(y_event);
+            t_ = t_stop;
+            return;
+        }
+    }
+    t_ = t_target;
+}
+
+void SymplecticSolver::SolveEquation(std::vector<double>)
+{
+    state = mInitialValueVector;
+    t_ = mInitialTime;
+    UpdateState(mFinalTime - mInitialTime);
+}
@@ -0,0 +1,65 @@
+#ifndef SYMPLECTICSOLVER_H
+#define SYMPLECTICSOLVER_H
+
+#include "AbstractOdeSolver.hpp"
+#include <vector>
+
+/* Splitting integrators for second order systems q'' = a(q), optionally in a
+ * frame rotating about z with rate Omega (q'' = a(q) - 2 Omega x q', the
+ * centrifugal term belongs to a(q)).  The basic step is the symmetric
+ * Stormer-Verlet splitting
+ *   drift h/2, kick h/2, Coriolis h, kick h/2, drift h/2
+ * where the Coriolis flow is solved exactly as a rotation of the velocity, so
+ * the step stays time reversible and needs one acceleration per step.
+ * The 4th and 6th order methods are Yoshida's symmetric compositions of it.
+ * Unlike Runge-Kutta methods the energy (or Jacobi constant) error stays
+ * bounded instead of drifting over long propagations.
+ *
+ * The state holds the positions followed by the velocities.  Events are
+ * located on the cubic Hermite interpolant between the step ends, which costs
+ * one more acceleration per step while events are set.
+ */
+class SymplecticSolver : public AbstractOdeSolver
+{
+public:
+    enum Method { STORMER_VERLET, YOSHIDA4, YOSHIDA6 };
+
+private:
+    int dim_ = 0;
+    double omega_ = 0;
+    std::vector<double> acc_;
+    // step fractions of the composition
+    std::vector<double> weights_;
+    // step ends for the cubic Hermite interpolation used by the events
+    std::vector<double> y_prev_;
+    std::vector<double> f_prev_;
+    std::vector<double> f_next_;
+
+    void Substep(double h);
+    // time derivative [v, a - 2 Omega x v] of the state y
+    void Derivative(double t, const std::vector<double>& y, std::vector<double>& f);
+    void UpdateStateWithEvents(double dt);
+protected:
+    std::vector<double> state;
+
+    // number of position coordinates, the state has twice that many entries
+    void SetDimension(int dim);
+    // rotation rate of the frame about the z (third) axis, the Coriolis term
+    // acts on the first two coordinates
+    void SetFrameRotation(double omega);
+public:
+    // implementations of virtual methods from inherited class
+    void UpdateState(double dt);
+    void SolveEquation(std::vector<double> yi);
+
+    void SetMethod(Method method);
+    // a single step of the current step size
+    void Step(double h);
+
+    // virtual methods
+    virtual void InitialConditions() = 0;
+    // acceleration from the position dependent forces, y is the full state
+    virtual void Acceleration(double t, const std::vector<double>& y, std::vector<double>& a) = 0;
+};
+
+#endif // SYMPLECTICSOLVER_H
@@ -0,0 +1,60 @@
+#include "SymplecticTwoBodySolver.hpp"
+
+#include <cmath>
+
+const double h = 10;
+const double G = 6.67259e-20;
+const double m1 = 5.974e24;
+const double mu = G*m1;
+
+void SymplecticTwoBodySolver::InitialConditions()
+{
+    Eigen::Vector3d Rx, Vx;
+    // satellite orbit
+    Rx << 757.7, 5222.607, 4851.5;
+    Vx << 2.21321, 4.67834, -5.37130;
+    InitialConditions(Rx, Vx);
+}
+
+void SymplecticTwoBodySolver::InitialConditions(Eigen::Vector3d r, Eigen::Vector3d v)
+{
+    SetDimension(3);
+    SetMethod(YOSHIDA4);
+    SetStepSize(h);
+
+    state[0] = r(0);
+    state[1] = r(1);
+    state[2] = r(2);
+    state[3] = v(0);
+    state[4] = v(1);
+    state[5] = v(2);
+
+    SetInitialValue(state);
+    t_ = 0;
+}
+
+void SymplecticTwoBodySolver::Acceleration(double, const std::vector<double> &y, std::vector<double> &a)
+{
+    double r = sqrt(y[0]*y[0] + y[1]*y[1] + y[2]*y[2]);
+    double rcube = r*r*r;
+    a[0] = -mu*y[0]/rcube;
+    a[1] = -mu*y[1]/rcube;
+    a[2] = -mu*y[2]/rcube;
+}
+
+Vector3D SymplecticTwoBodySolver::position()
+{
+    return Vector3D(state[0], state[1], state[2]);
+}
+
+Vector3D SymplecticTwoBodySolver::velocity()
+{
+    return Vector3D(state[3], state[4], state[5]);
+}
+
+double SymplecticTwoBodySolver::energy()
+{
+    double r = sqrt(state[0]*state[0] + state[1]*state[1] + state[2]*state[2]);
+    double v2 = state[3]*state[3] + state[4]*state[4] + state[5]*state[5];
+    return 0.5*v2 - mu/r;
+}
@@ -0,0 +1,27 @@
+#ifndef SYMPLECTICTWOBODYSOLVER_H
+#define SYMPLECTICTWOBODYSOLVER_H
+
+#include "SymplecticSolver.hpp"
+#include "Eigen/Dense"
+
+#include "Vector3D.hpp"
+
+/* Satellite around a point mass Earth, the same problem as TwoBodySolver but
+ * propagated with a symplectic composition method.
+ */
+class SymplecticTwoBodySolver : public SymplecticSolver
+{
+public:
+    // define initial conditions and the dynamics equation
+    void InitialConditions();
+    void InitialConditions(Eigen::Vector3d r, Eigen::Vector3d v);
+    void Acceleration(double t, const std::vector<double>& y, std::vector<double>& a);
+
+    // outputs from the simulation
+    Vector3D position();
+    Vector3D velocity();
+    // specific orbital energy
+    double energy();
+};
+
+#endif // SYMPLECTICTWOBODYSOLVER_H
@@ -0,0 +1,236 @@
+#include "TaylorSolver.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+void TaylorSolver::Setup()
+{
+    state.assign(state_dim_, 0.0);
+    y_.assign(state_dim_, 0.0);
+    reported_.assign(state_dim_, 0.0);
+    SetStepSize(1);
+    SetOrder(0);
+}
+
+void TaylorSolver::SetTolerances(double atol, double rtol)
+{
+    atol_ = atol;
+    rtol_ = rtol;
+    SetOrder(0);
+}
+
+void TaylorSolver::SetOrder(int order)
+{
+    if (order <= 0)
+    {
+        double tol = rtol_ > 0 ? rtol_ : atol_;
+        order = static_cast<int>(std::ceil(-0.5*log(tol))) + 3;
+    }
+    order_ = order;
+    tape_.SetOrder(order_);
+    series_.assign(state_dim_*(order_+1), 0.0);
+    started_ = false;
+}
+
+void TaylorSolver::SetMaxStepSize(double h_max)
+{
+    h_max_ = h_max;
+}
+
+int TaylorSolver::order() const
+{
+    return order_;
+}
+
+long TaylorSolver::steps() const
+{
+    return steps_;
+}
+
+int TaylorSolver::tape_size() const
+{
+    return tape_.num_nodes();
+}
+
+void TaylorSolver::InitialConditions()
+{
+    state = mInitialValueVector;
+    t_ = mInitialTime;
+    started_ = false;
+}
+
+void TaylorSolver::Restart()
+{
+    y_ = state;
+    t_int_ = t_;
+    t_prev_ = t_;
+    h_last_ = 0;
+    reported_ = state;
+    t_reported_ = t_;
+    t_checked_ = t_;
+    started_ = true;
+}
+
+void TaylorSolver::Expand()
+{
+    const int stride = order_+1;
+    double* t = tape_.input(0);
+    t[0] = t_int_;
+    for (int k=1; k<=order_; k++)
+    {
+        t[k] = k == 1 ? 1 : 0;
+    }
+    for (int i=0; i<state_dim_; i++)
+    {
+        tape_.input(1+i)[0] = y_[i];
+        series_[i*stride] = y_[i];
+    }
+    for (int k=0; k<order_; k++)
+    {
+        tape_.Propagate(k);
+        for (int i=0; i<state_dim_; i++)
+        {
+            double y = tape_.output(i)[k]/(k+1);
+            tape_.input(1+i)[k+1] = y;
+            series_[i*stride+k+1] = y;
+        }
+    }
+}
+
+void TaylorSolver::Step()
+{
+    const int stride = order_+1;
+    Expand();
+
+    // radius of convergence estimated from the last two coefficients
+    double h = HUGE_VAL;
+    for (int j=order_-1; j<=order_; j++)
+    {
+        double norm = 0;
+        for (int i=0; i<state_dim_; i++)
+        {
+            double scale = atol_ + rtol_*std::abs(y_[i]);
+            norm = std::max(norm, std::abs(series_[i*stride+j])/scale);
+        }
+        if (norm > 0)
+        {
+            h = std::min(h, pow(norm, -1.0/j));
+        }
+    }
+    h *= exp(-0.7/(order_-1));
+    if (h_max_ > 0)
+    {
+        h = std::min(h, h_max_);
+    }
+    if (h == HUGE_VAL)
+    {
+        h = mStepSize;
+    }
+
+    for (int i=0; i<state_dim_; i++)
+    {
+        // Horner
+        const double* c = &series_[i*stride];
+        double y = c[order_];
+        for (int k=order_-1; k>=0; k--)
+        {
+            y = y*h + c[k];
+        }
+        y_[i] = y;
+    }
+    t_prev_ = t_int_;
+    t_int_ += h;
+    h_last_ = h;
+    steps_++;
+}
+
+void TaylorSolver::DenseOutput(double t, std::vector<double>& y) const
+{
+    if (h_last_ == 0)
+    {
+        y = y_;
+        return;
+    }
+    const int stride = order_+1;
+    double s = t - t_prev_;
+    for (int i=0; i<state_dim_; i++)
+    {
+        const double* c = &series_[i*stride];
+        double sum = c[order_];
+        for (int k=order_-1; k>=0; k--)
+        {
+            sum = sum*s + c[k];
+        }
+        y[i] = sum;
+    }
+}
+
+void TaylorSolver::UpdateState(double dt)
+{
+    // somebody changed the state or the time since the last update
+    if (!started_ || t_ != t_reported_ || state != reported_)
+    {
+        Restart();
+    }
+    terminated_ = false;
+    double t_target = t_ + dt;
+    if (has_events())
+    {
+        auto dense = [this](double t, std::vector<double>& y)
+        {
+            y.resize(state_dim_);
+            DenseOutput(t, y);
+        };
+        while (true)
+        {
+            // the last step may reach beyond the last reported time
+            double t_end = std::min(t_int_, t_target);
+            double t_stop;
+            if (t_end > t_checked_ && LocateEvents(t_checked_, t_end, dense, t_stop))
+            {
+                DenseOutput(t_stop, state);
+                t_ = t_stop;
+                t_checked_ = t_stop;
+                reported_ = state;
+                t_reported_ = t_;
+                return;
+            }
+            t_checked_ = std::max(t_checked_, t_end);
+            if (t_int_ >= t_target) break;
+            Step();
+        }
+    }
+    while (t_int_ < t_target)
+    {
+        Step();
+    }
+    DenseOutput(t_target, state);
+    t_ = t_target;
+    reported_ = state;
+    t_reported_ = t_;
+}
+
+void TaylorSolver::SolveEquation(std::vector<double>)
+{
+    state = mInitialValueVector;
+    t_ = mInitialTime;
+    started_ = false;
+    UpdateState(mFinalTime - mInitialTime);
+}
+
+void TaylorSolver::getState(Eigen::VectorXd& x)
+{
+    x.resize(state_dim_);
+    for (int i=0; i<state_dim_; i++)
+    {
+        x(i) = state[i];
+    }
+}
+
+void TaylorSolver::setState(const Eigen::VectorXd& x)
+{
+    for (int i=0; i<state_dim_; i++)
+    {
+        state[i] = x(i);
+    }
+}
@@ -0,0 +1,110 @@
+#ifndef TAYLORSOLVER_H
+#define TAYLORSOLVER_H
+
+#include <vector>
+#include "Eigen/Dense"
+
+#include "AbstractOdeSolver.hpp"
+#include "TaylorTape.hpp"
+
+/* Taylor series integrator of high order for systems whose right hand side is
+ * a template on its scalar type, Dynamics(t, y, f) as in TwoBodySolver,
+ * SatelliteSolver and Restricted3BodySolver.  The dynamics are recorded once
+ * on a TaylorTape and every step expands the solution
+ *   y(t + s) = sum_k y_k s^k,   y_{k+1} = f_k/(k+1)
+ * to the order p through the coefficient recurrences of the tape, so one step
+ * costs O(p^2) per operation of the right hand side and no extra evaluations.
+ *
+ * The step size comes from the decay of the last two coefficients (Jorba and
+ * Zou 2005):
+ *   h = min_{j=p-1,p} |y_j|^(-1/j) exp(-0.7/(p-1))
+ * with |.| the largest component scaled by atol + rtol |y_0|, and the order by
+ * default from the tolerance, p = ceil(-ln(rtol)/2) + 3 (21 for 1e-15), two
+ * above the estimate of Jorba and Zou where the longer steps of the two body
+ * problem still pay for the extra terms.  At 1e-15 a LEO orbit takes about
+ * eight steps per revolution.  The series of
+ * the last step is the dense output: UpdateState evaluates it at the requested
+ * time, so the integrator runs ahead with its own steps as
+ * AdaptiveRungeKuttaSolver, and the events are located on it.  The step
+ * size set by SetStepSize is only taken if every derivative vanishes.
+ */
+class TaylorSolver : public AbstractOdeSolver
+{
+private:
+    int state_dim_;
+    TaylorTape tape_;
+    int order_ = 0;
+    double atol_ = 1e-15;
+    double rtol_ = 1e-15;
+    double h_max_ = 0;
+
+    // integrator state at t_int_ and the series of the last step from t_prev_
+    std::vector<double> y_;
+    double t_int_ = 0;
+    std::vector<double> series_;
+    double t_prev_ = 0;
+    double h_last_ = 0;
+    // state and time handed out by the last UpdateState, to detect external changes
+    std::vector<double> reported_;
+    double t_reported_ = 0;
+    bool started_ = false;
+    double t_checked_ = 0;
+    long steps_ = 0;
+
+    void Setup();
+    // coefficients of the expansion at (t_int_, y_) into series_
+    void Expand();
+    void Step();
+protected:
+    std::vector<double> state;
+public:
+    // records system.Dynamics for a state of state_dim components
+    template <class System>
+    TaylorSolver(const System& system, int state_dim);
+
+    // implementations of virtual methods from inherited class
+    void InitialConditions();
+    void UpdateState(double dt);
+    void SolveEquation(std::vector<double> yi);
+
+    // error tolerance of every component, atol + rtol |y|, also resets the order
+    void SetTolerances(double atol, double rtol);
+    // order of the expansion, 0 chooses it from the tolerance
+    void SetOrder(int order);
+    // upper bound on the step size, 0 means unbounded
+    void SetMaxStepSize(double h_max);
+    // restarts from the current state, needed after changes from outside
+    // (otherwise detected automatically)
+    void Restart();
+
+    // solution at time t inside the last step
+    void DenseOutput(double t, std::vector<double>& y) const;
+
+    void getState(Eigen::VectorXd& x);
+    void setState(const Eigen::VectorXd& x);
+
+    int order() const;
+    long steps() const;
+    // number of operations of the recorded right hand side
+    int tape_size() const;
+};
+
+template <class System>
+TaylorSolver::TaylorSolver(const System& system, int state_dim)
+    : state_dim_(state_dim)
+{
+    TaylorVariable t = tape_.Input();
+    std::vector<TaylorVariable> y(state_dim), f(state_dim);
+    for (int i=0; i<state_dim; i++)
+    {
+        y[i] = tape_.Input();
+    }
+    system.Dynamics(t, y.data(), f.data());
+    for (int i=0; i<state_dim; i++)
+    {
+        tape_.Output(f[i]);
+    }
+    Setup();
+}
+
+#endif // TAYLORSOLVER_H
@@ -0,0 +1,331 @@
+#include "TaylorTape.hpp"
+
+#include <cmath>
+
+TaylorVariable::TaylorVariable(double constant)
+    : tape_(nullptr), node_(-1), constant_(constant)
+{
+}
+
+TaylorVariable::TaylorVariable(TaylorTape* tape, int node)
+    : tape_(tape), node_(node), constant_(0)
+{
+}
+
+bool TaylorVariable::is_constant() const
+{
+    return tape_ == nullptr;
+}
+
+double TaylorVariable::constant() const
+{
+    return constant_;
+}
+
+int TaylorVariable::node() const
+{
+    return node_;
+}
+
+TaylorTape* TaylorVariable::tape() const
+{
+    return tape_;
+}
+
+TaylorVariable& TaylorVariable::operator+=(const TaylorVariable& b)
+{
+    return *this = *this + b;
+}
+
+TaylorVariable& TaylorVariable::operator-=(const TaylorVariable& b)
+{
+    return *this = *this - b;
+}
+
+TaylorVariable& TaylorVariable::operator*=(const TaylorVariable& b)
+{
+    return *this = *this * b;
+}
+
+TaylorVariable& TaylorVariable::operator/=(const TaylorVariable& b)
+{
+    return *this = *this / b;
+}
+
+// node for op on a with the constant c
+static TaylorVariable Unary(TaylorTape::Op op, const TaylorVariable& a, double c)
+{
+    return TaylorVariable(a.tape(), a.tape()->Record(op, a.node(), -1, c));
+}
+
+static TaylorVariable Binary(TaylorTape::Op op, const TaylorVariable& a, const TaylorVariable& b)
+{
+    return TaylorVariable(a.tape(), a.tape()->Record(op, a.node(), b.node(), 0));
+}
+
+TaylorVariable operator-(const TaylorVariable& a)
+{
+    if (a.is_constant())
+    {
+        return TaylorVariable(-a.constant());
+    }
+    return Unary(TaylorTape::MUL_CONSTANT, a, -1);
+}
+
+TaylorVariable operator+(const TaylorVariable& a, const TaylorVariable& b)
+{
+    if (a.is_constant() && b.is_constant())
+    {
+        return TaylorVariable(a.constant() + b.constant());
+    }
+    if (a.is_constant())
+    {
+        return Unary(TaylorTape::ADD_CONSTANT, b, a.constant());
+    }
+    if (b.is_constant())
+    {
+        return Unary(TaylorTape::ADD_CONSTANT, a, b.constant());
+    }
+    return Binary(TaylorTape::ADD, a, b);
+}
+
+TaylorVariable operator-(const TaylorVariable& a, const TaylorVariable& b)
+{
+    if (a.is_constant() && b.is_constant())
+    {
+        return TaylorVariable(a.constant() - b.constant());
+    }
+    if (a.is_constant())
+    {
+        return Unary(TaylorTape::CONSTANT_SUB, b, a.constant());
+    }
+    if (b.is_constant())
+    {
+        return Unary(TaylorTape::ADD_CONSTANT, a, -b.constant());
+    }
+    return Binary(TaylorTape::SUB, a, b);
+}
+
+TaylorVariable operator*(const TaylorVariable& a, const TaylorVariable& b)
+{
+    if (a.is_constant() && b.is_constant())
+    {
+        return TaylorVariable(a.constant()*b.constant());
+    }
+    if (a.is_constant())
+    {
+        return Unary(TaylorTape::MUL_CONSTANT, b, a.constant());
+    }
+    if (b.is_constant())
+    {
+        return Unary(TaylorTape::MUL_CONSTANT, a, b.constant());
+    }
+    return Binary(TaylorTape::MUL, a, b);
+}
+
+TaylorVariable operator/(const TaylorVariable& a, const TaylorVariable& b)
+{
+    if (a.is_constant() && b.is_constant())
+    {
+        return TaylorVariable(a.constant()/b.constant());
+    }
+    if (a.is_constant())
+    {
+        return Unary(TaylorTape::CONSTANT_DIV, b, a.constant());
+    }
+    if (b.is_constant())
+    {
+        return Unary(TaylorTape::MUL_CONSTANT, a, 1/b.constant());
+    }
+    return Binary(TaylorTape::DIV, a, b);
+}
+
+TaylorVariable sqrt(const TaylorVariable& a)
+{
+    if (a.is_constant())
+    {
+        return TaylorVariable(std::sqrt(a.constant()));
+    }
+    return Unary(TaylorTape::SQRT, a, 0);
+}
+
+TaylorVariable exp(const TaylorVariable& a)
+{
+    if (a.is_constant())
+    {
+        return TaylorVariable(std::exp(a.constant()));
+    }
+    return Unary(TaylorTape::EXP, a, 0);
+}
+
+TaylorVariable pow(const TaylorVariable& a, double p)
+{
+    if (a.is_constant())
+    {
+        return TaylorVariable(std::pow(a.constant(), p));
+    }
+    return Unary(TaylorTape::POW, a, p);
+}
+
+TaylorVariable TaylorTape::Input()
+{
+    int node = Record(INPUT, -1, -1, 0);
+    inputs_.push_back(node);
+    return TaylorVariable(this, node);
+}
+
+void TaylorTape::Output(const TaylorVariable& f)
+{
+    if (f.is_constant())
+    {
+        outputs_.push_back(Record(CONSTANT, -1, -1, f.constant()));
+        return;
+    }
+    outputs_.push_back(f.node());
+}
+
+int TaylorTape::Record(Op op, int a, int b, double c)
+{
+    Node node = {op, a, b, c};
+    nodes_.push_back(node);
+    return static_cast<int>(nodes_.size())-1;
+}
+
+void TaylorTape::Clear()
+{
+    nodes_.clear();
+    inputs_.clear();
+    outputs_.clear();
+    coefficients_.clear();
+}
+
+void TaylorTape::SetOrder(int order)
+{
+    order_ = order;
+    coefficients_.assign(nodes_.size()*(order_+1), 0.0);
+}
+
+int TaylorTape::order() const
+{
+    return order_;
+}
+
+int TaylorTape::num_inputs() const
+{
+    return static_cast<int>(inputs_.size());
+}
+
+int TaylorTape::num_outputs() const
+{
+    return static_cast<int>(outputs_.size());
+}
+
+int TaylorTape::num_nodes() const
+{
+    return static_cast<int>(nodes_.size());
+}
+
+double* TaylorTape::input(int i)
+{
+    return &coefficients_[inputs_[i]*(order_+1)];
+}
+
+const double* TaylorTape::output(int i) const
+{
+    return &coefficients_[outputs_[i]*(order_+1)];
+}
+
+void TaylorTape::Propagate(int k)
+{
+    const int stride = order_+1;
+    for (unsigned int i=0; i<nodes_.size(); i++)
+    {
+        const Node& node = nodes_[i];
+        double* r = &coefficients_[i*stride];
+        const double* a = node.a >= 0 ? &coefficients_[node.a*stride] : nullptr;
+        const double* b = node.b >= 0 ? &coefficients_[node.b*stride] : nullptr;
+        const double c0 = k == 0 ? node.c : 0;
+        double sum = 0;
+        switch (node.op)
+        {
+        case INPUT:
+            break;
+        case CONSTANT:
+            r[k] = c0;
+            break;
+        case ADD:
+            r[k] = a[k] + b[k];
+            break;
+        case SUB:
+            r[k] = a[k] - b[k];
+            break;
+        case ADD_CONSTANT:
+            r[k] = a[k] + c0;
+            break;
+        case MUL_CONSTANT:
+            r[k] = node.c*a[k];
+            break;
+        case CONSTANT_SUB:
+            r[k] = c0 - a[k];
+            break;
+        case MUL:
+            for (int j=0; j<=k; j++)
+            {
+                sum += a[j]*b[k-j];
+            }
+            r[k] = sum;
+            break;
+        case DIV:
+            for (int j=1; j<=k; j++)
+            {
+                sum += b[j]*r[k-j];
+            }
+            r[k] = (a[k] - sum)/b[0];
+            break;
+        case CONSTANT_DIV:
+            // c/a
+            for (int j=1; j<=k; j++)
+            {
+                sum += a[j]*r[k-j];
+            }
+            r[k] = (c0 - sum)/a[0];
+            break;
+        case SQRT:
+            if (k == 0)
+            {
+                r[0] = std::sqrt(a[0]);
+                break;
+            }
+            for (int j=1; j<k; j++)
+            {
+                sum += r[j]*r[k-j];
+            }
+            r[k] = (a[k] - sum)/(2*r[0]);
+            break;
+        case EXP:
+            if (k == 0)
+            {
+                r[0] = std::exp(a[0]);
+                break;
+            }
+            for (int j=1; j<=k; j++)
+            {
+                sum += j*a[j]*r[k-j];
+            }
+            r[k] = sum/k;
+            break;
+        case POW:
+            if (k == 0)
+            {
+                r[0] = std::pow(a[0], node.c);
+                break;
+            }
+            for (int j=0; j<k; j++)
+            {
+                sum += (node.c*(k-j) - j)*a[k-j]*r[j];
+            }
+            r[k] = sum/(k*a[0]);
+            break;
+        }
+    }
+}
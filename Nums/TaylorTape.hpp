@@ -0,0 +1,103 @@
+#ifndef TAYLORTAPE_H
+#define TAYLORTAPE_H
+
+#include <vector>
+
+class TaylorTape;
+
+/* Scalar that records the operations of a function template on a TaylorTape
+ * instead of computing them, so that a right hand side written once on its
+ * scalar type (as the Dual<N> Jacobians) also yields the recurrences of its
+ * Taylor coefficients.  Only arithmetic, sqrt, exp and pow with a constant
+ * exponent are recorded; nothing is known about the values while recording,
+ * so the function must not branch on its arguments.  A variable built from a
+ * double is a constant, operations on constants are folded.
+ */
+class TaylorVariable
+{
+private:
+    TaylorTape* tape_;
+    int node_;
+    double constant_;
+public:
+    TaylorVariable(double constant = 0);
+    TaylorVariable(TaylorTape* tape, int node);
+
+    bool is_constant() const;
+    double constant() const;
+    // node on the tape, -1 for a constant
+    int node() const;
+    TaylorTape* tape() const;
+
+    TaylorVariable& operator+=(const TaylorVariable& b);
+    TaylorVariable& operator-=(const TaylorVariable& b);
+    TaylorVariable& operator*=(const TaylorVariable& b);
+    TaylorVariable& operator/=(const TaylorVariable& b);
+};
+
+TaylorVariable operator-(const TaylorVariable& a);
+TaylorVariable operator+(const TaylorVariable& a, const TaylorVariable& b);
+TaylorVariable operator-(const TaylorVariable& a, const TaylorVariable& b);
+TaylorVariable operator*(const TaylorVariable& a, const TaylorVariable& b);
+TaylorVariable operator/(const TaylorVariable& a, const TaylorVariable& b);
+TaylorVariable sqrt(const TaylorVariable& a);
+TaylorVariable exp(const TaylorVariable& a);
+TaylorVariable pow(const TaylorVariable& a, double p);
+
+/* Recorded function and the coefficients of the Taylor expansion of each of
+ * its nodes, c[k] the coefficient of s^k.  Once the coefficients 0..k of the
+ * inputs are set, Propagate(k) gives coefficient k of every node from the
+ * usual recurrences (Jorba and Zou 2005), e.g. for c = a*b and c = a/b
+ *   c[k] = sum_{j=0..k} a[j] b[k-j]
+ *   c[k] = (a[k] - sum_{j=1..k} b[j] c[k-j])/b[0]
+ * so a whole expansion of order p costs O(p^2) per node.
+ */
+class TaylorTape
+{
+public:
+    enum Op { INPUT, CONSTANT, ADD, SUB, MUL, DIV, ADD_CONSTANT, MUL_CONSTANT,
+              CONSTANT_SUB, CONSTANT_DIV, SQRT, EXP, POW };
+
+private:
+    struct Node
+    {
+        Op op;
+        int a;
+        int b;
+        double c;
+    };
+    std::vector<Node> nodes_;
+    std::vector<int> inputs_;
+    std::vector<int> outputs_;
+    int order_ = 0;
+    // coefficients 0..order_ of node i from coefficients_[i*(order_+1)]
+    std::vector<double> coefficients_;
+
+public:
+    // a new input, its coefficients are set through input()
+    TaylorVariable Input();
+    // marks f as the next output, a constant gets a node of its own
+    void Output(const TaylorVariable& f);
+    // node for an operation on the nodes a and b (or a and the constant c)
+    int Record(Op op, int a, int b, double c);
+    // clears the recording
+    void Clear();
+
+    // allocates the coefficients of expansions up to the given order, after
+    // the recording
+    void SetOrder(int order);
+    int order() const;
+    int num_inputs() const;
+    int num_outputs() const;
+    int num_nodes() const;
+
+    // coefficients of input i and output i
+    double* input(int i);
+    const double* output(int i) const;
+
+    // coefficient k of every node, needs coefficients 0..k of the inputs
+    // and 0..k-1 of the other nodes
+    void Propagate(int k);
+};
+
+#endif // TAYLORTAPE_H
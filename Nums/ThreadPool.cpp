@@ -0,0 +1,144 @@
+#include "ThreadPool.hpp"
+
+#include <algorithm>
+
+namespace
+{
+// pool and worker index of the calling thread
+thread_local const ThreadPool* current_pool = nullptr;
+thread_local int current_worker = -1;
+}
+
+ThreadPool::ThreadPool(int num_threads)
+    : pending_(0), queued_(0), next_worker_(0)
+{
+    if (num_threads <= 0)
+    {
+        num_threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    for (int i=0; i<num_threads; i++)
+    {
+        workers_.emplace_back(new Worker);
+    }
+    for (int i=0; i<num_threads; i++)
+    {
+        threads_.emplace_back(&ThreadPool::WorkerLoop, this, i);
+    }
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = true;
+    }
+    work_available_.notify_all();
+    for (unsigned int i=0; i<threads_.size(); i++)
+    {
+        threads_[i].join();
+    }
+}
+
+int ThreadPool::size() const
+{
+    return static_cast<int>(workers_.size());
+}
+
+int ThreadPool::CurrentWorker() const
+{
+    return current_pool == this ? current_worker : -1;
+}
+
+void ThreadPool::Submit(Task task)
+{
+    int w = CurrentWorker();
+    if (w < 0)
+    {
+        w = next_worker_++ % workers_.size();
+    }
+    pending_++;
+    {
+        std::lock_guard<std::mutex> lock(workers_[w]->mutex);
+        workers_[w]->tasks.push_back(std::move(task));
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        queued_++;
+    }
+    work_available_.notify_one();
+}
+
+void ThreadPool::Wait()
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    all_done_.wait(lock, [this] { return pending_ == 0; });
+}
+
+void ThreadPool::ParallelFor(long begin, long end, long grain,
+                             const std::function<void(long i, int worker)>& body)
+{
+    grain = std::max(1L, grain);
+    for (long first=begin; first<end; first+=grain)
+    {
+        long last = std::min(end, first+grain);
+        Submit([first, last, &body](int worker)
+               {
+                   for (long i=first; i<last; i++)
+                   {
+                       body(i, worker);
+                   }
+               });
+    }
+    Wait();
+}
+
+// own work is taken from the back, stolen work from the front of the victim's deque
+bool ThreadPool::PopOrSteal(int index, Task& task)
+{
+    const int n = size();
+    for (int k=0; k<n; k++)
+    {
+        Worker& victim = *workers_[(index+k) % n];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (victim.tasks.empty()) continue;
+        if (k == 0)
+        {
+            task = std::move(victim.tasks.back());
+            victim.tasks.pop_back();
+        }
+        else
+        {
+            task = std::move(victim.tasks.front());
+            victim.tasks.pop_front();
+        }
+        queued_--;
+        return true;
+    }
+    return false;
+}
+
+void ThreadPool::WorkerLoop(int index)
+{
+    current_pool = this;
+    current_worker = index;
+    while (true)
+    {
+        Task task;
+        if (PopOrSteal(index, task))
+        {
+            task(index);
+            if (--pending_ == 0)
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                all_done_.notify_all();
+            }
+            continue;
+        }
+        std::unique_lock<std::mutex> lock(mutex_);
+        work_available_.wait(lock, [this] { return stop_ || queued_ > 0; });
+        if (stop_ && queued_ <= 0)
+        {
+            return;
+        }
+    }
+}
@@ -0,0 +1,74 @@
+#ifndef THREADPOOL_H
+#define THREADPOOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/* Fixed size pool of worker threads with work stealing.  Every worker owns a
+ * task deque: it pops its own work from the back (most recently submitted,
+ * still warm in cache) and, when that runs dry, steals from the front of the
+ * other workers' deques.  Tasks submitted from outside the pool are dealt out
+ * round robin, tasks submitted from inside a task go to the current worker.
+ *
+ * Tasks receive the index of the worker that runs them, which can be used to
+ * address per thread data (random number streams, accumulators, output files)
+ * without any locking.
+ */
+class ThreadPool
+{
+public:
+    typedef std::function<void(int worker)> Task;
+
+    // num_threads = 0 uses one thread per hardware core
+    explicit ThreadPool(int num_threads = 0);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    int size() const;
+
+    void Submit(Task task);
+    // blocks until all submitted tasks, including the ones they submitted, are done,
+    // must not be called from inside a task
+    void Wait();
+
+    // runs body(i, worker) for i in [begin, end) split into chunks of grain
+    // iterations and waits for completion, same restriction as Wait
+    void ParallelFor(long begin, long end, long grain,
+                     const std::function<void(long i, int worker)>& body);
+
+    // index of the calling worker thread, -1 outside of this pool
+    int CurrentWorker() const;
+
+private:
+    struct Worker
+    {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+    };
+
+    std::vector<std::unique_ptr<Worker> > workers_;
+    std::vector<std::thread> threads_;
+
+    // sleeping and waiting on completion
+    std::mutex mutex_;
+    std::condition_variable work_available_;
+    std::condition_variable all_done_;
+
+    std::atomic<long> pending_;
+    std::atomic<long> queued_;
+    std::atomic<unsigned> next_worker_;
+    bool stop_ = false;
+
+    void WorkerLoop(int index);
+    bool PopOrSteal(int index, Task& task);
+};
+
+#endif // THREADPOOL_H
@@ -5,9 +5,8 @@
 #include <vector>
 #include <cmath>
 #include "TwoBodySolver.hpp"
-#include <QApplication>
+#include "TaylorTape.hpp"
 
-#include <Python.h>
 
 
 const double h = 0.1;// (tf-t0)/n;
@@ -47,14 +46,14 @@ void TwoBodySolver::InitialConditions()
     // if we want to describe the trajectory using Gibbs method
     /*
 
-    Omt::orbit_desc(Rx, Vx, QVector3D(-294.32, 4265.1, 5986.7),
-                   QVector3D(-1365.5, 3637.6, 6346.8), QVector3D(-2940.3, 2473.7, 6555.8), 398600);
-    omt.orbit_desc(QVector3D(Rx(0), Rx(1), Rx(2)), QVector3D(Vx(0), Vx(1), Vx(2)), 398600);
+    Omt::orbit_desc(Rx, Vx, Vector3D(-294.32, 4265.1, 5986.7),
+                   Vector3D(-1365.5, 3637.6, 6346.8), Vector3D(-2940.3, 2473.7, 6555.8), 398600);
+    omt.orbit_desc(Vector3D(Rx(0), Rx(1), Rx(2)), Vector3D(Vx(0), Vx(1), Vx(2)), 398600);
     */
 
     // if we want to describe the trajectory using Lambert problem formulation
-    //Omt::orbit_desc(Rx, Vx, QVector3D(5000, 10000, 2100), QVector3D(-14600, 2500, 7000), 3600, true, 398600);
-    //omt.orbit_desc(QVector3D(Rx(0), Rx(1), Rx(2)), QVector3D(Vx(0), Vx(1), Vx(2)), 398600);
+    //Omt::orbit_desc(Rx, Vx, Vector3D(5000, 10000, 2100), Vector3D(-14600, 2500, 7000), 3600, true, 398600);
+    //omt.orbit_desc(Vector3D(Rx(0), Rx(1), Rx(2)), Vector3D(Vx(0), Vx(1), Vx(2)), 398600);
 
     // satellite orbit
     Rx << 757.7, 5222.607, 4851.5;
@@ -103,24 +102,17 @@ void TwoBodySolver::InitialConditions(Eigen::Vector3d r, Eigen::Vector3d v)
 
 void TwoBodySolver::RightHandSide(double t, const std::vector<double> &y, std::vector<double> &f)
 {
-    double r = sqrt(pow(y[3]-y[0],2) + pow(y[4]-y[1],2) + pow(y[5]-y[2],2));
-    const double rho_0 = 3.614e-4;
-    const double R_e = 6378.1363;
-    const double r_0 = 7.0e2+R_e;
-    const double H = 88.667;
-//    const double A = 3e-6;
-//    const double omega = 2*M_PI/86164;
-//    double rho = rho_0*exp(-(r-r_0)/H);
-//    double J2 = 1.082626925638815e-3;
-//    double C_D = 2;
-    const double omega_E = 2*M_PI/86164;
-//    double x = y[3];
-//    double y = y[4];
-//    double z = y[5];
-    double u = y[6];
-    double v = y[7];
-    double w = y[8];
-//    double v_rel = sqrt((u+omega_E*y[4])*(u+omega_E*y[4])+(v-omega_E*y[3])*(v-omega_E*y[3])+w*w);
+    Dynamics(t, y.data(), f.data());
+}
+
+template <class T>
+void TwoBodySolver::Dynamics(const T&, const T* y, T* f) const
+{
+    T dx = y[3]-y[0];
+    T dy = y[4]-y[1];
+    T dz = y[5]-y[2];
+    T r = sqrt(dx*dx + dy*dy + dz*dz);
+    T r3 = r*r*r;
 
     f[0] = y[6];
     f[1] = y[7];
@@ -128,18 +120,18 @@ void TwoBodySolver::RightHandSide(double t, const std::vector<double> &y, std::v
     f[3] = y[9];
     f[4] = y[10];
     f[5] = y[11];
-    f[6] = G*m2*(y[3]-y[0])/pow(r,3);
-    f[7] = G*m2*(y[4]-y[1])/pow(r,3);
-    f[8] = G*m2*(y[5]-y[2])/pow(r,3);
-    f[9] = -G*m1*(y[3]-y[0])/pow(r,3);// - G*m1*J2*R_e*R_e*y[3]*(1.5/(pow(r,5))-7.5*y[5]/pow(r,7))
-          //  -0.5*rho*C_D*A*v_rel*(u + omega_E*y[4])/970;
-    f[10] = -G*m1*(y[4]-y[1])/pow(r,3);// - G*m1*J2*R_e*R_e*y[4]*(1.5/(pow(r,5))-7.5*y[5]/pow(r,7))
-            //-0.5*rho*C_D*A*v_rel*(v - omega_E*y[3])/970;
-    f[11] = -G*m1*(y[5]-y[2])/pow(r,3);// - G*m1*J2*R_e*R_e*y[5]*(1.5/(pow(r,5))-7.5*y[5]/pow(r,7))
-           // -0.5*rho*C_D*A*v_rel*w/970;
+    f[6] = G*m2*dx/r3;
+    f[7] = G*m2*dy/r3;
+    f[8] = G*m2*dz/r3;
+    f[9] = -G*m1*dx/r3;
+    f[10] = -G*m1*dy/r3;
+    f[11] = -G*m1*dz/r3;
 }
 
-QVector3D TwoBodySolver::position()
+template void TwoBodySolver::Dynamics(const double&, const double*, double*) const;
+template void TwoBodySolver::Dynamics(const TaylorVariable&, const TaylorVariable*, TaylorVariable*) const;
+
+Vector3D TwoBodySolver::position()
 {
     double XG;
     double YG;
@@ -149,10 +141,10 @@ QVector3D TwoBodySolver::position()
     YG = state[4] - state[1]; //(m1*state[1][i] + m2*state[4][i])/(m1+m2);
     ZG = state[5] - state[2]; // (m1*state[2][i] + m2*state[5][i])/(m1+m2);
 
-    return QVector3D(XG, YG, ZG);
+    return Vector3D(XG, YG, ZG);
 }
 
-QVector3D TwoBodySolver::velocity()
+Vector3D TwoBodySolver::velocity()
 {
     double U;
     double V;
@@ -162,15 +154,15 @@ QVector3D TwoBodySolver::velocity()
     V = state[10] - state[7];
     W = state[11] - state[8];
 
-    return QVector3D(U, V, W);
+    return Vector3D(U, V, W);
 }
 
 double TwoBodySolver::eccentricity()
 {
-//    QVector3D pos = position();
-//    QVector3D vel = velocity();
-//    QVector3D h_vec = QVector3D::crossProduct(pos,vel);
-//    QVector3D C = QVector3D::crossProduct(vel,h_vec) - mu*pos/pos.length();
+//    Vector3D pos = position();
+//    Vector3D vel = velocity();
+//    Vector3D h_vec = Vector3D::crossProduct(pos,vel);
+//    Vector3D C = Vector3D::crossProduct(vel,h_vec) - mu*pos/pos.length();
 //    double e = C.length()/mu;
     return omt.e;
 }
@@ -3,11 +3,10 @@
 
 #include "RungeKuttaSolver.hpp"
 
-#include "Common/Output.hpp"
 #include "Orbital/Omt.hpp"
 #include "Eigen/Dense"
 
-#include <QVector3D>
+#include "Vector3D.hpp"
 
 using namespace std;
 
@@ -20,9 +19,12 @@ public:
     void InitialConditions();
     void InitialConditions(Eigen::Vector3d r, Eigen::Vector3d v);
     void RightHandSide(double t, const std::vector<double> &  y, std::vector<double> &  f);
+    // right hand side on any scalar type, double or TaylorVariable for TaylorSolver
+    template <class T>
+    void Dynamics(const T& t, const T* y, T* f) const;
     // outputs from the simulation
-    QVector3D position();
-    QVector3D velocity();
+    Vector3D position();
+    Vector3D velocity();
     double eccentricity();
 };
 
@@ -0,0 +1,69 @@
+#ifndef VECTOR3D_H
+#define VECTOR3D_H
+
+/* Vector type of the position()/velocity() outputs of the solvers and of the
+ * Omt routines that take vectors.  The GUI build uses QVector3D.  The headless
+ * core (DEFINES += HEADLESS in Core.pro and Batch.pro) does not depend on Qt
+ * and gets a stand-in with the part of the QVector3D interface the core uses,
+ * stored in double precision.
+ */
+#ifndef HEADLESS
+
+#include <QVector3D>
+typedef QVector3D Vector3D;
+
+#else
+
+#include <cmath>
+
+class Vector3D
+{
+public:
+    Vector3D() : x_(0), y_(0), z_(0) {}
+    Vector3D(double x, double y, double z) : x_(x), y_(y), z_(z) {}
+
+    double x() const { return x_; }
+    double y() const { return y_; }
+    double z() const { return z_; }
+    void setX(double x) { x_ = x; }
+    void setY(double y) { y_ = y; }
+    void setZ(double z) { z_ = z; }
+
+    double lengthSquared() const { return x_*x_ + y_*y_ + z_*z_; }
+    double length() const { return sqrt(lengthSquared()); }
+    Vector3D normalized() const
+    {
+        double l = length();
+        return l > 0 ? Vector3D(x_/l, y_/l, z_/l) : Vector3D();
+    }
+
+    static double dotProduct(const Vector3D& a, const Vector3D& b)
+    {
+        return a.x_*b.x_ + a.y_*b.y_ + a.z_*b.z_;
+    }
+    static Vector3D crossProduct(const Vector3D& a, const Vector3D& b)
+    {
+        return Vector3D(a.y_*b.z_ - a.z_*b.y_, a.z_*b.x_ - a.x_*b.z_, a.x_*b.y_ - a.y_*b.x_);
+    }
+
+    Vector3D& operator+=(const Vector3D& b) { x_ += b.x_; y_ += b.y_; z_ += b.z_; return *this; }
+    Vector3D& operator-=(const Vector3D& b) { x_ -= b.x_; y_ -= b.y_; z_ -= b.z_; return *this; }
+    Vector3D& operator*=(double s) { x_ *= s; y_ *= s; z_ *= s; return *this; }
+    Vector3D& operator/=(double s) { x_ /= s; y_ /= s; z_ /= s; return *this; }
+
+private:
+    double x_;
+    double y_;
+    double z_;
+};
+
+inline Vector3D operator+(Vector3D a, const Vector3D& b) { return a += b; }
+inline Vector3D operator-(Vector3D a, const Vector3D& b) { return a -= b; }
+inline Vector3D operator-(const Vector3D& a) { return Vector3D(-a.x(), -a.y(), -a.z()); }
+inline Vector3D operator*(Vector3D a, double s) { return a *= s; }
+inline Vector3D operator*(double s, Vector3D a) { return a *= s; }
+inline Vector3D operator/(Vector3D a, double s) { return a /= s; }
+
+#endif // HEADLESS
+
+#endif // VECTOR3D_H
@@ -0,0 +1,283 @@
+#include "LowThrustTransfer.hpp"
+#include "Nums/DirectCollocation.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+LowThrustTransfer::LowThrustTransfer(double mu, double r0, double rf, double accel, double mass_flow)
+    : mu_(mu), r0_(r0), rf_(rf), accel_(accel), mass_flow_(mass_flow), y_(9), f_(9)
+{
+}
+
+void LowThrustTransfer::SetPerturbations(double J2, double C_D)
+{
+    J2_ = J2;
+    C_D_ = C_D;
+}
+
+void LowThrustTransfer::SetNodes(int num_nodes)
+{
+    num_nodes_ = num_nodes;
+}
+
+void LowThrustTransfer::SetTolerance(double tol)
+{
+    tol_ = tol;
+}
+
+int LowThrustTransfer::num_states() const
+{
+    return 7;
+}
+
+int LowThrustTransfer::num_controls() const
+{
+    return 3;
+}
+
+int LowThrustTransfer::num_boundary() const
+{
+    return 12;
+}
+
+int LowThrustTransfer::num_path() const
+{
+    return 1;
+}
+
+void LowThrustTransfer::SetState(const Eigen::VectorXd& x)
+{
+    for (int i=0; i<6; i++)
+    {
+        y_[i] = x(i);
+    }
+    y_[6] = mu_;
+    y_[7] = J2_;
+    y_[8] = C_D_;
+}
+
+void LowThrustTransfer::Dynamics(const Eigen::VectorXd& x, const Eigen::VectorXd& u, Eigen::VectorXd& f)
+{
+    SetState(x);
+    satellite_.RightHandSide(0, y_, f_);
+    f.resize(7);
+    for (int i=0; i<6; i++)
+    {
+        f(i) = f_[i];
+    }
+    f.segment(3, 3) += u;
+    f(6) = -mass_flow_;
+}
+
+void LowThrustTransfer::DynamicsJacobian(const Eigen::VectorXd& x, const Eigen::VectorXd&,
+                                         Eigen::MatrixXd& f_x, Eigen::MatrixXd& f_u)
+{
+    SetState(x);
+    satellite_.Jacobian(0, y_, jacobian_);
+    f_x = Eigen::MatrixXd::Zero(7, 7);
+    f_x.topLeftCorner(6, 6) = jacobian_.topLeftCorner(6, 6);
+    f_u = Eigen::MatrixXd::Zero(7, 3);
+    f_u.block(3, 0, 3, 3).setIdentity();
+}
+
+void LowThrustTransfer::Boundary(const Eigen::VectorXd& x0, const Eigen::VectorXd& xf, double,
+                                 Eigen::VectorXd& psi)
+{
+    const double v0 = sqrt(mu_/r0_);
+    const double vf = sqrt(mu_/rf_);
+    Eigen::Vector3d r = xf.segment(0, 3);
+    Eigen::Vector3d v = xf.segment(3, 3);
+    psi.resize(12);
+    psi << x0(0)/r0_ - 1,
+           x0(1)/r0_,
+           x0(2)/r0_,
+           x0(3)/v0,
+           x0(4)/v0 - 1,
+           x0(5)/v0,
+           x0(6) - 1,
+           r.squaredNorm()/(rf_*rf_) - 1,
+           r.dot(v)/(rf_*vf),
+           v.squaredNorm()/(vf*vf) - 1,
+           r(2)/rf_,
+           v(2)/vf;
+}
+
+void LowThrustTransfer::BoundaryJacobian(const Eigen::VectorXd&, const Eigen::VectorXd& xf, double,
+                                         Eigen::MatrixXd& psi_x0, Eigen::MatrixXd& psi_xf, Eigen::VectorXd& psi_tf)
+{
+    const double v0 = sqrt(mu_/r0_);
+    const double vf = sqrt(mu_/rf_);
+    Eigen::Vector3d r = xf.segment(0, 3);
+    Eigen::Vector3d v = xf.segment(3, 3);
+    psi_x0 = Eigen::MatrixXd::Zero(12, 7);
+    psi_x0.block(0, 0, 3, 3).diagonal().setConstant(1/r0_);
+    psi_x0.block(3, 3, 3, 3).diagonal().setConstant(1/v0);
+    psi_x0(6, 6) = 1;
+    psi_xf = Eigen::MatrixXd::Zero(12, 7);
+    psi_xf.block(7, 0, 1, 3) = 2*r.transpose()/(rf_*rf_);
+    psi_xf.block(8, 0, 1, 3) = v.transpose()/(rf_*vf);
+    psi_xf.block(8, 3, 1, 3) = r.transpose()/(rf_*vf);
+    psi_xf.block(9, 3, 1, 3) = 2*v.transpose()/(vf*vf);
+    psi_xf(10, 2) = 1/rf_;
+    psi_xf(11, 5) = 1/vf;
+    psi_tf = Eigen::VectorXd::Zero(12);
+}
+
+void LowThrustTransfer::Path(const Eigen::VectorXd& x, const Eigen::VectorXd& u, Eigen::VectorXd& g)
+{
+    g.resize(1);
+    g(0) = x(6)*x(6)*u.squaredNorm()/(accel_*accel_) - 1;
+}
+
+void LowThrustTransfer::PathJacobian(const Eigen::VectorXd& x, const Eigen::VectorXd& u,
+                                     Eigen::MatrixXd& g_x, Eigen::MatrixXd& g_u)
+{
+    g_x = Eigen::MatrixXd::Zero(1, 7);
+    g_x(0, 6) = 2*x(6)*u.squaredNorm()/(accel_*accel_);
+    g_u = 2*x(6)*x(6)*u.transpose()/(accel_*accel_);
+}
+
+double LowThrustTransfer::Cost(const Eigen::VectorXd&, double tf)
+{
+    return tf*sqrt(mu_/(r0_*r0_*r0_));
+}
+
+void LowThrustTransfer::CostGradient(const Eigen::VectorXd&, double, Eigen::VectorXd& phi_x, double& phi_tf)
+{
+    phi_x = Eigen::VectorXd::Zero(7);
+    phi_tf = sqrt(mu_/(r0_*r0_*r0_));
+}
+
+int LowThrustTransfer::Guess(int& num_nodes, double& tf, Eigen::MatrixXd& states, Eigen::MatrixXd& controls)
+{
+    // RK4 with the thrust along the velocity
+    const Eigen::VectorXd zero = Eigen::VectorXd::Zero(3);
+    auto rhs = [this, &zero](const Eigen::VectorXd& x)
+    {
+        Eigen::VectorXd f;
+        Dynamics(x, zero, f);
+        Eigen::Vector3d v = x.segment(3, 3);
+        f.segment(3, 3) += GUESS_THROTTLE*accel_/x(6)*v/v.norm();
+        return f;
+    };
+    auto step = [&rhs](double h, Eigen::VectorXd& x)
+    {
+        Eigen::VectorXd k1 = rhs(x);
+        Eigen::VectorXd k2 = rhs(x+0.5*h*k1);
+        Eigen::VectorXd k3 = rhs(x+0.5*h*k2);
+        Eigen::VectorXd k4 = rhs(x+h*k3);
+        x += h*(k1+2*k2+2*k3+k4)/6;
+    };
+    Eigen::VectorXd x0(7);
+    x0 << r0_, 0, 0, 0, sqrt(mu_/r0_), 0, 1;
+
+    // time and revolutions to reach the final radius, then the nodes on a second pass
+    const double h = 0.01*sqrt(r0_*r0_*r0_/mu_);
+    const double t_max = mass_flow_ > 0 ? 0.99/mass_flow_ : 1e6*h;
+    Eigen::VectorXd x = x0;
+    double t = 0;
+    double angle = 0;
+    while (x.segment(0, 3).norm() < rf_)
+    {
+        if (t > t_max || !x.allFinite())
+        {
+            return 1;
+        }
+        double theta = atan2(x(1), x(0));
+        step(h, x);
+        angle += remainder(atan2(x(1), x(0)) - theta, 2*M_PI);
+        t += h;
+    }
+    tf = t;
+    if (num_nodes <= 0)
+    {
+        num_nodes = std::max(MIN_NODES, static_cast<int>(NODES_PER_REVOLUTION*angle/(2*M_PI)));
+    }
+
+    const int substeps = std::max(1, static_cast<int>(std::ceil(tf/(num_nodes-1)/h)));
+    const double dt = tf/((num_nodes-1)*substeps);
+    states.resize(num_nodes, 7);
+    controls.resize(num_nodes, 3);
+    x = x0;
+    for (int i=0; i<num_nodes; i++)
+    {
+        Eigen::Vector3d v = x.segment(3, 3);
+        states.row(i) = x.transpose();
+        controls.row(i) = GUESS_THROTTLE*accel_/x(6)*v.transpose()/v.norm();
+        for (int k=0; k<substeps && i<num_nodes-1; k++)
+        {
+            step(dt, x);
+        }
+    }
+    return 0;
+}
+
+int LowThrustTransfer::Solve()
+{
+    int num_nodes = num_nodes_;
+    double tf;
+    Eigen::MatrixXd states, controls;
+    if (Guess(num_nodes, tf, states, controls))
+    {
+        return 1;
+    }
+
+    DirectCollocation collocation(this, num_nodes);
+    Eigen::VectorXd x_scale(7), u_scale(3);
+    double v0 = sqrt(mu_/r0_);
+    x_scale << r0_, r0_, r0_, v0, v0, v0, 1;
+    u_scale.setConstant(accel_);
+    collocation.SetScaling(x_scale, u_scale, tf);
+    collocation.SetFinalTime(tf);
+    collocation.SetTolerance(tol_);
+    collocation.SetInitialGuess(states, controls);
+    int status = collocation.Solve();
+    iterations_ = collocation.iterations();
+    if (status)
+    {
+        return 1;
+    }
+
+    transfer_time_ = collocation.final_time();
+    Eigen::VectorXd t = collocation.mesh();
+    states = collocation.states();
+    controls = collocation.controls();
+    trajectory_.resize(num_nodes, 5);
+    sweep_angle_ = 0;
+    for (int i=0; i<num_nodes; i++)
+    {
+        Eigen::Vector3d r = states.row(i).segment(0, 3).transpose();
+        Eigen::Vector3d v = states.row(i).segment(3, 3).transpose();
+        Eigen::Vector3d u = controls.row(i).transpose();
+        // radial and tangential directions in the orbit plane
+        Eigen::Vector3d e_r = r.normalized();
+        Eigen::Vector3d e_t = r.cross(v).cross(r).normalized();
+        trajectory_.row(i) << t(i), r.norm(), v.dot(e_r), v.dot(e_t), atan2(u.dot(e_r), u.dot(e_t));
+        if (i > 0)
+        {
+            Eigen::Vector3d rp = states.row(i-1).segment(0, 3).transpose();
+            sweep_angle_ += atan2(rp.cross(r).norm(), rp.dot(r));
+        }
+    }
+    return 0;
+}
+
+double LowThrustTransfer::transfer_time() const
+{
+    return transfer_time_;
+}
+
+double LowThrustTransfer::sweep_angle() const
+{
+    return sweep_angle_;
+}
+
+int LowThrustTransfer::iterations() const
+{
+    return iterations_;
+}
+
+Eigen::MatrixXd LowThrustTransfer::trajectory() const
+{
+    return trajectory_;
+}
@@ -0,0 +1,104 @@
+#ifndef LOWTHRUSTTRANSFER_H
+#define LOWTHRUSTTRANSFER_H
+
+#include <vector>
+#include "Eigen/Dense"
+#include "Nums/OptimalControlProblem.hpp"
+#include "Nums/SatelliteSolver.hpp"
+
+/* Minimum time transfer between circular orbits with a bounded thrust,
+ * solved directly: the SatelliteSolver dynamics (point mass, J2 and drag,
+ * both off by default) plus the thrust acceleration u are transcribed by
+ * DirectCollocation, so no costates have to be guessed.  The state is the
+ * position and velocity [km, km/s] and the mass fraction m, the thrust
+ * acceleration is bounded by
+ *   m^2 |u|^2 <= a_0^2
+ * and m' = -mass_flow.  The transfer starts on the x axis of the equatorial
+ * plane and ends on the circular (two body) orbit of radius rf in that plane,
+ * the boundary conditions being normalized by the radius and the circular
+ * velocity.
+ *
+ * The initial guess is the spiral of MinimumTimeTransfer under tangential
+ * thrust up to the final radius, flown at GUESS_THROTTLE of the thrust so that
+ * the guess is interior and its defects vanish; no costates are guessed.  The
+ * cost is the transfer time in units of the initial orbit, 1/(mean motion),
+ * to keep the multipliers of order one.  Beyond a few revolutions the final
+ * time shifts the phase of every revolution and the interior point iterations
+ * grow quickly; the indirect MinimumTimeTransfer is then the faster route.
+ */
+class LowThrustTransfer : public OptimalControlProblem
+{
+private:
+    double mu_;
+    double r0_;
+    double rf_;
+    double accel_;
+    double mass_flow_;
+    double J2_ = 0;
+    double C_D_ = 0;
+    int num_nodes_ = 0;
+    double tol_ = 1e-8;
+
+    SatelliteSolver satellite_;
+    // state of SatelliteSolver [pos, vel, mu, J2, C_D] and its derivative
+    std::vector<double> y_;
+    std::vector<double> f_;
+    Eigen::MatrixXd jacobian_;
+
+    double transfer_time_ = 0;
+    double sweep_angle_ = 0;
+    int iterations_ = 0;
+    Eigen::MatrixXd trajectory_;
+
+    static constexpr double GUESS_THROTTLE = 0.9;
+    static const int NODES_PER_REVOLUTION = 40;
+    static const int MIN_NODES = 50;
+
+    // node states and controls of the tangential thrust spiral, returns 1 if
+    // it does not reach the final radius
+    int Guess(int& num_nodes, double& tf, Eigen::MatrixXd& states, Eigen::MatrixXd& controls);
+    void SetState(const Eigen::VectorXd& x);
+public:
+    // gravitational parameter [km^3/s^2], radii [km], initial thrust
+    // acceleration [km/s^2] and mass flow as fraction of the initial mass per second
+    LowThrustTransfer(double mu, double r0, double rf, double accel, double mass_flow = 0);
+
+    // J2 and drag coefficient of the SatelliteSolver dynamics
+    void SetPerturbations(double J2, double C_D);
+    // number of collocation nodes, by default chosen from the revolutions of the guess
+    void SetNodes(int num_nodes);
+    void SetTolerance(double tol);
+
+    // returns 0 if the optimality conditions hold within the tolerance and 1 otherwise
+    int Solve();
+
+    // [s]
+    double transfer_time() const;
+    // polar angle travelled [rad]
+    double sweep_angle() const;
+    // interior point iterations of the last Solve
+    int iterations() const;
+    // one row per node: time [s], r [km], u, v [km/s] and thrust angle from
+    // the local horizontal [rad], as MinimumTimeTransfer
+    Eigen::MatrixXd trajectory() const;
+
+    // OptimalControlProblem
+    int num_states() const;
+    int num_controls() const;
+    int num_boundary() const;
+    int num_path() const;
+    void Dynamics(const Eigen::VectorXd& x, const Eigen::VectorXd& u, Eigen::VectorXd& f);
+    void DynamicsJacobian(const Eigen::VectorXd& x, const Eigen::VectorXd& u,
+                          Eigen::MatrixXd& f_x, Eigen::MatrixXd& f_u);
+    void Boundary(const Eigen::VectorXd& x0, const Eigen::VectorXd& xf, double tf,
+                  Eigen::VectorXd& psi);
+    void BoundaryJacobian(const Eigen::VectorXd& x0, const Eigen::VectorXd& xf, double tf,
+                          Eigen::MatrixXd& psi_x0, Eigen::MatrixXd& psi_xf, Eigen::VectorXd& psi_tf);
+    void Path(const Eigen::VectorXd& x, const Eigen::VectorXd& u, Eigen::VectorXd& g);
+    void PathJacobian(const Eigen::VectorXd& x, const Eigen::VectorXd& u,
+                      Eigen::MatrixXd& g_x, Eigen::MatrixXd& g_u);
+    double Cost(const Eigen::VectorXd& xf, double tf);
+    void CostGradient(const Eigen::VectorXd& xf, double tf, Eigen::VectorXd& phi_x, double& phi_tf);
+};
+
+#endif // LOWTHRUSTTRANSFER_H
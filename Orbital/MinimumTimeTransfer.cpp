@@ -0,0 +1,319 @@
+#include "MinimumTimeTransfer.hpp"
+#include "Nums/BoundaryValueProblem.hpp"
+#include "Nums/Dual.hpp"
+#include "Nums/PseudoArclengthContinuation.hpp"
+
+#include <cmath>
+#include <iostream>
+
+// parameters of the transfer being solved, in scaled units
+static double accel = 0;
+static double mass_flow = 0;
+static double r_final = 1;
+
+static void SetThrust(double a)
+{
+    accel = a;
+}
+
+// thrust acceleration at scaled time tau and its derivative with respect to T
+static void Thrust(double tau, double T, double& a, double& a_T)
+{
+    double m = 1 - mass_flow*T*tau;
+    a = accel/m;
+    a_T = a*mass_flow*tau/m;
+}
+
+// T times the state and costate equations at y = [r, u, v, lr, lu, lv, T], with
+// S = double or Dual<7> for the Jacobian
+template <class S>
+static void Dynamics(double tau, const S* y, S* f)
+{
+    const S& r = y[0];
+    const S& u = y[1];
+    const S& v = y[2];
+    const S& lr = y[3];
+    const S& lu = y[4];
+    const S& lv = y[5];
+    const S& T = y[6];
+    // thrust acceleration of the mass at tau, as Thrust
+    S a = accel/(1 - mass_flow*tau*T);
+    S a_l = a/sqrt(lu*lu + lv*lv);
+    S u_r = u/r;
+    S v_r = v/r;
+    S inv_r2 = 1/(r*r);
+    f[0] = T*u;
+    f[1] = T*(v*v_r - inv_r2 - a_l*lu);
+    f[2] = T*(-u*v_r - a_l*lv);
+    f[3] = T*(lu*(v_r*v_r - 2*inv_r2/r) - lv*u_r*v_r);
+    f[4] = T*(lv*v_r - lr);
+    f[5] = T*(lv*u_r - 2*lu*v_r);
+    f[6] = 0;
+}
+
+static Eigen::VectorXd Rhs(double tau, const Eigen::VectorXd& y)
+{
+    Eigen::VectorXd f(7);
+    Dynamics(tau, y.data(), f.data());
+    return f;
+}
+
+// exact Jacobian of Rhs from one forward mode pass
+static Eigen::MatrixXd RhsGrad(double tau, const Eigen::VectorXd& y)
+{
+    Dual<7> s[7];
+    for (int i=0; i<7; i++)
+    {
+        s[i] = Dual<7>(y(i), i);
+    }
+    Dual<7> f[7];
+    Dynamics(tau, s, f);
+    Eigen::MatrixXd A(7, 7);
+    for (int i=0; i<7; i++)
+    {
+        A.row(i) = f[i].grad().transpose();
+    }
+    return A;
+}
+
+static Eigen::VectorXd Bcs(const Eigen::VectorXd& y0, const Eigen::VectorXd& y1)
+{
+    double r = y1(0), u = y1(1), v = y1(2), lr = y1(3), lu = y1(4), lv = y1(5), T = y1(6);
+    double a, a_T;
+    Thrust(1, T, a, a_T);
+    double l = sqrt(lu*lu + lv*lv);
+    Eigen::VectorXd g(7);
+    g << y0(0) - 1,
+         y0(1),
+         y0(2) - 1,
+         r - r_final,
+         u,
+         v - 1/sqrt(r_final),
+         1 + lr*u + lu*(v*v/r - 1/(r*r)) - lv*u*v/r - a*l;
+    return g;
+}
+
+static Eigen::MatrixXd BcsGrad1(const Eigen::VectorXd&, const Eigen::VectorXd&)
+{
+    Eigen::MatrixXd B = Eigen::MatrixXd::Zero(7, 7);
+    B(0,0) = 1;
+    B(1,1) = 1;
+    B(2,2) = 1;
+    return B;
+}
+
+static Eigen::MatrixXd BcsGrad2(const Eigen::VectorXd&, const Eigen::VectorXd& y1)
+{
+    double r = y1(0), u = y1(1), v = y1(2), lr = y1(3), lu = y1(4), lv = y1(5), T = y1(6);
+    double a, a_T;
+    Thrust(1, T, a, a_T);
+    double l = sqrt(lu*lu + lv*lv);
+    Eigen::MatrixXd B = Eigen::MatrixXd::Zero(7, 7);
+    B(3,0) = 1;
+    B(4,1) = 1;
+    B(5,2) = 1;
+    B(6,0) = lu*(-v*v/(r*r) + 2/(r*r*r)) + lv*u*v/(r*r);
+    B(6,1) = lr - lv*v/r;
+    B(6,2) = 2*lu*v/r - lv*u/r;
+    B(6,3) = u;
+    B(6,4) = v*v/r - 1/(r*r) - a*lu/l;
+    B(6,5) = -u*v/r - a*lv/l;
+    B(6,6) = -a_T*l;
+    return B;
+}
+
+MinimumTimeTransfer::MinimumTimeTransfer(double mu, double r0, double rf, double accel, double mass_flow)
+    : mu_(mu), r0_(r0), rf_(rf), accel_(accel), mass_flow_(mass_flow)
+{
+}
+
+void MinimumTimeTransfer::SetNodes(int num_nodes)
+{
+    num_nodes_ = num_nodes;
+}
+
+void MinimumTimeTransfer::SetTolerance(double tol)
+{
+    tol_ = tol;
+}
+
+void MinimumTimeTransfer::SetVerbose(bool verbose)
+{
+    verbose_ = verbose;
+}
+
+int MinimumTimeTransfer::Guess(int& num_nodes, Eigen::VectorXd& sol) const
+{
+    // RK4 on (r, u, v, theta) with the thrust along the velocity
+    auto rhs = [](double t, const Eigen::Vector4d& x)
+    {
+        double a, a_T;
+        Thrust(t, 1, a, a_T);
+        double speed = sqrt(x(1)*x(1) + x(2)*x(2));
+        Eigen::Vector4d f;
+        f << x(1),
+             x(2)*x(2)/x(0) - 1/(x(0)*x(0)) + a*x(1)/speed,
+             -x(1)*x(2)/x(0) + a*x(2)/speed,
+             x(2)/x(0);
+        return f;
+    };
+    auto step = [&rhs](double t, double h, Eigen::Vector4d& x)
+    {
+        Eigen::Vector4d k1 = rhs(t, x);
+        Eigen::Vector4d k2 = rhs(t+0.5*h, x+0.5*h*k1);
+        Eigen::Vector4d k3 = rhs(t+0.5*h, x+0.5*h*k2);
+        Eigen::Vector4d k4 = rhs(t+h, x+h*k3);
+        x += h*(k1+2*k2+2*k3+k4)/6;
+    };
+
+    // time to reach the final radius, then the nodes on a second pass
+    const double h = 0.01;
+    const double t_max = mass_flow > 0 ? 0.99/mass_flow : 1e6;
+    Eigen::Vector4d x(1, 0, 1, 0);
+    double t = 0;
+    while (x(0) < r_final)
+    {
+        if (t > t_max || !std::isfinite(x(0)))
+        {
+            return 1;
+        }
+        step(t, h, x);
+        t += h;
+    }
+    double T = t;
+    if (num_nodes <= 0)
+    {
+        num_nodes = std::max(MIN_NODES, static_cast<int>(NODES_PER_REVOLUTION*x(3)/(2*M_PI)));
+    }
+
+    const int substeps = std::max(1, static_cast<int>(std::ceil(T/(num_nodes-1)/h)));
+    const double dt = T/((num_nodes-1)*substeps);
+    sol.resize(7*num_nodes);
+    x << 1, 0, 1, 0;
+    t = 0;
+    for (int i=0; i<num_nodes; i++)
+    {
+        double a, a_T;
+        Thrust(t, 1, a, a_T);
+        double speed = sqrt(x(1)*x(1) + x(2)*x(2));
+        // tangential thrust, lr from lu' = 0 and the size of the costates from H = 0
+        double lu = -x(1)/speed;
+        double lv = -x(2)/speed;
+        double lr = lv*x(2)/x(0);
+        double h0 = lr*x(1) + lu*(x(2)*x(2)/x(0) - 1/(x(0)*x(0))) - lv*x(1)*x(2)/x(0) - a;
+        double l = -1/h0;
+        sol.segment(7*i, 7) << x(0), x(1), x(2), l*lr, l*lu, l*lv, T;
+        for (int k=0; k<substeps && i<num_nodes-1; k++)
+        {
+            step(t, dt, x);
+            t += dt;
+        }
+    }
+    return 0;
+}
+
+// Newton from the spiral fails for some thrust levels, the transfer is then
+// solved for nearby ones and followed in the thrust level back to the target.
+int MinimumTimeTransfer::Continue(BoundaryValueProblem& bvp, int num_nodes) const
+{
+    const double target = accel;
+    for (double factor : {1.25, 0.8, 1.5625, 0.64})
+    {
+        accel = target*factor;
+        Eigen::VectorXd sol;
+        int n = num_nodes;
+        if (Guess(n, sol))
+        {
+            continue;
+        }
+        bvp.SetInitialGuess(sol);
+        if (bvp.Solve())
+        {
+            continue;
+        }
+
+        double direction = factor > 1 ? -1 : 1;
+        PseudoArclengthContinuation continuation(&bvp, SetThrust);
+        continuation.SetStepSize(0.1, 1e-6, 1);
+        continuation.SetNewtonTolerance(tol_);
+        if (continuation.Start(accel, direction))
+        {
+            continue;
+        }
+        while ((target-continuation.parameter())*direction > 0 && continuation.Step() == 0)
+        {
+        }
+        SetThrust(target);
+        if (bvp.Solve() == 0)
+        {
+            return 0;
+        }
+    }
+    SetThrust(target);
+    return 1;
+}
+
+int MinimumTimeTransfer::Solve()
+{
+    const double r_unit = r0_;
+    const double t_unit = sqrt(r0_*r0_*r0_/mu_);
+    const double v_unit = r_unit/t_unit;
+    accel = accel_*t_unit/v_unit;
+    mass_flow = mass_flow_*t_unit;
+    r_final = rf_/r0_;
+
+    int num_nodes = num_nodes_;
+    Eigen::VectorXd sol;
+    if (Guess(num_nodes, sol))
+    {
+        if (verbose_)
+        {
+            std::cout << "Tangential thrust does not reach the final orbit" << std::endl;
+        }
+        return 1;
+    }
+
+    DifferentialSystem ode(Rhs, RhsGrad, Bcs, BcsGrad1, BcsGrad2, 0, 1);
+    BoundaryValueProblem bvp(&ode, num_nodes, 7);
+    bvp.SetScheme(BoundaryValueProblem::HERMITE_SIMPSON);
+    bvp.SetNewtonTolerance(tol_);
+    bvp.SetVerbose(verbose_);
+    bvp.SetInitialGuess(sol);
+    if (bvp.Solve() && Continue(bvp, num_nodes))
+    {
+        return 1;
+    }
+
+    sol = bvp.sol_vec();
+    double T = sol(6);
+    transfer_time_ = T*t_unit;
+    trajectory_.resize(num_nodes, 5);
+    sweep_angle_ = 0;
+    for (int i=0; i<num_nodes; i++)
+    {
+        Eigen::VectorXd y = sol.segment(7*i, 7);
+        trajectory_.row(i) << T*t_unit*i/(num_nodes-1), y(0)*r_unit, y(1)*v_unit, y(2)*v_unit, atan2(-y(4), -y(5));
+        if (i > 0)
+        {
+            // theta' = v/r by the trapezoidal rule
+            Eigen::VectorXd yp = sol.segment(7*(i-1), 7);
+            sweep_angle_ += 0.5*T/(num_nodes-1)*(y(2)/y(0) + yp(2)/yp(0));
+        }
+    }
+    return 0;
+}
+
+double MinimumTimeTransfer::transfer_time() const
+{
+    return transfer_time_;
+}
+
+double MinimumTimeTransfer::sweep_angle() const
+{
+    return sweep_angle_;
+}
+
+Eigen::MatrixXd MinimumTimeTransfer::trajectory() const
+{
+    return trajectory_;
+}
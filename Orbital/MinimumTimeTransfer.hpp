@@ -0,0 +1,79 @@
+#ifndef MINIMUMTIMETRANSFER_H
+#define MINIMUMTIMETRANSFER_H
+
+#include "Eigen/Dense"
+
+class BoundaryValueProblem;
+
+/* Minimum time planar transfer between circular orbits with a thrust of
+ * fixed magnitude and free direction (Bryson and Ho 1975, section 2.5),
+ * solved with the maximum principle as a two point boundary value problem.
+ *
+ * In units of the initial radius and the corresponding circular orbit the
+ * state is the radius r and the radial and tangential velocities u, v.  With
+ * costates lr, lu, lv the thrust points against (lu, lv) and
+ *   r'  = u
+ *   u'  = v^2/r - 1/r^2 + a sin(phi)
+ *   v'  = -u v/r + a cos(phi)
+ *   lr' = lu (v^2/r^2 - 2/r^3) - lv u v/r^2
+ *   lu' = -lr + lv v/r
+ *   lv' = -2 lu v/r + lv u/r
+ * with a = a_0/(1 - m t) for a mass flow m.  Time is scaled by the unknown
+ * transfer time T, carried as a seventh component with T' = 0, and the
+ * seventh boundary condition is H = 0 at the end (free final time).  The
+ * Jacobians are analytic.  The initial guess follows the spiral under
+ * tangential thrust up to the final radius, with costates that keep the thrust
+ * tangential and H = 0.  The boundary value problem is solved with
+ * Hermite-Simpson collocation and damped Newton.
+ *
+ * The system functions read the parameters of the transfer being solved, so
+ * only one transfer can be solved at a time.
+ */
+class MinimumTimeTransfer
+{
+private:
+    double mu_;
+    double r0_;
+    double rf_;
+    double accel_;
+    double mass_flow_;
+    int num_nodes_ = 0;
+    double tol_ = 1e-9;
+    bool verbose_ = false;
+
+    double transfer_time_ = 0;
+    double sweep_angle_ = 0;
+    Eigen::MatrixXd trajectory_;
+
+    static const int NODES_PER_REVOLUTION = 60;
+    static const int MIN_NODES = 100;
+
+    // node values of the tangential thrust spiral in scaled units, returns 1
+    // if it does not reach the final radius
+    int Guess(int& num_nodes, Eigen::VectorXd& sol) const;
+    // continuation in the thrust level from nearby ones, returns 1 if it failed
+    int Continue(BoundaryValueProblem& bvp, int num_nodes) const;
+public:
+    // gravitational parameter [km^3/s^2], radii [km], initial thrust
+    // acceleration [km/s^2] and mass flow as fraction of the initial mass per second
+    MinimumTimeTransfer(double mu, double r0, double rf, double accel, double mass_flow = 0);
+
+    // number of collocation nodes, by default chosen from the revolutions of the guess
+    void SetNodes(int num_nodes);
+    void SetTolerance(double tol);
+    // progress of the boundary value problem solver on std::cout, off by default
+    void SetVerbose(bool verbose);
+
+    // returns 0 if the boundary value problem was solved and 1 otherwise
+    int Solve();
+
+    // [s]
+    double transfer_time() const;
+    // polar angle travelled [rad]
+    double sweep_angle() const;
+    // one row per node: time [s], r [km], u, v [km/s] and thrust angle from
+    // the local horizontal [rad]
+    Eigen::MatrixXd trajectory() const;
+};
+
+#endif // MINIMUMTIMETRANSFER_H
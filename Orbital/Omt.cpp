@@ -1,8 +1,8 @@
 /* Orbital Mechanics Toolbox */
 #include "Omt.hpp"
-#include <QVector3D>
-#include <QMatrix3x3>
+#include "Nums/Vector3D.hpp"
 
+#include <algorithm>
 #include <cmath>
 #include <iostream>
 
@@ -34,19 +34,30 @@ std::pair<double, double> Omt::right_ascension_and_declination(Eigen::Vector3d&
 }
 
 /* Stumpff functions for use with universal variables */
+// below this |z| the closed forms lose digits to cancellation and the series is used
+const double STUMPFF_SERIES_Z = 0.1;
+
 double Omt::stumpffS(double z)
 {
+    if (std::abs(z) < STUMPFF_SERIES_Z)
+    {
+        // S(z) = sum (-z)^k/(2k+3)!
+        return (1.0/6.0)*(1 - z/20*(1 - z/42*(1 - z/72*(1 - z/110*(1 - z/156)))));
+    }
     double sq = sqrt(std::abs(z));
     if (z > 0) return (sq-sin(sq))/(sq*sq*sq);
-    if (z < 0) return (sinh(sq)-sq)/(sq*sq*sq);
-    return (1.0/6.0);
+    return (sinh(sq)-sq)/(sq*sq*sq);
 }
 
 double Omt::stumpffC(double z)
 {
+    if (std::abs(z) < STUMPFF_SERIES_Z)
+    {
+        // C(z) = sum (-z)^k/(2k+2)!
+        return 0.5*(1 - z/12*(1 - z/30*(1 - z/56*(1 - z/90*(1 - z/132)))));
+    }
     if (z > 0) return (1-cos(sqrt(z)))/z;
-    if (z < 0) return (cosh(sqrt(-z))-1)/(-z);
-    return 0.5;
+    return (cosh(sqrt(-z))-1)/(-z);
 }
 
 /* Returns the eccentric anomaly E from the eccentricity, e, and the mean anomaly M_e
@@ -118,10 +129,11 @@ int Omt::u_anom_kepler(double& chi, double& C, double& S, double&z,
         f = (r0*vr0/sqmu)*chisq*C + (1-alpha*r0)*chi*chisq*S + r0*chi - sqmu*dt;
         fprime = (r0*vr0/sqmu)*chi*(1-alpha*chisq*S) + (1-alpha*r0)*chisq*C + r0;
         rat = f/fprime;
+        chi = chi - rat;
         if (std::abs(rat) < ERR_TOL) {
+            // C, S and z belong to the last iterate, the correction is below the tolerance
             break;
         }
-        chi = chi - rat;
         // std::cout << f << ", " << fprime << ", " << rat << ", " << chi << std::endl;
     }
     if (iter == MAX_ITER) {
@@ -145,35 +157,101 @@ int Omt::u_anom_kepler(double& chi, double& C, double& S, double&z,
  * mu   - gravitational parameter (km^3/s^2)
  *
  */
-int Omt::state_transition(QVector3D& r, QVector3D& v, const double dt, const double mu)
+int Omt::state_transition(Vector3D& r, Vector3D& v, const double dt, const double mu)
+{
+    Eigen::Vector3d r2, v2;
+    r2 << r.x(), r.y(), r.z();
+    v2 << v.x(), v.y(), v.z();
+    int err = state_transition(r2, v2, dt, mu);
+    r = Vector3D(r2(0), r2(1), r2(2));
+    v = Vector3D(v2(0), v2(1), v2(2));
+    return err;
+}
+
+int Omt::state_transition(Eigen::Vector3d& r, Eigen::Vector3d& v, const double dt, const double mu)
 {
-    double r_scalar = r.length();
-    double v_scalar = v.length();
-    double v_r = QVector3D::dotProduct(r,v)/r_scalar;
+    double r_scalar = r.norm();
+    double v_scalar = v.norm();
+    double v_r = r.dot(v)/r_scalar;
     double chi, C, S, z;
     // double a = h*h/(mu*(1-e*e));
     // from energy equation:  vel*vel/2 - mu/r_scalar = -mu/2a, reciprocal of semimajor axis is
     double alpha = 2/r_scalar - v_scalar*v_scalar/mu;
-    u_anom_kepler(chi, C, S, z, dt, r_scalar, v_r, alpha, mu);
+    int err = u_anom_kepler(chi, C, S, z, dt, r_scalar, v_r, alpha, mu);
+    // Stumpff functions at the converged anomaly
     double chisq = chi*chi;
     double chicube = chisq*chi;
+    z = alpha*chisq;
+    C = stumpffC(z);
+    S = stumpffS(z);
     // Lagrange coefficients
     double sqmu = sqrt(mu);
     double f = 1 - (chisq/r_scalar) * C;
     double g = dt - (1/sqmu)*chicube * S;
-    QVector3D r1 = f*r + g*v;
-    double r1_scalar = r1.length();
+    Eigen::Vector3d r1 = f*r + g*v;
+    double r1_scalar = r1.norm();
     double fprime = sqmu/(r_scalar*r1_scalar)*(alpha*chicube*S-chi);
     double gprime = 1 - chisq*C/r1_scalar;
     v = fprime*r + gprime*v;
     r = r1;
-    return 0;
+    return err;
+}
+
+/* Returns the state after time dt on the Kepler orbit whose node, argument of
+ * perigee and mean anomaly drift with the secular J2 rates (Vallado 9.41)
+ *   dOmega/dt = -3/2 n J2 (R_e/p)^2 cos i
+ *   domega/dt =  3/4 n J2 (R_e/p)^2 (5 cos^2 i - 1)
+ *   dM/dt - n =  3/4 n J2 (R_e/p)^2 sqrt(1 - e^2) (3 cos^2 i - 1)
+ * with n and p of the mean semimajor axis, which differs from the osculating
+ * one by the short periodic term (Kozai 1959)
+ *   a - a_mean = J2 R_e^2/a ((1 - 3/2 sin^2 i)((a/r)^3 - (1 - e^2)^(-3/2))
+ *                            + 3/2 sin^2 i (a/r)^3 cos 2u)
+ * and sets the along track drift.  The faster mean motion is a longer Kepler
+ * transition, the perigee and node drifts are rotations of the final state
+ * about the orbit normal and the z axis.  The other short periodic terms are
+ * missing (about 20 km in LEO), so this is a cheap predictor only.
+ *
+ * Error codes as state_transition.
+ */
+int Omt::j2_secular_transition(Eigen::Vector3d& r, Eigen::Vector3d& v, const double dt, const double mu,
+                               const double J_2, const double R_e)
+{
+    Eigen::Vector3d h_vec = r.cross(v);
+    double h2 = h_vec.squaredNorm();
+    double r_scalar = r.norm();
+    double alpha = 2/r_scalar - v.squaredNorm()/mu;
+    double a = 1/alpha;
+    double e2 = std::max(0.0, 1 - h2*alpha/mu);
+    double cos_i = h_vec(2)/sqrt(h2);
+    double sin2_i = 1 - cos_i*cos_i;
+
+    // argument of latitude from the node line
+    Eigen::Vector3d N = Eigen::Vector3d::UnitZ().cross(h_vec);
+    double u = atan2(r.dot(h_vec.cross(N))/sqrt(h2), r.dot(N));
+    double ar3 = pow(a/r_scalar, 3);
+    double a_mean = a - J_2*R_e*R_e/a*((1 - 1.5*sin2_i)*(ar3 - pow(1 - e2, -1.5))
+                                       + 1.5*sin2_i*ar3*cos(2*u));
+    double n = sqrt(mu/(a_mean*a_mean*a_mean));
+    double p = a_mean*(1 - e2);
+    double k = n*J_2*(R_e/p)*(R_e/p);
+
+    double dOmega = -1.5*k*cos_i*dt;
+    double domega = 0.75*k*(5*cos_i*cos_i - 1)*dt;
+    double dM = 0.75*k*sqrt(1 - e2)*(3*cos_i*cos_i - 1)*dt;
+
+    // the Kepler transition runs with the osculating mean motion
+    int err = state_transition(r, v, (n*dt + dM)*a*sqrt(a/mu), mu);
+    Eigen::Matrix3d rot = (Eigen::AngleAxisd(dOmega, Eigen::Vector3d::UnitZ())
+                           *Eigen::AngleAxisd(domega, h_vec/sqrt(h2))).toRotationMatrix();
+    r = rot*r;
+    v = rot*v;
+    return err;
 }
 
 /* Generates orbital parameters from the state vector given by the position, r, and
  * the velocity, v.
  */
-int Omt::orbit_desc(const QVector3D& r, const QVector3D& v, const double mu)
+int Omt::orbit_desc(const Vector3D& r, const Vector3D& v, const double mu)
 {
     Eigen::Vector3d r2, v2;
     r2 << r.x(), r.y(), r.z();
@@ -212,7 +290,7 @@ int Omt::orbit_desc(const Eigen::Vector3d& r, const Eigen::Vector3d& v, const do
         omega = 2*M_PI - omega;
     }
     // true anomality
-//    theta = acos(QVector3D::dotProduct(e_vec/e, r/r_scalar));
+//    theta = acos(Vector3D::dotProduct(e_vec/e, r/r_scalar));
 //    if (v_r < 0) {
 //        theta = 2*M_PI - theta;
 //    }
@@ -224,40 +302,40 @@ int Omt::orbit_desc(const Eigen::Vector3d& r, const Eigen::Vector3d& v, const do
 /* Generates orbital parameters from three position vectors, r1, r2, and r1 using
  * Gibbs method.
  */
-int Omt::orbit_desc(const QVector3D& r1, const QVector3D& r2, const QVector3D& r3, const double mu)
+int Omt::orbit_desc(const Vector3D& r1, const Vector3D& r2, const Vector3D& r3, const double mu)
 {
     this->mu = mu;
     Eigen::Vector3d r,v;
     Omt::orbit_desc(r,v,r1,r2,r3,mu);
-    orbit_desc(QVector3D(r(0),r(1),r(2)), QVector3D(v(0),v(1),v(2)), mu);
+    orbit_desc(Vector3D(r(0),r(1),r(2)), Vector3D(v(0),v(1),v(2)), mu);
     return 0;
 }
 
-int Omt::orbit_desc(Eigen::Vector3d& r, Eigen::Vector3d& v, const QVector3D& r1, const QVector3D& r2, const QVector3D &r3, const double mu)
+int Omt::orbit_desc(Eigen::Vector3d& r, Eigen::Vector3d& v, const Vector3D& r1, const Vector3D& r2, const Vector3D &r3, const double mu)
 {
     double r1_norm = r1.length();
     double r2_norm = r2.length();
     double r3_norm = r3.length();
-    QVector3D C12 = QVector3D::crossProduct(r1, r2);
-    QVector3D C23 = QVector3D::crossProduct(r2, r3);
-    QVector3D C31 = QVector3D::crossProduct(r3, r1);
-    QVector3D N = r1_norm*C23+r2_norm*C31+r3_norm*C12;
-    QVector3D D = C12 + C23 + C31;
-    QVector3D S = (r2_norm-r3_norm)*r1+(r3_norm-r1_norm)*r2+(r1_norm-r2_norm)*r3;
-    QVector3D v2 = sqrt(mu/(N.length()*D.length()))*(QVector3D::crossProduct(D,r2)/r2_norm+S);
+    Vector3D C12 = Vector3D::crossProduct(r1, r2);
+    Vector3D C23 = Vector3D::crossProduct(r2, r3);
+    Vector3D C31 = Vector3D::crossProduct(r3, r1);
+    Vector3D N = r1_norm*C23+r2_norm*C31+r3_norm*C12;
+    Vector3D D = C12 + C23 + C31;
+    Vector3D S = (r2_norm-r3_norm)*r1+(r3_norm-r1_norm)*r2+(r1_norm-r2_norm)*r3;
+    Vector3D v2 = sqrt(mu/(N.length()*D.length()))*(Vector3D::crossProduct(D,r2)/r2_norm+S);
     v << v2.x(), v2.y(), v2.z();
     r << r2.x(), r2.y(), r2.z();
 
     return 0;
 }
 
-int Omt::orbit_desc(Eigen::Vector3d& r, Eigen::Vector3d& v, const QVector3D& r1,
-                    const QVector3D& r2, double dt, bool prograde, const double mu)
+int Omt::orbit_desc(Eigen::Vector3d& r, Eigen::Vector3d& v, const Vector3D& r1,
+                    const Vector3D& r2, double dt, bool prograde, const double mu)
 {
     double r1_norm = r1.length();
     double r2_norm = r2.length();
-    QVector3D C12 = QVector3D::crossProduct(r1, r2);
-    double D12 = QVector3D::dotProduct(r1, r2);
+    Vector3D C12 = Vector3D::crossProduct(r1, r2);
+    double D12 = Vector3D::dotProduct(r1, r2);
     double P12 = r1_norm*r2_norm;
     double invcos = acos(D12/P12);
     double dtheta;
@@ -320,8 +398,8 @@ int Omt::orbit_desc(Eigen::Vector3d& r, Eigen::Vector3d& v, const QVector3D& r1,
     double lg = A*sqrt(y/mu);
     //double lfprime = (sqrt(mu)/P12)*sqrt(y/C)*(z*S-1);
     //double lgprime = 1 - y/r2_norm;
-    QVector3D v1 = (1/lg)*(r2-lf*r1);
-    // QVector3D v2 = lgprime*r2/lg-(lf*lgprime-lfprime*lg)*r1/lg;
+    Vector3D v1 = (1/lg)*(r2-lf*r1);
+    // Vector3D v2 = lgprime*r2/lg-(lf*lgprime-lfprime*lg)*r1/lg;
 
     v << v1.x(), v1.y(), v1.z();
     r << r1.x(), r1.y(), r1.z();
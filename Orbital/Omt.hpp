@@ -2,8 +2,7 @@
 #define OMT_H
 
 #include <tuple> // C++11, for std::tie
-#include <QVector3D>
-#include <QMatrix3x3>
+#include "Nums/Vector3D.hpp"
 #include "Eigen/Dense"
 
 using Eigen::MatrixXd;
@@ -31,15 +30,15 @@ public:
     double mu;
 
     // various methods to determine the orbit parameters based various inputs
-    int orbit_desc(const QVector3D& r, const QVector3D& v, const double mu);
+    int orbit_desc(const Vector3D& r, const Vector3D& v, const double mu);
     int orbit_desc(const Eigen::Vector3d &r, const Eigen::Vector3d &v, const double mu);
-    int orbit_desc(const QVector3D& r1, const QVector3D& r2, const QVector3D &r3, const double mu);
+    int orbit_desc(const Vector3D& r1, const Vector3D& r2, const Vector3D &r3, const double mu);
     int orbit_desc(const double h, const double e, const double i,
                    const double Omega, const double omega, const double mu);
     int orbit_desc_apog(const double r_p, const double r_a, const double i, const double Omega,
                    const double omega, const double mu);
-    static int orbit_desc(Eigen::Vector3d& r, Eigen::Vector3d& v, const QVector3D& r1, const QVector3D& r2, double dt, bool prograde, const double mu);
-    static int orbit_desc(Eigen::Vector3d& r, Eigen::Vector3d& v, const QVector3D& r1, const QVector3D& r2, const QVector3D &r3, const double mu);
+    static int orbit_desc(Eigen::Vector3d& r, Eigen::Vector3d& v, const Vector3D& r1, const Vector3D& r2, double dt, bool prograde, const double mu);
+    static int orbit_desc(Eigen::Vector3d& r, Eigen::Vector3d& v, const Vector3D& r1, const Vector3D& r2, const Vector3D &r3, const double mu);
 
     int secondary_params();
 
@@ -52,7 +51,11 @@ public:
     static int e_anom_kepler(double& E, const double e, const double M_e);
     static int u_anom_kepler(double& chi, double& C, double& S, double&z,
                              const double dt, const double r0, const double vr0, const double alpha, const double mu);
-    static int state_transition(QVector3D& r, QVector3D& v, const double dt, const double mu);
+    static int state_transition(Vector3D& r, Vector3D& v, const double dt, const double mu);
+    static int state_transition(Eigen::Vector3d& r, Eigen::Vector3d& v, const double dt, const double mu);
+    // Kepler orbit with the secular J2 drift of the node, perigee and mean anomaly
+    static int j2_secular_transition(Eigen::Vector3d& r, Eigen::Vector3d& v, const double dt, const double mu,
+                                     const double J_2, const double R_e);
     static double stumpffS(double z);
     static double stumpffC(double z);
     static int target_rel_state(Eigen::Vector3d &r_rel, Eigen::Vector3d &v_rel, Eigen::Vector3d &a_rel,
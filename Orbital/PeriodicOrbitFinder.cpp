@@ -0,0 +1,425 @@
+#include "PeriodicOrbitFinder.hpp"
+#include "Nums/RungeKuttaStepper.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+
+// step size controller parameters, as AdaptiveRungeKuttaSolver
+const double SAFETY = 0.9;
+const double MIN_FACTOR = 0.2;
+const double MAX_FACTOR = 10.0;
+const double ALPHA = 0.17;
+const double BETA = 0.04;
+// no orbit of interest takes longer for half a revolution
+const double MAX_HALF_PERIOD = 20;
+
+/* State of the CR3BP in D = 2 or 3 dimensions, [position, velocity], followed
+ * by its transition matrix (column major) and for the planar problem the 2x2
+ * transition matrix of the out of plane motion.
+ */
+template <int D>
+struct Variational
+{
+    static const int S = 2*D;
+    static const int N = S + S*S + (D == 2 ? 4 : 0);
+    typedef std::array<double, N> State;
+    typedef Eigen::Matrix<double, S, S> Matrix;
+    typedef Eigen::Matrix<double, D, D> Hessian;
+};
+
+// state and variational equations, A = [0 I; U_xx 2 Omega]
+template <int D>
+static void Derivatives(double mu, const typename Variational<D>::State& y, typename Variational<D>::State& f)
+{
+    typedef Variational<D> V;
+    const int S = V::S;
+    double d1[3] = {y[0] + mu, y[1], D == 3 ? y[2] : 0};
+    double d2[3] = {y[0] - 1 + mu, y[1], D == 3 ? y[2] : 0};
+    double r1_2 = d1[0]*d1[0] + d1[1]*d1[1] + d1[2]*d1[2];
+    double r2_2 = d2[0]*d2[0] + d2[1]*d2[1] + d2[2]*d2[2];
+    double k1 = (1 - mu)/(r1_2*sqrt(r1_2));
+    double k2 = mu/(r2_2*sqrt(r2_2));
+
+    for (int i=0; i<D; i++)
+    {
+        f[i] = y[D+i];
+        f[D+i] = -k1*d1[i] - k2*d2[i];
+    }
+    f[D] += 2*y[D+1] + y[0];
+    f[D+1] += -2*y[D] + y[1];
+
+    typename V::Hessian U;
+    for (int i=0; i<D; i++)
+    {
+        for (int j=0; j<=i; j++)
+        {
+            U(i, j) = 3*k1*d1[i]*d1[j]/r1_2 + 3*k2*d2[i]*d2[j]/r2_2;
+            U(j, i) = U(i, j);
+        }
+        U(i, i) += (i < 2 ? 1 : 0) - k1 - k2;
+    }
+    Eigen::Map<const typename V::Matrix> Phi(&y[S]);
+    Eigen::Map<typename V::Matrix> dPhi(&f[S]);
+    dPhi.template topRows<D>() = Phi.template bottomRows<D>();
+    dPhi.template bottomRows<D>().noalias() = U*Phi.template topRows<D>();
+    dPhi.row(D) += 2*Phi.row(D+1);
+    dPhi.row(D+1) -= 2*Phi.row(D);
+
+    if (D == 2)
+    {
+        // z'' = -(k1 + k2) z
+        Eigen::Map<const Eigen::Matrix2d> Z(&y[S+S*S]);
+        Eigen::Map<Eigen::Matrix2d> dZ(&f[S+S*S]);
+        dZ.row(0) = Z.row(1);
+        dZ.row(1) = -(k1 + k2)*Z.row(0);
+    }
+}
+
+/* Propagates the symmetric initial state x0 with the identity as transition
+ * matrix to the next crossing of y = 0, returns 1 if there is none within
+ * MAX_HALF_PERIOD.  y and f are the state and its derivative there.
+ */
+template <int D>
+static int HalfPeriod(double mu, double tol, const PeriodicOrbitFinder::Vector6d& x0,
+                      typename Variational<D>::State& y, typename Variational<D>::State& f,
+                      double& t, long& steps)
+{
+    typedef Variational<D> V;
+    const int S = V::S;
+    const int N = V::N;
+    y.fill(0.0);
+    for (int i=0; i<D; i++)
+    {
+        y[i] = x0(i);
+        y[D+i] = x0(3+i);
+    }
+    Eigen::Map<typename V::Matrix>(&y[S]).setIdentity();
+    if (D == 2)
+    {
+        Eigen::Map<Eigen::Matrix2d>(&y[S+S*S]).setIdentity();
+    }
+
+    FixedRungeKutta<N, DormandPrince54Tableau> stepper;
+    auto rhs = [mu](double, const typename V::State& w, typename V::State& fw) { Derivatives<D>(mu, w, fw); };
+    rhs(0, y, stepper.k(0));
+
+    // y leaves the plane in the direction of vy
+    const double side = x0(4) >= 0 ? 1 : -1;
+    typename V::State y_new, err;
+    double h = 1e-3;
+    double err_prev = 1e-4;
+    bool rejected = false;
+    t = 0;
+    while (t < MAX_HALF_PERIOD)
+    {
+        stepper.Advance(rhs, t, h, y, y_new);
+        stepper.ErrorEstimate(h, err);
+        double sum = 0;
+        for (int j=0; j<N; j++)
+        {
+            double ratio = err[j]/(tol + tol*std::max(std::abs(y[j]), std::abs(y_new[j])));
+            sum += ratio*ratio;
+        }
+        double norm = sqrt(sum/N);
+        if (!(norm <= 1))
+        {
+            if (!(norm < HUGE_VAL))
+            {
+                return 1;
+            }
+            h *= std::max(MIN_FACTOR, SAFETY*pow(norm, -0.2));
+            rejected = true;
+            continue;
+        }
+        steps++;
+
+        if (side*y_new[1] < 0)
+        {
+            // Newton on y over the step from the last node, which keeps its
+            // derivative in stage 0
+            double hc = h*y[1]/(y[1] - y_new[1]);
+            for (int i=0; i<10; i++)
+            {
+                stepper.Advance(rhs, t, hc, y, y_new);
+                double delta = -y_new[1]/y_new[D+1];
+                if (std::abs(delta) < 1e-15) break;
+                hc += delta;
+            }
+            y = y_new;
+            f = stepper.k(DormandPrince54Tableau::kStages-1);
+            t += hc;
+            return 0;
+        }
+
+        t += h;
+        y.swap(y_new);
+        std::swap(stepper.k(0), stepper.k(DormandPrince54Tableau::kStages-1));
+        double factor = MAX_FACTOR;
+        if (norm > 0)
+        {
+            factor = SAFETY*pow(norm, -ALPHA)*pow(err_prev, BETA);
+            factor = std::min(MAX_FACTOR, std::max(MIN_FACTOR, factor));
+        }
+        if (rejected)
+        {
+            factor = std::min(1.0, factor);
+        }
+        h *= factor;
+        err_prev = std::max(norm, 1e-4);
+        rejected = false;
+    }
+    return 1;
+}
+
+PeriodicOrbitFinder::PeriodicOrbitFinder(double mu)
+    : mu_(mu)
+{
+}
+
+void PeriodicOrbitFinder::SetTolerance(double tol)
+{
+    tol_ = tol;
+}
+
+void PeriodicOrbitFinder::SetIntegrationTolerance(double tol)
+{
+    integration_tol_ = tol;
+}
+
+double PeriodicOrbitFinder::mass_ratio() const
+{
+    return mu_;
+}
+
+double PeriodicOrbitFinder::LagrangePoint(int point) const
+{
+    double hill = cbrt(mu_/3);
+    double x = point == 1 ? 1 - mu_ - hill : (point == 2 ? 1 - mu_ + hill : -1 - 5*mu_/12);
+    for (int i=0; i<50; i++)
+    {
+        double d1 = x + mu_;
+        double d2 = x - 1 + mu_;
+        double r1_3 = std::abs(d1*d1*d1);
+        double r2_3 = std::abs(d2*d2*d2);
+        double g = x - (1 - mu_)*d1/r1_3 - mu_*d2/r2_3;
+        double dg = 1 + 2*(1 - mu_)/r1_3 + 2*mu_/r2_3;
+        double step = g/dg;
+        x -= step;
+        if (std::abs(step) < 1e-15) break;
+    }
+    return x;
+}
+
+double PeriodicOrbitFinder::JacobiConstant(const Vector6d& x) const
+{
+    double r1 = sqrt((x(0) + mu_)*(x(0) + mu_) + x(1)*x(1) + x(2)*x(2));
+    double r2 = sqrt((x(0) - 1 + mu_)*(x(0) - 1 + mu_) + x(1)*x(1) + x(2)*x(2));
+    return x(0)*x(0) + x(1)*x(1) + 2*(1 - mu_)/r1 + 2*mu_/r2 - x.tail<3>().squaredNorm();
+}
+
+PeriodicOrbitFinder::Orbit PeriodicOrbitFinder::LyapunovGuess(int point, double ax) const
+{
+    // xi = -ax cos(nu t), eta = k ax sin(nu t) about the point
+    double xL = LagrangePoint(point);
+    double c2 = (1 - mu_)/std::abs(pow(xL + mu_, 3)) + mu_/std::abs(pow(xL - 1 + mu_, 3));
+    double nu = sqrt(0.5*(2 - c2 + sqrt(9*c2*c2 - 8*c2)));
+    double k = (nu*nu + 1 + 2*c2)/(2*nu);
+    Orbit orbit;
+    orbit.state << xL - ax, 0, 0, 0, k*ax*nu, 0;
+    return orbit;
+}
+
+PeriodicOrbitFinder::Orbit PeriodicOrbitFinder::DroGuess(double distance) const
+{
+    // retrograde about the second primary, plus the frame rotation
+    Orbit orbit;
+    orbit.state << 1 - mu_ - distance, 0, 0, 0, sqrt(mu_/distance) + distance, 0;
+    return orbit;
+}
+
+template <int D>
+int PeriodicOrbitFinder::CorrectSymmetric(Orbit& orbit, Parameter fixed)
+{
+    typedef Variational<D> V;
+    const int S = V::S;
+    typename V::State y, f;
+    double t = 0;
+    iterations_ = 0;
+    while (true)
+    {
+        if (HalfPeriod<D>(mu_, integration_tol_, orbit.state, y, f, t, steps_))
+        {
+            return 1;
+        }
+        Eigen::Map<const typename V::Matrix> Phi(&y[S]);
+        double vy = y[D+1];
+        if (D == 2)
+        {
+            // vx by vy0
+            double vx = y[2];
+            if (std::abs(vx) < tol_) break;
+            if (iterations_ == MAX_ITER) return 1;
+            double d = Phi(2, 3) - f[2]*Phi(1, 3)/vy;
+            orbit.state(4) -= vx/d;
+        }
+        else
+        {
+            // [vx, vz] by vy0 and x0 or z0
+            Eigen::Vector2d g(y[3], y[5]);
+            if (g.lpNorm<Eigen::Infinity>() < tol_) break;
+            if (iterations_ == MAX_ITER) return 1;
+            const int vary[2] = {fixed == Z0 ? 0 : 2, 4};
+            Eigen::Matrix2d J;
+            for (int c=0; c<2; c++)
+            {
+                J(0, c) = Phi(3, vary[c]) - f[3]*Phi(1, vary[c])/vy;
+                J(1, c) = Phi(5, vary[c]) - f[5]*Phi(1, vary[c])/vy;
+            }
+            Eigen::Vector2d delta = J.partialPivLu().solve(g);
+            orbit.state(vary[0]) -= delta(0);
+            orbit.state(vary[1]) -= delta(1);
+        }
+        if (!(orbit.state.allFinite()))
+        {
+            return 1;
+        }
+        iterations_++;
+    }
+
+    // monodromy G Phi^-1 G Phi of the symmetric orbit from half a period,
+    // G the reflection y, vx, vz -> -y, -vx, -vz
+    typename V::Matrix Phi = Eigen::Map<const typename V::Matrix>(&y[S]);
+    typename V::Matrix G = V::Matrix::Identity();
+    G(1, 1) = -1;
+    G(D, D) = -1;
+    if (D == 3)
+    {
+        G(5, 5) = -1;
+    }
+    typename V::Matrix M = G*Phi.inverse()*G*Phi;
+    Eigen::EigenSolver<typename V::Matrix> eigen(M, false);
+    orbit.stability = 1;
+    for (int i=0; i<S; i++)
+    {
+        double lambda = std::abs(eigen.eigenvalues()(i));
+        orbit.stability = std::max(orbit.stability, 0.5*(lambda + 1/lambda));
+    }
+    if (D == 2)
+    {
+        // half trace of R Z^-1 R Z with R = diag(1, -1)
+        Eigen::Map<const Eigen::Matrix2d> Z(&y[S+S*S]);
+        orbit.vertical_stability = Z(0, 0)*Z(1, 1) + Z(0, 1)*Z(1, 0);
+    }
+    else
+    {
+        orbit.vertical_stability = 0;
+    }
+    orbit.period = 2*t;
+    orbit.jacobi = JacobiConstant(orbit.state);
+    return 0;
+}
+
+int PeriodicOrbitFinder::Correct(Orbit& orbit, Parameter fixed)
+{
+    if (orbit.planar)
+    {
+        orbit.state(2) = 0;
+        orbit.state(5) = 0;
+        return CorrectSymmetric<2>(orbit, X0);
+    }
+    return CorrectSymmetric<3>(orbit, fixed);
+}
+
+int PeriodicOrbitFinder::Continue(const Orbit& first, Parameter fixed, double step, int count, std::vector<Orbit>& family)
+{
+    Orbit orbit = first;
+    if (Correct(orbit, fixed))
+    {
+        return 1;
+    }
+    const unsigned int start = family.size();
+    family.push_back(orbit);
+    const int index = fixed == X0 ? 0 : 2;
+    double h = step;
+    while (static_cast<int>(family.size() - start) < count)
+    {
+        // secant predictor through the last two orbits
+        Orbit next = family.back();
+        if (family.size() - start >= 2)
+        {
+            const Vector6d& last = family.back().state;
+            const Vector6d& prev = family[family.size()-2].state;
+            next.state = last + (last - prev)*(h/(last(index) - prev(index)));
+        }
+        else
+        {
+            next.state(index) += h;
+        }
+        if (Correct(next, fixed))
+        {
+            h /= 2;
+            if (std::abs(h) < std::abs(step)/64)
+            {
+                return 1;
+            }
+            continue;
+        }
+        family.push_back(next);
+        h = std::abs(2*h) < std::abs(step) ? 2*h : step;
+    }
+    return 0;
+}
+
+int PeriodicOrbitFinder::HaloFromBifurcation(const std::vector<Orbit>& lyapunov, double z0, Orbit& halo)
+{
+    for (unsigned int i=0; i+1<lyapunov.size(); i++)
+    {
+        Orbit a = lyapunov[i];
+        Orbit b = lyapunov[i+1];
+        double ga = a.vertical_stability - 1;
+        double gb = b.vertical_stability - 1;
+        if (ga*gb > 0)
+        {
+            continue;
+        }
+        // secant steps in x0 between the two orbits
+        Orbit orbit = a;
+        for (int k=0; k<20 && ga != gb; k++)
+        {
+            double s = ga/(ga - gb);
+            orbit.state = a.state + s*(b.state - a.state);
+            if (Correct(orbit, X0))
+            {
+                return 1;
+            }
+            double g = orbit.vertical_stability - 1;
+            if (std::abs(g) < 1e-10) break;
+            if (g*ga > 0)
+            {
+                a = orbit;
+                ga = g;
+            }
+            else
+            {
+                b = orbit;
+                gb = g;
+            }
+        }
+        halo = orbit;
+        halo.planar = false;
+        halo.state(2) = z0;
+        return Correct(halo, Z0);
+    }
+    return 1;
+}
+
+int PeriodicOrbitFinder::iterations() const
+{
+    return iterations_;
+}
+
+long PeriodicOrbitFinder::steps() const
+{
+    return steps_;
+}
@@ -0,0 +1,109 @@
+#ifndef PERIODICORBITFINDER_H
+#define PERIODICORBITFINDER_H
+
+#include <vector>
+#include "Eigen/Dense"
+
+/* Periodic orbits of the circular restricted three body problem that are
+ * symmetric about the xz plane: planar Lyapunov orbits about L1, L2, L3,
+ * distant retrograde orbits (DRO) about the smaller primary and halo orbits
+ * (Howell 1984).  Units are the distance and the mean motion of the
+ * primaries, which sit at (-mu, 0, 0) and (1 - mu, 0, 0) in the rotating
+ * frame.  Such an orbit starts perpendicular on y = 0,
+ *   x0 = [x, 0, z, 0, vy, 0],
+ * and crosses y = 0 perpendicular again after half the period, so the
+ * differential correction only needs the state transition matrix over half
+ * an orbit.  At the crossing
+ *   d[vx, vz] = (Phi_{vx vz, free} - [ax, az] Phi_{y, free}/vy) d free
+ * with the free components vy and one of x or z (halo), the other is the
+ * parameter of the family.
+ *
+ * Planar orbits are propagated with the 4 component state and its 4x4
+ * transition matrix, together with the 2x2 one of the out of plane motion
+ * that decouples from it, halo orbits with the 6 component state and its
+ * 6x6 matrix.  Both are fixed size, integrated by the 5th order
+ * Dormand-Prince pair with step size control on the whole system, so nothing
+ * is allocated while propagating.  The crossing is refined by Newton steps on
+ * y from the last step before it.
+ *
+ * Families are traced by natural parameter continuation in x0 or z0 with a
+ * secant predictor, halving the step when the correction fails.  Halo orbits
+ * branch off the Lyapunov family where its vertical stability index, the
+ * half trace of the out of plane monodromy, passes through 1.
+ */
+class PeriodicOrbitFinder
+{
+public:
+    // unaligned, so that orbits can be kept in a std::vector
+    typedef Eigen::Matrix<double, 6, 1, Eigen::DontAlign> Vector6d;
+
+    enum Parameter { X0, Z0 };
+
+    struct Orbit
+    {
+        // [x, y, z, vx, vy, vz] on y = 0
+        Vector6d state;
+        double period = 0;
+        double jacobi = 0;
+        // largest stability index (|lambda| + 1/|lambda|)/2 over the
+        // eigenvalues of the monodromy matrix (of the planar motion for a
+        // planar orbit), 1 for a linearly stable orbit
+        double stability = 0;
+        // half trace of the out of plane monodromy of a planar orbit, halo
+        // orbits branch off where it is 1
+        double vertical_stability = 0;
+        bool planar = true;
+    };
+
+private:
+    double mu_;
+    double tol_ = 1e-10;
+    double integration_tol_ = 1e-12;
+    int iterations_ = 0;
+    long steps_ = 0;
+
+    static const int MAX_ITER = 20;
+
+    // Newton's method on the planar (D = 2) or spatial (D = 3) orbit
+    template <int D>
+    int CorrectSymmetric(Orbit& orbit, Parameter fixed);
+public:
+    // mass ratio m2/(m1 + m2) of the primaries
+    PeriodicOrbitFinder(double mu);
+
+    // largest velocity error [vx, vz] at the half period crossing
+    void SetTolerance(double tol);
+    // relative and absolute tolerance of the propagation
+    void SetIntegrationTolerance(double tol);
+
+    double mass_ratio() const;
+    // x of the collinear Lagrange point 1, 2 or 3
+    double LagrangePoint(int point) const;
+    double JacobiConstant(const Vector6d& x) const;
+
+    // planar Lyapunov orbit of the linearization about the collinear point
+    // with x amplitude ax
+    Orbit LyapunovGuess(int point, double ax) const;
+    // retrograde circular orbit of radius distance about the second primary,
+    // starting on the side of the first
+    Orbit DroGuess(double distance) const;
+
+    // corrects the initial state of orbit keeping the fixed component (Z0 for
+    // a halo orbit, X0 only for planar ones) and sets its period and
+    // stability, returns 1 if Newton's method did not converge
+    int Correct(Orbit& orbit, Parameter fixed = X0);
+    // traces the family from the corrected orbit in steps of the fixed
+    // component, appending up to count orbits (the first one included), returns
+    // 1 if the family ended before
+    int Continue(const Orbit& first, Parameter fixed, double step, int count, std::vector<Orbit>& family);
+    // halo orbit with out of plane amplitude z0 from the vertical bifurcation
+    // between two neighbouring orbits of a Lyapunov family, returns 1 if there
+    // is none or the correction failed
+    int HaloFromBifurcation(const std::vector<Orbit>& lyapunov, double z0, Orbit& halo);
+
+    // Newton iterations of the last correction and integration steps so far
+    int iterations() const;
+    long steps() const;
+};
+
+#endif // PERIODICORBITFINDER_H